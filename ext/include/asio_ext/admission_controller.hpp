@@ -0,0 +1,313 @@
+
+//          Copyright Andreas Wass 2004 - 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <utility>
+
+#include <asio/execution/connect.hpp>
+#include <asio/execution/set_done.hpp>
+#include <asio/execution/set_error.hpp>
+#include <asio/execution/set_value.hpp>
+#include <asio/execution/start.hpp>
+
+#include <asio_ext/detail/optional.hpp>
+#include <asio_ext/sender_traits.hpp>
+#include <asio_ext/type_traits.hpp>
+
+namespace asio_ext
+{
+    // CoDel style load shedding. Every admitted operation reports its sojourn time, from
+    // start to completion. Once sojourn times have stayed above target for a full
+    // interval the controller starts shedding: new operations are refused, except for
+    // a single probe whenever nothing admitted is in flight. The first operation that
+    // completes within target stops the shedding. Refusing work instead of queueing it
+    // keeps the delay of what is admitted near target + interval under overload.
+    // Only atomic counters are touched, there are no locks.
+    class admission_controller
+    {
+    public:
+        using clock = std::chrono::steady_clock;
+
+        explicit admission_controller(clock::duration target = std::chrono::milliseconds(5),
+            clock::duration interval = std::chrono::milliseconds(100)) noexcept
+            : target_(target), interval_(interval) {
+        }
+
+        admission_controller(const admission_controller&) = delete;
+        admission_controller& operator=(const admission_controller&) = delete;
+
+        // Returns true if an operation may start, it then has to report to complete().
+        bool try_admit() noexcept {
+            if (!shedding_.load(std::memory_order_relaxed)) {
+                in_flight_.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+            std::size_t idle = 0;
+            if (in_flight_.compare_exchange_strong(idle, 1, std::memory_order_relaxed)) {
+                return true;
+            }
+            shed_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        void complete(clock::time_point started) noexcept {
+            auto now = clock::now();
+            in_flight_.fetch_sub(1, std::memory_order_relaxed);
+            if (now - started < target_) {
+                above_since_.store(0, std::memory_order_relaxed);
+                shedding_.store(false, std::memory_order_relaxed);
+                return;
+            }
+            auto ticks = now.time_since_epoch().count();
+            clock::rep since = 0;
+            if (!above_since_.compare_exchange_strong(since, ticks, std::memory_order_relaxed) &&
+                clock::duration(ticks - since) >= interval_) {
+                shedding_.store(true, std::memory_order_relaxed);
+            }
+        }
+
+        bool shedding() const noexcept {
+            return shedding_.load(std::memory_order_relaxed);
+        }
+
+        std::size_t in_flight() const noexcept {
+            return in_flight_.load(std::memory_order_relaxed);
+        }
+
+        // Operations refused so far
+        std::uint64_t shed() const noexcept {
+            return shed_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        clock::duration target_;
+        clock::duration interval_;
+        // When sojourn times went above target, 0 while they are below
+        std::atomic<clock::rep> above_since_{ 0 };
+        std::atomic<bool> shedding_{ false };
+        std::atomic<std::size_t> in_flight_{ 0 };
+        std::atomic<std::uint64_t> shed_{ 0 };
+    };
+
+    namespace admit
+    {
+        namespace detail
+        {
+            template <class Sender, class Receiver>
+            struct operation;
+
+            template <class Sender, class Receiver>
+            struct receiver
+            {
+                operation<Sender, Receiver>* op_;
+
+                // Reported before completing, the controller may be gone after that
+                template <class... Values>
+                void set_value(Values&&... values) {
+                    op_->report();
+                    asio::execution::set_value(std::move(op_->receiver_), std::forward<Values>(values)...);
+                }
+
+                template <class E>
+                void set_error(E&& e) noexcept {
+                    op_->report();
+                    asio::execution::set_error(std::move(op_->receiver_), std::forward<E>(e));
+                }
+
+                void set_done() noexcept {
+                    op_->report();
+                    asio::execution::set_done(std::move(op_->receiver_));
+                }
+            };
+
+            template <class Sender, class Receiver>
+            struct operation
+            {
+                using next_operation_state = asio::execution::connect_result_t<Sender, receiver<Sender, Receiver>>;
+
+                admission_controller* controller_;
+                Sender sender_;
+                Receiver receiver_;
+                admission_controller::clock::time_point started_;
+                asio_ext::optional<next_operation_state> state_;
+                bool reported_ = false;
+
+                template <class Rx>
+                operation(admission_controller* controller, Sender&& sender, Rx&& rx)
+                    : controller_(controller), sender_(std::move(sender)), receiver_(std::forward<Rx>(rx)) {
+                }
+
+                void start() ASIO_NOEXCEPT {
+                    if (!controller_->try_admit()) {
+                        asio::execution::set_done(std::move(receiver_));
+                        return;
+                    }
+                    started_ = admission_controller::clock::now();
+                    try {
+                        auto& state = state_.emplace(asio::execution::connect(
+                            std::move(sender_), receiver<Sender, Receiver>{this}));
+                        asio::execution::start(state);
+                    }
+                    catch (...) {
+                        report();
+                        asio::execution::set_error(std::move(receiver_), std::current_exception());
+                    }
+                }
+
+                // Once only, a throwing set_value is followed by set_error
+                void report() noexcept {
+                    if (!std::exchange(reported_, true)) {
+                        controller_->complete(started_);
+                    }
+                }
+            };
+
+            template <class Sender>
+            struct sender
+            {
+                template <template <class...> class Tuple, template <class...> class Variant>
+                using value_types =
+                    typename asio::execution::sender_traits<Sender>::template value_types<Tuple, Variant>;
+
+                template <template <class...> class Variant>
+                using error_types = asio_ext::append_error_types<Variant, Sender, std::exception_ptr>;
+
+                static constexpr bool sends_done = true;
+
+                admission_controller* controller_;
+                Sender sender_;
+
+                template <class Receiver>
+                auto connect(Receiver&& recv) {
+                    return operation<Sender, asio_ext::remove_cvref_t<Receiver>>(
+                        controller_, std::move(sender_), std::forward<Receiver>(recv));
+                }
+            };
+        } // namespace detail
+
+        struct cpo
+        {
+            // Connects and starts sender if controller admits it, otherwise completes with
+            // set_done right away. The time until sender completes is reported back.
+            template <class Sender>
+            auto operator()(admission_controller& controller, Sender&& sender) const {
+                return detail::sender<asio_ext::remove_cvref_t<Sender>>{&controller, std::forward<Sender>(sender)};
+            }
+        };
+
+        template <typename T = cpo>
+        struct static_instance
+        {
+            static const T instance;
+        };
+
+        template <typename T>
+        const T static_instance<T>::instance = {};
+    }
+} // namespace asio_ext
+
+namespace asio {
+namespace execution {
+static ASIO_CONSTEXPR const asio_ext::admit::cpo&
+      admit = asio_ext::admit::static_instance<>::instance;
+} // namespace execution
+} // namespace asio
+
+#if !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Sender, class Receiver>
+struct start_member<asio_ext::admit::detail::operation<Sender, Receiver>>
+{
+    ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+    ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+    typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+#endif // !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Sender, typename Receiver>
+struct connect_member<asio_ext::admit::detail::sender<Sender>, Receiver>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef typename asio_ext::admit::detail::operation<
+      Sender, asio_ext::remove_cvref_t<Receiver>> result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_VALUE_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Sender, class Receiver, class... Values>
+struct set_value_member<asio_ext::admit::detail::receiver<Sender, Receiver>, void(Values...)>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_VALUE_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_ERROR_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Sender, class Receiver, class E>
+struct set_error_member<asio_ext::admit::detail::receiver<Sender, Receiver>, E>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_ERROR_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_DONE_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Sender, class Receiver>
+struct set_done_member<asio_ext::admit::detail::receiver<Sender, Receiver>>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_DONE_MEMBER_TRAIT)
@@ -0,0 +1,592 @@
+
+//          Copyright Andreas Wass 2004 - 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include <asio/execution/connect.hpp>
+#include <asio/execution/set_done.hpp>
+#include <asio/execution/set_error.hpp>
+#include <asio/execution/set_value.hpp>
+#include <asio/execution/start.hpp>
+
+#include <asio_ext/detail/optional.hpp>
+#include <asio_ext/detail/waiter_list.hpp>
+#include <asio_ext/type_traits.hpp>
+
+namespace asio_ext
+{
+    namespace async_cache_detail
+    {
+        using asio_ext::detail::waiter_base;
+
+        struct done_tag
+        {};
+
+        // One in-flight load, shared by every get() of its key. Works like split's shared
+        // state but with the loader type erased so all loads of a cache fit one map.
+        template <class Value>
+        struct flight
+        {
+            asio_ext::detail::waiter_list waiters_;
+            std::variant<std::monostate, Value, std::exception_ptr, done_tag> result_;
+            std::shared_ptr<flight> self_;
+            void (*start_)(flight*) noexcept = nullptr;
+            // Moves the result into the cache before the waiters run
+            void (*loaded_)(flight*) noexcept = nullptr;
+            void* cache_ = nullptr;
+            std::size_t hash_ = 0;
+
+            void attach(waiter_base* waiter) noexcept {
+                waiters_.attach(waiter);
+            }
+
+            template <class Store>
+            void complete(Store&& store) noexcept {
+                auto keep_alive = std::move(self_);
+                store();
+                loaded_(this);
+                waiters_.notify_all();
+            }
+
+            template <class Receiver>
+            void deliver(Receiver& receiver) noexcept {
+                if (auto* value = std::get_if<1>(&result_)) {
+                    try {
+                        asio::execution::set_value(std::move(receiver), static_cast<const Value&>(*value));
+                    }
+                    catch (...) {
+                        asio::execution::set_error(std::move(receiver), std::current_exception());
+                    }
+                }
+                else if (auto* error = std::get_if<2>(&result_)) {
+                    asio::execution::set_error(std::move(receiver), *error);
+                }
+                else {
+                    asio::execution::set_done(std::move(receiver));
+                }
+            }
+        };
+
+        template <class Value, class Sender>
+        struct typed_flight;
+
+        template <class Value, class Sender>
+        struct loader_receiver
+        {
+            typed_flight<Value, Sender>* flight_;
+
+            template <class... Values>
+            void set_value(Values&&... values) {
+                flight_->complete([&]() {
+                    try {
+                        flight_->result_.template emplace<1>(std::forward<Values>(values)...);
+                    }
+                    catch (...) {
+                        flight_->result_.template emplace<2>(std::current_exception());
+                    }
+                });
+            }
+
+            template <class E>
+            void set_error(E&& e) noexcept {
+                flight_->complete([&]() {
+                    if constexpr (std::is_same_v<asio_ext::remove_cvref_t<E>, std::exception_ptr>) {
+                        flight_->result_.template emplace<2>(std::forward<E>(e));
+                    }
+                    else {
+                        flight_->result_.template emplace<2>(std::make_exception_ptr(std::forward<E>(e)));
+                    }
+                });
+            }
+
+            void set_done() noexcept {
+                flight_->complete([&]() {
+                    flight_->result_.template emplace<3>();
+                });
+            }
+        };
+
+        template <class Value, class Sender>
+        struct typed_flight : flight<Value>
+        {
+            using loader_operation_type = asio::execution::connect_result_t<Sender, loader_receiver<Value, Sender>>;
+
+            Sender sender_;
+            asio_ext::optional<loader_operation_type> loader_;
+
+            template <class S>
+            explicit typed_flight(S&& sender) : sender_(std::forward<S>(sender)) {
+                this->start_ = &typed_flight::start;
+            }
+
+            static void start(flight<Value>* base) noexcept {
+                auto* self = static_cast<typed_flight*>(base);
+                try {
+                    self->loader_.emplace(
+                        asio::execution::connect(std::move(self->sender_), loader_receiver<Value, Sender>{self}));
+                    asio::execution::start(*self->loader_);
+                }
+                catch (...) {
+                    self->complete([&]() {
+                        self->result_.template emplace<2>(std::current_exception());
+                    });
+                }
+            }
+        };
+
+        template <class Cache, class Factory, class Receiver>
+        struct operation : waiter_base
+        {
+            using key_type = typename Cache::key_type;
+            using value_type = typename Cache::value_type;
+
+            Cache* cache_;
+            key_type key_;
+            Factory factory_;
+            Receiver receiver_;
+            std::shared_ptr<flight<value_type>> flight_;
+
+            template <class Rx>
+            operation(Cache* cache, key_type&& key, Factory&& factory, Rx&& rx)
+                : cache_(cache), key_(std::move(key)), factory_(std::move(factory)), receiver_(std::forward<Rx>(rx)) {
+            }
+
+            void start() ASIO_NOEXCEPT {
+                notify_ = &operation::notify;
+                try {
+                    asio_ext::optional<value_type> hit;
+                    auto hash = cache_->hash(key_);
+                    if (cache_->lookup(key_, hash, hit, flight_)) {
+                        return complete_found(hit);
+                    }
+                    // Build the load outside the shard lock, then check nobody beat us to it
+                    using loader_type = asio_ext::remove_cvref_t<decltype(factory_())>;
+                    std::shared_ptr<flight<value_type>> candidate =
+                        std::make_shared<typed_flight<value_type, loader_type>>(factory_());
+                    if (cache_->insert_or_lookup(key_, hash, candidate, hit, flight_)) {
+                        return complete_found(hit);
+                    }
+                    flight_->attach(this);
+                    if (flight_ == candidate) {
+                        candidate->self_ = candidate;
+                        candidate->start_(candidate.get());
+                    }
+                }
+                catch (...) {
+                    asio::execution::set_error(std::move(receiver_), std::current_exception());
+                }
+            }
+
+            // Either serves the loaded value inline or joins the load in flight
+            void complete_found(asio_ext::optional<value_type>& hit) {
+                if (hit) {
+                    asio::execution::set_value(std::move(receiver_), std::move(*hit));
+                }
+                else {
+                    flight_->attach(this);
+                }
+            }
+
+            static void notify(waiter_base* waiter) noexcept {
+                auto* self = static_cast<operation*>(waiter);
+                self->flight_->deliver(self->receiver_);
+            }
+        };
+
+        template <class Cache, class Factory>
+        struct sender
+        {
+            template <template <class...> class Tuple, template <class...> class Variant>
+            using value_types = Variant<Tuple<typename Cache::value_type>>;
+            template <template <class...> class Variant>
+            using error_types = Variant<std::exception_ptr>;
+            static constexpr bool sends_done = true;
+
+            Cache* cache_;
+            typename Cache::key_type key_;
+            Factory factory_;
+
+            template <class Receiver>
+            auto connect(Receiver&& recv) {
+                return operation<Cache, Factory, asio_ext::remove_cvref_t<Receiver>>(
+                    cache_, std::move(key_), std::move(factory_), std::forward<Receiver>(recv));
+            }
+        };
+    } // namespace async_cache_detail
+
+    // Single-flight cache. get(key, factory) completes with the cached value inline when
+    // there is one. Otherwise every concurrent get of the key shares one load started
+    // from factory(), which must return a sender of something Value is constructible
+    // from. Failed loads are not cached.
+    //
+    // Keys are spread over independently locked shards, each an open addressing table
+    // with linear probing. Full shards evict with the CLOCK policy, entries still
+    // loading are never evicted. The cache must outlive its loads.
+    template <class Key, class Value, class Hash = std::hash<Key>, class KeyEqual = std::equal_to<Key>>
+    class async_cache
+    {
+    public:
+        using key_type = Key;
+        using value_type = Value;
+
+        explicit async_cache(std::size_t capacity, std::size_t shard_count = 16) {
+            std::size_t shards = 1;
+            while (shards < shard_count) {
+                shards <<= 1;
+            }
+            shard_mask_ = shards - 1;
+            shards_ = std::make_unique<shard[]>(shards);
+            std::size_t shard_capacity = (capacity + shards - 1) / shards;
+            for (std::size_t i = 0; i < shards; ++i) {
+                shards_[i].capacity_ = shard_capacity > 0 ? shard_capacity : 1;
+                shards_[i].slots_.resize(table_size_for(shards_[i].capacity_));
+            }
+        }
+
+        async_cache(const async_cache&) = delete;
+        async_cache& operator=(const async_cache&) = delete;
+
+        template <class Factory>
+        async_cache_detail::sender<async_cache, asio_ext::remove_cvref_t<Factory>> get(Key key, Factory&& factory) {
+            return {this, std::move(key), std::forward<Factory>(factory)};
+        }
+
+        // Drops a loaded value, a load in flight is left alone
+        void erase(const Key& key) {
+            auto h = hash(key);
+            auto& s = shard_for(h);
+            std::lock_guard<std::mutex> lock(s.mutex_);
+            if (auto* found = find(s, key, h); found && !found->flight_) {
+                remove(s, *found);
+            }
+        }
+
+        // Entries including loads in flight
+        std::size_t size() const {
+            std::size_t total = 0;
+            for (std::size_t i = 0; i <= shard_mask_; ++i) {
+                std::lock_guard<std::mutex> lock(shards_[i].mutex_);
+                total += shards_[i].size_;
+            }
+            return total;
+        }
+
+        std::size_t hash(const Key& key) const {
+            return hash_(key);
+        }
+
+        // Used by get(). Finds either the loaded value or the load in flight.
+        bool lookup(const Key& key, std::size_t h, asio_ext::optional<Value>& hit,
+            std::shared_ptr<async_cache_detail::flight<Value>>& in_flight) {
+            auto& s = shard_for(h);
+            std::lock_guard<std::mutex> lock(s.mutex_);
+            return lookup_locked(s, key, h, hit, in_flight);
+        }
+
+        // Used by get(). Same as lookup() but on a miss candidate becomes the load of key.
+        bool insert_or_lookup(const Key& key, std::size_t h,
+            const std::shared_ptr<async_cache_detail::flight<Value>>& candidate, asio_ext::optional<Value>& hit,
+            std::shared_ptr<async_cache_detail::flight<Value>>& in_flight) {
+            auto& s = shard_for(h);
+            std::lock_guard<std::mutex> lock(s.mutex_);
+            if (lookup_locked(s, key, h, hit, in_flight)) {
+                return true;
+            }
+            candidate->cache_ = this;
+            candidate->hash_ = h;
+            candidate->loaded_ = &async_cache::on_loaded;
+            auto& inserted = insert(s, key, h);
+            inserted.flight_ = candidate;
+            in_flight = candidate;
+            return false;
+        }
+
+    private:
+        enum class slot_state : unsigned char
+        {
+            empty,
+            tombstone,
+            full
+        };
+
+        struct slot
+        {
+            slot_state state_ = slot_state::empty;
+            // CLOCK reference bit, set on every hit
+            bool referenced_ = false;
+            std::size_t hash_ = 0;
+            std::optional<Key> key_;
+            std::optional<Value> value_;
+            std::shared_ptr<async_cache_detail::flight<Value>> flight_;
+        };
+
+        struct shard
+        {
+            mutable std::mutex mutex_;
+            std::vector<slot> slots_;
+            std::size_t capacity_ = 0;
+            std::size_t size_ = 0;
+            std::size_t tombstones_ = 0;
+            std::size_t hand_ = 0;
+        };
+
+        static std::size_t table_size_for(std::size_t entries) {
+            std::size_t size = 4;
+            while (size < entries * 2) {
+                size <<= 1;
+            }
+            return size;
+        }
+
+        shard& shard_for(std::size_t h) {
+            return shards_[h & shard_mask_];
+        }
+
+        std::size_t probe_start(const shard& s, std::size_t h) const {
+            // The low bits picked the shard
+            std::size_t shard_bits = 0;
+            while ((std::size_t(1) << shard_bits) <= shard_mask_) {
+                ++shard_bits;
+            }
+            return (h >> shard_bits) & (s.slots_.size() - 1);
+        }
+
+        slot* find(shard& s, const Key& key, std::size_t h) {
+            auto mask = s.slots_.size() - 1;
+            for (auto i = probe_start(s, h);; i = (i + 1) & mask) {
+                auto& candidate = s.slots_[i];
+                if (candidate.state_ == slot_state::empty) {
+                    return nullptr;
+                }
+                if (candidate.state_ == slot_state::full && candidate.hash_ == h && equal_(*candidate.key_, key)) {
+                    return &candidate;
+                }
+            }
+        }
+
+        bool lookup_locked(shard& s, const Key& key, std::size_t h, asio_ext::optional<Value>& hit,
+            std::shared_ptr<async_cache_detail::flight<Value>>& in_flight) {
+            auto* found = find(s, key, h);
+            if (!found) {
+                return false;
+            }
+            if (found->value_) {
+                found->referenced_ = true;
+                hit.emplace(*found->value_);
+            }
+            else {
+                in_flight = found->flight_;
+            }
+            return true;
+        }
+
+        slot& insert(shard& s, const Key& key, std::size_t h) {
+            if (s.size_ >= s.capacity_) {
+                evict_one(s);
+            }
+            if ((s.size_ + 1) * 2 > s.slots_.size()) {
+                // Only loads in flight were left, make room for them
+                rehash(s, s.slots_.size() * 2);
+            }
+            else if ((s.size_ + s.tombstones_ + 1) * 4 > s.slots_.size() * 3) {
+                rehash(s, s.slots_.size());
+            }
+            auto mask = s.slots_.size() - 1;
+            auto i = probe_start(s, h);
+            while (s.slots_[i].state_ == slot_state::full) {
+                i = (i + 1) & mask;
+            }
+            auto& inserted = s.slots_[i];
+            if (inserted.state_ == slot_state::tombstone) {
+                --s.tombstones_;
+            }
+            inserted.state_ = slot_state::full;
+            inserted.referenced_ = true;
+            inserted.hash_ = h;
+            inserted.key_.emplace(key);
+            ++s.size_;
+            return inserted;
+        }
+
+        void remove(shard& s, slot& removed) {
+            removed.state_ = slot_state::tombstone;
+            removed.key_.reset();
+            removed.value_.reset();
+            removed.flight_.reset();
+            --s.size_;
+            ++s.tombstones_;
+        }
+
+        void evict_one(shard& s) {
+            auto mask = s.slots_.size() - 1;
+            // Two sweeps clear every reference bit once
+            for (std::size_t step = 0; step < s.slots_.size() * 2; ++step) {
+                auto& candidate = s.slots_[s.hand_];
+                s.hand_ = (s.hand_ + 1) & mask;
+                if (candidate.state_ != slot_state::full || candidate.flight_) {
+                    continue;
+                }
+                if (candidate.referenced_) {
+                    candidate.referenced_ = false;
+                    continue;
+                }
+                remove(s, candidate);
+                return;
+            }
+        }
+
+        void rehash(shard& s, std::size_t new_size) {
+            std::vector<slot> old(new_size);
+            old.swap(s.slots_);
+            s.tombstones_ = 0;
+            s.hand_ = 0;
+            auto mask = new_size - 1;
+            for (auto& moved : old) {
+                if (moved.state_ != slot_state::full) {
+                    continue;
+                }
+                auto i = probe_start(s, moved.hash_);
+                while (s.slots_[i].state_ == slot_state::full) {
+                    i = (i + 1) & mask;
+                }
+                s.slots_[i] = std::move(moved);
+            }
+        }
+
+        static void on_loaded(async_cache_detail::flight<Value>* loaded) noexcept {
+            auto* self = static_cast<async_cache*>(loaded->cache_);
+            auto& s = self->shard_for(loaded->hash_);
+            std::lock_guard<std::mutex> lock(s.mutex_);
+            auto mask = s.slots_.size() - 1;
+            for (auto i = self->probe_start(s, loaded->hash_); s.slots_[i].state_ != slot_state::empty;
+                 i = (i + 1) & mask) {
+                auto& candidate = s.slots_[i];
+                if (candidate.state_ != slot_state::full || candidate.flight_.get() != loaded) {
+                    continue;
+                }
+                if (auto* value = std::get_if<1>(&loaded->result_)) {
+                    try {
+                        candidate.value_.emplace(*value);
+                        candidate.flight_.reset();
+                        return;
+                    }
+                    catch (...) {
+                    }
+                }
+                // Failed loads are retried by the next get()
+                self->remove(s, candidate);
+                return;
+            }
+        }
+
+        std::unique_ptr<shard[]> shards_;
+        std::size_t shard_mask_ = 0;
+        Hash hash_;
+        KeyEqual equal_;
+    };
+} // namespace asio_ext
+
+#if !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Cache, class Factory, class Receiver>
+struct start_member<asio_ext::async_cache_detail::operation<Cache, Factory, Receiver>>
+{
+    ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+    ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+    typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+#endif // !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Cache, class Factory, typename Receiver>
+struct connect_member<asio_ext::async_cache_detail::sender<Cache, Factory>, Receiver>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef typename asio_ext::async_cache_detail::operation<
+      Cache, Factory, asio_ext::remove_cvref_t<Receiver>> result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_VALUE_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Value, class Sender, class... Values>
+struct set_value_member<asio_ext::async_cache_detail::loader_receiver<Value, Sender>, void(Values...)>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_VALUE_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_ERROR_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Value, class Sender, class E>
+struct set_error_member<asio_ext::async_cache_detail::loader_receiver<Value, Sender>, E>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_ERROR_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_DONE_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Value, class Sender>
+struct set_done_member<asio_ext::async_cache_detail::loader_receiver<Value, Sender>>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_DONE_MEMBER_TRAIT)
@@ -0,0 +1,353 @@
+
+//          Copyright Andreas Wass 2004 - 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+#include <asio/execution/set_done.hpp>
+#include <asio/execution/set_error.hpp>
+#include <asio/execution/set_value.hpp>
+
+#include <asio_ext/async_semaphore.hpp>
+#include <asio_ext/type_traits.hpp>
+
+namespace asio_ext
+{
+    // Owns a lock of an async_mutex or async_shared_mutex and releases it on destruction.
+    // Completed by the scoped_lock senders, keep it alive with let() for the critical section.
+    template <class Mutex, bool Shared = false>
+    class async_lock_guard
+    {
+    public:
+        explicit async_lock_guard(Mutex& mutex) noexcept : mutex_(&mutex) {}
+
+        async_lock_guard(async_lock_guard&& other) noexcept : mutex_(std::exchange(other.mutex_, nullptr)) {}
+
+        async_lock_guard& operator=(async_lock_guard&& other) noexcept {
+            if (this != &other) {
+                unlock();
+                mutex_ = std::exchange(other.mutex_, nullptr);
+            }
+            return *this;
+        }
+
+        ~async_lock_guard() {
+            unlock();
+        }
+
+        bool owns_lock() const noexcept {
+            return mutex_ != nullptr;
+        }
+
+        void unlock() noexcept {
+            if (auto* mutex = std::exchange(mutex_, nullptr)) {
+                if constexpr (Shared) {
+                    mutex->unlock_shared();
+                }
+                else {
+                    mutex->unlock();
+                }
+            }
+        }
+
+    private:
+        Mutex* mutex_;
+    };
+
+    namespace async_mutex_detail
+    {
+        struct waiter : async_semaphore_detail::waiter_base
+        {
+            bool shared_ = false;
+        };
+
+        template <class Mutex, bool Shared, bool Scoped, class Receiver>
+        struct lock_operation : waiter
+        {
+            Mutex* mutex_;
+            Receiver receiver_;
+
+            template <class Rx>
+            lock_operation(Mutex* mutex, Rx&& rx) : mutex_(mutex), receiver_(std::forward<Rx>(rx)) {}
+
+            void start() ASIO_NOEXCEPT {
+                grant_ = &lock_operation::grant;
+                shared_ = Shared;
+                mutex_->enqueue(this);
+            }
+
+            // Completes with set_done if the lock has not been handed over yet.
+            void cancel() {
+                if (mutex_->cancel(this)) {
+                    asio::execution::set_done(std::move(receiver_));
+                }
+            }
+
+            static void grant(async_semaphore_detail::waiter_base* base) noexcept {
+                auto* self = static_cast<lock_operation*>(base);
+                if constexpr (Scoped) {
+                    // The guard releases the lock if the receiver throws
+                    try {
+                        asio::execution::set_value(
+                            std::move(self->receiver_), async_lock_guard<Mutex, Shared>(*self->mutex_));
+                    }
+                    catch (...) {
+                        asio::execution::set_error(std::move(self->receiver_), std::current_exception());
+                    }
+                }
+                else {
+                    auto* mutex = self->mutex_;
+                    try {
+                        asio::execution::set_value(std::move(self->receiver_));
+                    }
+                    catch (...) {
+                        async_lock_guard<Mutex, Shared> release(*mutex);
+                        asio::execution::set_error(std::move(self->receiver_), std::current_exception());
+                    }
+                }
+            }
+        };
+
+        template <class Mutex, bool Shared, bool Scoped>
+        struct lock_sender
+        {
+            template <template <class...> class Tuple, template <class...> class Variant>
+            using value_types = std::conditional_t<Scoped, Variant<Tuple<async_lock_guard<Mutex, Shared>>>,
+                Variant<Tuple<>>>;
+            template <template <class...> class Variant>
+            using error_types = Variant<std::exception_ptr>;
+            static constexpr bool sends_done = true;
+
+            Mutex* mutex_;
+
+            template <class Receiver>
+            auto connect(Receiver&& recv) const {
+                return lock_operation<Mutex, Shared, Scoped, asio_ext::remove_cvref_t<Receiver>>(
+                    mutex_, std::forward<Receiver>(recv));
+            }
+        };
+    } // namespace async_mutex_detail
+
+    // Mutual exclusion for operations. lock() completes once the lock is handed over, the
+    // previous owner hands it directly to the oldest waiter on unlock() and completes it
+    // inline. Waiting never blocks a thread.
+    class async_mutex
+    {
+    public:
+        async_mutex() = default;
+        async_mutex(const async_mutex&) = delete;
+        async_mutex& operator=(const async_mutex&) = delete;
+
+        // Completes without values, the receiver owns the lock and must unlock() it
+        async_mutex_detail::lock_sender<async_mutex, false, false> lock() noexcept {
+            return {this};
+        }
+
+        // Completes with an async_lock_guard owning the lock
+        async_mutex_detail::lock_sender<async_mutex, false, true> scoped_lock() noexcept {
+            return {this};
+        }
+
+        bool try_lock() noexcept {
+            return permit_.try_acquire();
+        }
+
+        void unlock() noexcept {
+            permit_.release();
+        }
+
+        void enqueue(async_semaphore_detail::waiter_base* waiter) noexcept {
+            permit_.enqueue(waiter);
+        }
+
+        bool cancel(async_semaphore_detail::waiter_base* waiter) noexcept {
+            return permit_.cancel(waiter);
+        }
+
+    private:
+        // A single permit already gives FIFO handoff without barging
+        async_semaphore permit_{ 1 };
+    };
+
+    // Reader-writer lock for operations. Waiters are served in FIFO order, a queued writer
+    // holds back readers arriving after it so writers are never starved. Every run of
+    // readers at the front of the queue is granted together.
+    class async_shared_mutex
+    {
+    public:
+        async_shared_mutex() = default;
+        async_shared_mutex(const async_shared_mutex&) = delete;
+        async_shared_mutex& operator=(const async_shared_mutex&) = delete;
+
+        async_mutex_detail::lock_sender<async_shared_mutex, false, false> lock() noexcept {
+            return {this};
+        }
+
+        async_mutex_detail::lock_sender<async_shared_mutex, false, true> scoped_lock() noexcept {
+            return {this};
+        }
+
+        async_mutex_detail::lock_sender<async_shared_mutex, true, false> lock_shared() noexcept {
+            return {this};
+        }
+
+        async_mutex_detail::lock_sender<async_shared_mutex, true, true> scoped_lock_shared() noexcept {
+            return {this};
+        }
+
+        bool try_lock() noexcept {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return !head_ && try_acquire(false);
+        }
+
+        bool try_lock_shared() noexcept {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return !head_ && try_acquire(true);
+        }
+
+        void unlock() noexcept {
+            async_mutex_detail::waiter* granted;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                writer_ = false;
+                granted = pop_granted();
+            }
+            grant(granted);
+        }
+
+        void unlock_shared() noexcept {
+            async_mutex_detail::waiter* granted;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                --readers_;
+                granted = pop_granted();
+            }
+            grant(granted);
+        }
+
+        void enqueue(async_mutex_detail::waiter* waiter) noexcept {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (head_ || !try_acquire(waiter->shared_)) {
+                    waiter->next_ = nullptr;
+                    (tail_ ? tail_->next_ : head_) = waiter;
+                    tail_ = waiter;
+                    return;
+                }
+            }
+            waiter->grant_(waiter);
+        }
+
+        bool cancel(async_mutex_detail::waiter* waiter) noexcept {
+            async_mutex_detail::waiter* granted;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                async_semaphore_detail::waiter_base* previous = nullptr;
+                auto* current = head_;
+                for (; current && current != waiter; previous = current, current = current->next_) {
+                }
+                if (!current) {
+                    return false;
+                }
+                (previous ? previous->next_ : head_) = current->next_;
+                if (tail_ == current) {
+                    tail_ = previous;
+                }
+                // Readers queued behind a cancelled writer may be able to go now
+                granted = pop_granted();
+            }
+            grant(granted);
+            return true;
+        }
+
+    private:
+        bool try_acquire(bool shared) noexcept {
+            if (writer_ || (!shared && readers_ > 0)) {
+                return false;
+            }
+            if (shared) {
+                ++readers_;
+            }
+            else {
+                writer_ = true;
+            }
+            return true;
+        }
+
+        // Dequeues every waiter that can be granted now, linked through next_
+        async_mutex_detail::waiter* pop_granted() noexcept {
+            async_semaphore_detail::waiter_base* granted = nullptr;
+            async_semaphore_detail::waiter_base* granted_tail = nullptr;
+            while (head_ && try_acquire(static_cast<async_mutex_detail::waiter*>(head_)->shared_)) {
+                auto* waiter = head_;
+                head_ = waiter->next_;
+                waiter->next_ = nullptr;
+                (granted_tail ? granted_tail->next_ : granted) = waiter;
+                granted_tail = waiter;
+            }
+            if (!head_) {
+                tail_ = nullptr;
+            }
+            return static_cast<async_mutex_detail::waiter*>(granted);
+        }
+
+        static void grant(async_semaphore_detail::waiter_base* granted) noexcept {
+            while (granted) {
+                // Granting may destroy the waiter
+                auto* next = granted->next_;
+                granted->grant_(granted);
+                granted = next;
+            }
+        }
+
+        std::mutex mutex_;
+        std::size_t readers_ = 0;
+        bool writer_ = false;
+        async_semaphore_detail::waiter_base* head_ = nullptr;
+        async_semaphore_detail::waiter_base* tail_ = nullptr;
+    };
+} // namespace asio_ext
+
+#if !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Mutex, bool Shared, bool Scoped, class Receiver>
+struct start_member<asio_ext::async_mutex_detail::lock_operation<Mutex, Shared, Scoped, Receiver>>
+{
+    ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+    ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+    typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+#endif // !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Mutex, bool Shared, bool Scoped, typename Receiver>
+struct connect_member<asio_ext::async_mutex_detail::lock_sender<Mutex, Shared, Scoped>, Receiver>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef typename asio_ext::async_mutex_detail::lock_operation<
+      Mutex, Shared, Scoped, asio_ext::remove_cvref_t<Receiver>> result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
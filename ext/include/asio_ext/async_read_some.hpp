@@ -0,0 +1,131 @@
+
+//          Copyright Andreas Wass 2004 - 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <cstddef>
+#include <exception>
+#include <utility>
+
+#include <asio/error_code.hpp>
+#include <asio/execution/connect.hpp>
+#include <asio/execution/set_error.hpp>
+#include <asio/execution/start.hpp>
+
+#include <asio_ext/detail/complete_operation.hpp>
+#include <asio_ext/type_traits.hpp>
+
+namespace asio_ext
+{
+    namespace async_read_some
+    {
+        namespace detail
+        {
+            template <class Stream, class Buffers, class Receiver>
+            struct operation
+            {
+                Stream* stream_;
+                Buffers buffers_;
+                Receiver receiver_;
+
+                void start() ASIO_NOEXCEPT {
+                    try {
+                        stream_->async_read_some(buffers_,
+                            [this](const asio::error_code& ec, std::size_t bytes_transferred) {
+                                asio_ext::detail::complete_operation(
+                                    receiver_, ec, std::move(buffers_), bytes_transferred);
+                            });
+                    }
+                    catch (...) {
+                        asio::execution::set_error(std::move(receiver_), std::current_exception());
+                    }
+                }
+            };
+
+            template <class Stream, class Buffers>
+            struct sender
+            {
+                template <template <class...> class Tuple, template <class...> class Variant>
+                using value_types = Variant<Tuple<Buffers, std::size_t>>;
+                template <template <class...> class Variant>
+                using error_types = Variant<std::exception_ptr>;
+                static constexpr bool sends_done = true;
+
+                Stream* stream_;
+                Buffers buffers_;
+
+                template <class Receiver>
+                auto connect(Receiver&& recv) {
+                    return operation<Stream, Buffers, asio_ext::remove_cvref_t<Receiver>>{
+                        stream_, std::move(buffers_), std::forward<Receiver>(recv)};
+                }
+            };
+        } // namespace detail
+
+        struct cpo
+        {
+            // Reads into the MutableBufferSequence, completes with the sequence and the number
+            // of bytes read so the filled buffers (e.g. a slab_buffer) travel on downstream.
+            template <class Stream, class Buffers>
+            auto operator()(Stream& stream, Buffers&& buffers) const {
+                return detail::sender<Stream, asio_ext::remove_cvref_t<Buffers>>{
+                    &stream, std::forward<Buffers>(buffers)};
+            }
+        };
+
+        template <typename T = cpo>
+        struct static_instance
+        {
+            static const T instance;
+        };
+
+        template <typename T>
+        const T static_instance<T>::instance = {};
+    }
+} // namespace asio_ext
+
+namespace asio {
+namespace execution {
+static ASIO_CONSTEXPR const asio_ext::async_read_some::cpo&
+      async_read_some = asio_ext::async_read_some::static_instance<>::instance;
+} // namespace execution
+} // namespace asio
+
+#if !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Stream, class Buffers, class Receiver>
+struct start_member<asio_ext::async_read_some::detail::operation<Stream, Buffers, Receiver>>
+{
+    ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+    ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+    typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+#endif // !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Stream, class Buffers, typename Receiver>
+struct connect_member<asio_ext::async_read_some::detail::sender<Stream, Buffers>, Receiver>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef typename asio_ext::async_read_some::detail::operation<
+      Stream, Buffers, asio_ext::remove_cvref_t<Receiver>> result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
@@ -0,0 +1,447 @@
+
+//          Copyright Andreas Wass 2004 - 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include <asio/execution/connect.hpp>
+#include <asio/execution/set_done.hpp>
+#include <asio/execution/set_error.hpp>
+#include <asio/execution/set_value.hpp>
+#include <asio/execution/start.hpp>
+
+#include <asio_ext/detail/optional.hpp>
+#include <asio_ext/detail/waiter_list.hpp>
+#include <asio_ext/type_traits.hpp>
+
+namespace asio_ext
+{
+    class async_scope;
+
+    namespace async_scope_detail
+    {
+        template <class Op>
+        using cancel_t = decltype(std::declval<Op&>().cancel());
+
+        // Intrusive list node of one spawned operation
+        struct spawned_base
+        {
+            spawned_base* prev_ = nullptr;
+            spawned_base* next_ = nullptr;
+            // Held by the running operation and by request_stop() while it cancels
+            std::atomic<int> refs_{ 1 };
+            std::atomic_bool completed_{ false };
+            void (*cancel_)(spawned_base*) noexcept = nullptr;
+            void (*destroy_)(spawned_base*) noexcept = nullptr;
+        };
+
+        template <class Sender>
+        struct spawned;
+
+        template <class Sender>
+        struct spawn_receiver
+        {
+            spawned<Sender>* node_;
+
+            template <class... Values>
+            void set_value(Values&&...) noexcept {
+                node_->finish();
+            }
+
+            template <class E>
+            void set_error(E&&) noexcept {
+                // Nobody is left to observe the error
+                std::terminate();
+            }
+
+            void set_done() noexcept {
+                node_->finish();
+            }
+        };
+
+        template <class Sender>
+        struct spawned : spawned_base
+        {
+            using operation_type = asio::execution::connect_result_t<Sender, spawn_receiver<Sender>>;
+
+            async_scope* scope_;
+            asio_ext::optional<operation_type> op_;
+
+            explicit spawned(async_scope* scope) noexcept : scope_(scope) {
+                cancel_ = &spawned::cancel;
+                destroy_ = &spawned::destroy;
+            }
+
+            inline void finish() noexcept;
+
+            static void cancel(spawned_base* base) noexcept {
+                if constexpr (asio_ext::is_detected_v<cancel_t, operation_type>) {
+                    auto* self = static_cast<spawned*>(base);
+                    try {
+                        self->op_->cancel();
+                    }
+                    catch (...) {
+                    }
+                }
+            }
+
+            static inline void destroy(spawned_base* base) noexcept;
+        };
+
+        template <class Receiver>
+        struct empty_operation : asio_ext::detail::waiter_base
+        {
+            async_scope* scope_;
+            Receiver receiver_;
+
+            template <class Rx>
+            empty_operation(async_scope* scope, Rx&& rx) : scope_(scope), receiver_(std::forward<Rx>(rx)) {}
+
+            inline void start() ASIO_NOEXCEPT;
+
+            static void notify(asio_ext::detail::waiter_base* waiter) noexcept {
+                auto* self = static_cast<empty_operation*>(waiter);
+                try {
+                    asio::execution::set_value(std::move(self->receiver_));
+                }
+                catch (...) {
+                    asio::execution::set_error(std::move(self->receiver_), std::current_exception());
+                }
+            }
+        };
+
+        struct empty_sender
+        {
+            template <template <class...> class Tuple, template <class...> class Variant>
+            using value_types = Variant<Tuple<>>;
+            template <template <class...> class Variant>
+            using error_types = Variant<std::exception_ptr>;
+            static constexpr bool sends_done = false;
+
+            async_scope* scope_;
+
+            template <class Receiver>
+            auto connect(Receiver&& recv) const {
+                return empty_operation<asio_ext::remove_cvref_t<Receiver>>(scope_, std::forward<Receiver>(recv));
+            }
+        };
+    } // namespace async_scope_detail
+
+    // Tracks detached work so it can be stopped and awaited, e.g. on shutdown.
+    // spawn() starts a sender whose operation state lives in the scope's slab. Blocks are
+    // of one size and recycled, larger or over-aligned operation states fall back to
+    // operator new.
+    // request_stop() cancels every spawned operation offering cancel() and rejects later
+    // spawns, on_empty() completes once nothing spawned is running. An error from spawned
+    // work calls std::terminate. The scope must outlive everything it spawned.
+    class async_scope
+    {
+    public:
+        explicit async_scope(std::size_t block_size = 256, std::size_t blocks_per_chunk = 64)
+            : block_size_(round_up(block_size)), blocks_per_chunk_(blocks_per_chunk > 0 ? blocks_per_chunk : 1) {
+        }
+
+        async_scope(const async_scope&) = delete;
+        async_scope& operator=(const async_scope&) = delete;
+
+        // Returns false without starting sender if stop was requested
+        template <class Sender>
+        bool spawn(Sender&& sender) {
+            using node_type = async_scope_detail::spawned<asio_ext::remove_cvref_t<Sender>>;
+            if (stop_requested()) {
+                return false;
+            }
+            auto* node = new (allocate(sizeof(node_type), alignof(node_type))) node_type(this);
+            try {
+                node->op_.emplace(asio::execution::connect(std::forward<Sender>(sender),
+                    async_scope_detail::spawn_receiver<asio_ext::remove_cvref_t<Sender>>{node}));
+            }
+            catch (...) {
+                node->~node_type();
+                deallocate(node, sizeof(node_type), alignof(node_type));
+                throw;
+            }
+            bool linked = false;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!stop_requested()) {
+                    link(node);
+                    count_.fetch_add(1, std::memory_order_relaxed);
+                    linked = true;
+                }
+            }
+            if (!linked) {
+                // Lost the race against request_stop()
+                node_type::destroy(node);
+                return false;
+            }
+            asio::execution::start(*node->op_);
+            return true;
+        }
+
+        // Cancels spawned work. Must be called where cancel() of that work is safe to call,
+        // for timers that is the thread running their io_context.
+        void request_stop() {
+            std::vector<async_scope_detail::spawned_base*> running;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stop_requested_.store(true, std::memory_order_release);
+                for (auto* node = head_; node; node = node->next_) {
+                    node->refs_.fetch_add(1, std::memory_order_relaxed);
+                    running.push_back(node);
+                }
+            }
+            for (auto* node : running) {
+                if (!node->completed_.load(std::memory_order_acquire)) {
+                    node->cancel_(node);
+                }
+                release(node);
+            }
+        }
+
+        bool stop_requested() const noexcept {
+            return stop_requested_.load(std::memory_order_acquire);
+        }
+
+        // Spawned operations still running
+        std::size_t size() const noexcept {
+            return count_.load(std::memory_order_acquire);
+        }
+
+        async_scope_detail::empty_sender on_empty() noexcept {
+            return {this};
+        }
+
+        // Used by on_empty(). Returns false when the scope is empty already.
+        bool wait_empty(asio_ext::detail::waiter_base* waiter) noexcept {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (count_.load(std::memory_order_acquire) == 0) {
+                return false;
+            }
+            waiter->next_ = empty_waiters_;
+            empty_waiters_ = waiter;
+            return true;
+        }
+
+        // Used by spawned operations once they completed
+        void finish(async_scope_detail::spawned_base* node) noexcept {
+            node->completed_.store(true, std::memory_order_release);
+            asio_ext::detail::waiter_base* waiters = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                unlink(node);
+                if (count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    waiters = std::exchange(empty_waiters_, nullptr);
+                }
+            }
+            release(node);
+            asio_ext::detail::notify_in_order(waiters);
+        }
+
+        void* allocate(std::size_t size, std::size_t align) {
+            if (align > alignof(std::max_align_t)) {
+                return ::operator new(size, std::align_val_t(align));
+            }
+            if (size > block_size_) {
+                return ::operator new(size);
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!free_) {
+                auto chunk = std::make_unique<std::byte[]>(block_size_ * blocks_per_chunk_);
+                for (std::size_t i = 0; i < blocks_per_chunk_; ++i) {
+                    auto* block = reinterpret_cast<free_block*>(chunk.get() + i * block_size_);
+                    block->next_ = free_;
+                    free_ = block;
+                }
+                chunks_.push_back(std::move(chunk));
+            }
+            return std::exchange(free_, free_->next_);
+        }
+
+        void deallocate(void* p, std::size_t size, std::size_t align) noexcept {
+            if (align > alignof(std::max_align_t)) {
+                ::operator delete(p, std::align_val_t(align));
+                return;
+            }
+            if (size > block_size_) {
+                ::operator delete(p);
+                return;
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto* block = static_cast<free_block*>(p);
+            block->next_ = free_;
+            free_ = block;
+        }
+
+    private:
+        struct free_block
+        {
+            free_block* next_;
+        };
+
+        static std::size_t round_up(std::size_t size) noexcept {
+            constexpr auto align = alignof(std::max_align_t);
+            if (size < sizeof(free_block)) {
+                size = sizeof(free_block);
+            }
+            return (size + align - 1) / align * align;
+        }
+
+        void link(async_scope_detail::spawned_base* node) noexcept {
+            node->prev_ = nullptr;
+            node->next_ = head_;
+            if (head_) {
+                head_->prev_ = node;
+            }
+            head_ = node;
+        }
+
+        void unlink(async_scope_detail::spawned_base* node) noexcept {
+            (node->prev_ ? node->prev_->next_ : head_) = node->next_;
+            if (node->next_) {
+                node->next_->prev_ = node->prev_;
+            }
+        }
+
+        static void release(async_scope_detail::spawned_base* node) noexcept {
+            if (node->refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                node->destroy_(node);
+            }
+        }
+
+        std::size_t block_size_;
+        std::size_t blocks_per_chunk_;
+        std::atomic<std::size_t> count_{ 0 };
+        std::atomic_bool stop_requested_{ false };
+        std::mutex mutex_;
+        async_scope_detail::spawned_base* head_ = nullptr;
+        asio_ext::detail::waiter_base* empty_waiters_ = nullptr;
+        free_block* free_ = nullptr;
+        std::vector<std::unique_ptr<std::byte[]>> chunks_;
+    };
+
+    namespace async_scope_detail
+    {
+        template <class Sender>
+        void spawned<Sender>::finish() noexcept {
+            scope_->finish(this);
+        }
+
+        template <class Sender>
+        void spawned<Sender>::destroy(spawned_base* base) noexcept {
+            auto* self = static_cast<spawned*>(base);
+            auto* scope = self->scope_;
+            self->~spawned();
+            scope->deallocate(self, sizeof(spawned), alignof(spawned));
+        }
+
+        template <class Receiver>
+        void empty_operation<Receiver>::start() ASIO_NOEXCEPT {
+            notify_ = &empty_operation::notify;
+            if (!scope_->wait_empty(this)) {
+                notify(this);
+            }
+        }
+    } // namespace async_scope_detail
+} // namespace asio_ext
+
+#if !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Receiver>
+struct start_member<asio_ext::async_scope_detail::empty_operation<Receiver>>
+{
+    ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+    ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+    typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+#endif // !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <typename Receiver>
+struct connect_member<asio_ext::async_scope_detail::empty_sender, Receiver>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef typename asio_ext::async_scope_detail::empty_operation<
+      asio_ext::remove_cvref_t<Receiver>> result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_VALUE_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Sender, class... Values>
+struct set_value_member<asio_ext::async_scope_detail::spawn_receiver<Sender>, void(Values...)>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_VALUE_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_ERROR_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Sender, class E>
+struct set_error_member<asio_ext::async_scope_detail::spawn_receiver<Sender>, E>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_ERROR_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_DONE_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Sender>
+struct set_done_member<asio_ext::async_scope_detail::spawn_receiver<Sender>>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_DONE_MEMBER_TRAIT)
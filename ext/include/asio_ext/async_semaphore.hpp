@@ -0,0 +1,449 @@
+
+//          Copyright Andreas Wass 2004 - 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <utility>
+
+#include <asio/execution/connect.hpp>
+#include <asio/execution/set_done.hpp>
+#include <asio/execution/set_error.hpp>
+#include <asio/execution/set_value.hpp>
+#include <asio/execution/start.hpp>
+
+#include <asio_ext/detail/optional.hpp>
+#include <asio_ext/sender_traits.hpp>
+#include <asio_ext/type_traits.hpp>
+
+namespace asio_ext
+{
+    namespace async_semaphore_detail
+    {
+        // Intrusive queue node, lives in the operation state of whoever waits for a permit
+        struct waiter_base
+        {
+            waiter_base* next_ = nullptr;
+            void (*grant_)(waiter_base*) noexcept = nullptr;
+        };
+
+        template <class Receiver>
+        struct acquire_operation;
+
+        struct acquire_sender;
+    } // namespace async_semaphore_detail
+
+    // Counting semaphore for operations. acquire() completes once a permit is available,
+    // waiters are served in FIFO order and completed inline by the thread that releases.
+    // Taking an uncontended permit is a single compare-and-swap.
+    class async_semaphore
+    {
+    public:
+        explicit async_semaphore(std::ptrdiff_t permits) : count_(permits) {}
+
+        async_semaphore(const async_semaphore&) = delete;
+        async_semaphore& operator=(const async_semaphore&) = delete;
+
+        inline async_semaphore_detail::acquire_sender acquire() noexcept;
+
+        bool try_acquire() noexcept {
+            // Queued waiters go first
+            if (has_waiters_.load()) {
+                return false;
+            }
+            return take();
+        }
+
+        void release(std::ptrdiff_t permits = 1) noexcept {
+            count_.fetch_add(permits);
+            if (has_waiters_.load()) {
+                grant_waiters();
+            }
+        }
+
+        std::ptrdiff_t available() const noexcept {
+            return count_.load(std::memory_order_relaxed);
+        }
+
+        // Grants waiter a permit now or once one is released
+        void enqueue(async_semaphore_detail::waiter_base* waiter) noexcept {
+            if (try_acquire()) {
+                waiter->grant_(waiter);
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                waiter->next_ = nullptr;
+                if (tail_) {
+                    tail_->next_ = waiter;
+                }
+                else {
+                    head_ = waiter;
+                }
+                tail_ = waiter;
+                has_waiters_.store(true);
+            }
+            // A release may have happened before it could see has_waiters_
+            grant_waiters();
+        }
+
+        // Removes a waiter that has not been granted a permit yet
+        bool cancel(async_semaphore_detail::waiter_base* waiter) noexcept {
+            std::lock_guard<std::mutex> lock(mutex_);
+            async_semaphore_detail::waiter_base* previous = nullptr;
+            for (auto* current = head_; current; previous = current, current = current->next_) {
+                if (current != waiter) {
+                    continue;
+                }
+                (previous ? previous->next_ : head_) = current->next_;
+                if (tail_ == current) {
+                    tail_ = previous;
+                }
+                if (!head_) {
+                    has_waiters_.store(false);
+                }
+                return true;
+            }
+            return false;
+        }
+
+    private:
+        bool take() noexcept {
+            auto count = count_.load(std::memory_order_relaxed);
+            while (count > 0) {
+                if (count_.compare_exchange_weak(count, count - 1, std::memory_order_acquire)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void grant_waiters() noexcept {
+            async_semaphore_detail::waiter_base* granted = nullptr;
+            async_semaphore_detail::waiter_base* granted_tail = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                while (head_ && take()) {
+                    auto* waiter = head_;
+                    head_ = waiter->next_;
+                    waiter->next_ = nullptr;
+                    (granted_tail ? granted_tail->next_ : granted) = waiter;
+                    granted_tail = waiter;
+                }
+                if (!head_) {
+                    tail_ = nullptr;
+                    has_waiters_.store(false);
+                }
+            }
+            while (granted) {
+                // Granting may destroy the waiter
+                auto* next = granted->next_;
+                granted->grant_(granted);
+                granted = next;
+            }
+        }
+
+        std::atomic<std::ptrdiff_t> count_;
+        std::atomic_bool has_waiters_{ false };
+        std::mutex mutex_;
+        async_semaphore_detail::waiter_base* head_ = nullptr;
+        async_semaphore_detail::waiter_base* tail_ = nullptr;
+    };
+
+    namespace async_semaphore_detail
+    {
+        template <class Receiver>
+        struct acquire_operation : waiter_base
+        {
+            async_semaphore* semaphore_;
+            Receiver receiver_;
+
+            template <class Rx>
+            acquire_operation(async_semaphore* semaphore, Rx&& rx)
+                : semaphore_(semaphore), receiver_(std::forward<Rx>(rx)) {
+            }
+
+            void start() ASIO_NOEXCEPT {
+                grant_ = &acquire_operation::grant;
+                semaphore_->enqueue(this);
+            }
+
+            // Completes with set_done if the permit has not been granted yet.
+            void cancel() {
+                if (semaphore_->cancel(this)) {
+                    asio::execution::set_done(std::move(receiver_));
+                }
+            }
+
+            static void grant(waiter_base* waiter) noexcept {
+                auto* self = static_cast<acquire_operation*>(waiter);
+                auto* semaphore = self->semaphore_;
+                try {
+                    asio::execution::set_value(std::move(self->receiver_));
+                }
+                catch (...) {
+                    // Nobody will own the permit
+                    semaphore->release();
+                    asio::execution::set_error(std::move(self->receiver_), std::current_exception());
+                }
+            }
+        };
+
+        struct acquire_sender
+        {
+            template <template <class...> class Tuple, template <class...> class Variant>
+            using value_types = Variant<Tuple<>>;
+            template <template <class...> class Variant>
+            using error_types = Variant<std::exception_ptr>;
+            static constexpr bool sends_done = true;
+
+            async_semaphore* semaphore_;
+
+            template <class Receiver>
+            auto connect(Receiver&& recv) const {
+                return acquire_operation<asio_ext::remove_cvref_t<Receiver>>(
+                    semaphore_, std::forward<Receiver>(recv));
+            }
+        };
+    } // namespace async_semaphore_detail
+
+    // The permit is owned by whoever the sender completes to, they must release() it.
+    async_semaphore_detail::acquire_sender async_semaphore::acquire() noexcept {
+        return {this};
+    }
+
+    namespace with_permit
+    {
+        namespace detail
+        {
+            template <class Sender, class Receiver>
+            struct operation;
+
+            template <class Sender, class Receiver>
+            struct receiver
+            {
+                operation<Sender, Receiver>* op_;
+
+                // The permit is returned before completing, the semaphore may be gone after that
+                template <class... Values>
+                void set_value(Values&&... values) {
+                    op_->semaphore_->release();
+                    asio::execution::set_value(std::move(op_->receiver_), std::forward<Values>(values)...);
+                }
+
+                template <class E>
+                void set_error(E&& e) noexcept {
+                    op_->semaphore_->release();
+                    asio::execution::set_error(std::move(op_->receiver_), std::forward<E>(e));
+                }
+
+                void set_done() noexcept {
+                    op_->semaphore_->release();
+                    asio::execution::set_done(std::move(op_->receiver_));
+                }
+            };
+
+            template <class Sender, class Receiver>
+            struct operation : async_semaphore_detail::waiter_base
+            {
+                using next_operation_state = asio::execution::connect_result_t<Sender, receiver<Sender, Receiver>>;
+
+                async_semaphore* semaphore_;
+                Sender sender_;
+                Receiver receiver_;
+                asio_ext::optional<next_operation_state> state_;
+
+                template <class Rx>
+                operation(async_semaphore* semaphore, Sender&& sender, Rx&& rx)
+                    : semaphore_(semaphore), sender_(std::move(sender)), receiver_(std::forward<Rx>(rx)) {
+                }
+
+                void start() ASIO_NOEXCEPT {
+                    grant_ = &operation::grant;
+                    semaphore_->enqueue(this);
+                }
+
+                // Completes with set_done if the sender is still waiting for its permit.
+                void cancel() {
+                    if (semaphore_->cancel(this)) {
+                        asio::execution::set_done(std::move(receiver_));
+                    }
+                }
+
+                static void grant(async_semaphore_detail::waiter_base* waiter) noexcept {
+                    auto* self = static_cast<operation*>(waiter);
+                    try {
+                        auto& state = self->state_.emplace(asio::execution::connect(
+                            std::move(self->sender_), receiver<Sender, Receiver>{self}));
+                        asio::execution::start(state);
+                    }
+                    catch (...) {
+                        self->semaphore_->release();
+                        asio::execution::set_error(std::move(self->receiver_), std::current_exception());
+                    }
+                }
+            };
+
+            template <class Sender>
+            struct sender
+            {
+                template <template <class...> class Tuple, template <class...> class Variant>
+                using value_types =
+                    typename asio::execution::sender_traits<Sender>::template value_types<Tuple, Variant>;
+
+                template <template <class...> class Variant>
+                using error_types = asio_ext::append_error_types<Variant, Sender, std::exception_ptr>;
+
+                static constexpr bool sends_done = true;
+
+                async_semaphore* semaphore_;
+                Sender sender_;
+
+                template <class Receiver>
+                auto connect(Receiver&& recv) {
+                    return operation<Sender, asio_ext::remove_cvref_t<Receiver>>(
+                        semaphore_, std::move(sender_), std::forward<Receiver>(recv));
+                }
+            };
+        } // namespace detail
+
+        struct cpo
+        {
+            // Connects and starts sender once a permit is acquired from semaphore, the permit
+            // is released on whichever signal sender completes with.
+            template <class Sender>
+            auto operator()(async_semaphore& semaphore, Sender&& sender) const {
+                return detail::sender<asio_ext::remove_cvref_t<Sender>>{&semaphore, std::forward<Sender>(sender)};
+            }
+        };
+
+        template <typename T = cpo>
+        struct static_instance
+        {
+            static const T instance;
+        };
+
+        template <typename T>
+        const T static_instance<T>::instance = {};
+    }
+} // namespace asio_ext
+
+namespace asio {
+namespace execution {
+static ASIO_CONSTEXPR const asio_ext::with_permit::cpo&
+      with_permit = asio_ext::with_permit::static_instance<>::instance;
+} // namespace execution
+} // namespace asio
+
+#if !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Receiver>
+struct start_member<asio_ext::async_semaphore_detail::acquire_operation<Receiver>>
+{
+    ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+    ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+    typedef void result_type;
+};
+
+template <class Sender, class Receiver>
+struct start_member<asio_ext::with_permit::detail::operation<Sender, Receiver>>
+{
+    ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+    ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+    typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+#endif // !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <typename Receiver>
+struct connect_member<asio_ext::async_semaphore_detail::acquire_sender, Receiver>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef typename asio_ext::async_semaphore_detail::acquire_operation<
+      asio_ext::remove_cvref_t<Receiver>> result_type;
+};
+
+template <class Sender, typename Receiver>
+struct connect_member<asio_ext::with_permit::detail::sender<Sender>, Receiver>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef typename asio_ext::with_permit::detail::operation<
+      Sender, asio_ext::remove_cvref_t<Receiver>> result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_VALUE_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Sender, class Receiver, class... Values>
+struct set_value_member<asio_ext::with_permit::detail::receiver<Sender, Receiver>, void(Values...)>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_VALUE_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_ERROR_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Sender, class Receiver, class E>
+struct set_error_member<asio_ext::with_permit::detail::receiver<Sender, Receiver>, E>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_ERROR_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_DONE_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Sender, class Receiver>
+struct set_done_member<asio_ext::with_permit::detail::receiver<Sender, Receiver>>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_DONE_MEMBER_TRAIT)
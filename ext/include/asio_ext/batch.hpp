@@ -0,0 +1,379 @@
+
+//          Copyright Andreas Wass 2004 - 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <asio/any_io_executor.hpp>
+#include <asio/execution/connect.hpp>
+#include <asio/execution/set_done.hpp>
+#include <asio/execution/set_error.hpp>
+#include <asio/execution/set_value.hpp>
+#include <asio/execution/start.hpp>
+
+#include <asio_ext/detail/optional.hpp>
+#include <asio_ext/schedule_after.hpp>
+#include <asio_ext/type_traits.hpp>
+
+namespace asio_ext
+{
+    namespace batch
+    {
+        namespace detail
+        {
+            // The part of a pending batch operation that the queue needs to know about.
+            template <class T>
+            struct waiter_base
+            {
+                std::size_t max_items_;
+                bool deadline_passed_ = false;
+                std::vector<T> buffer_;
+                void (*cancel_timer_)(waiter_base*) = nullptr;
+                void (*complete_)(waiter_base*) = nullptr;
+
+                explicit waiter_base(std::size_t max_items) : max_items_(max_items) {}
+            };
+
+            template <class T, class Executor, class Receiver>
+            struct operation;
+        } // namespace detail
+    }
+
+    // Collects items pushed by producers until a batch operation picks them up.
+    // The internal buffer is handed over to the batch on completion and replaced
+    // with the (preallocated) buffer of the completing operation, so steady state
+    // accumulation does not reallocate.
+    template <class T, class Executor = asio::any_io_executor>
+    class batch_queue
+    {
+    public:
+        using value_type = T;
+        using executor_type = Executor;
+
+        batch_queue(const executor_type& ex, std::size_t capacity) : executor_(ex) {
+            items_.reserve(capacity);
+        }
+
+        batch_queue(const batch_queue&) = delete;
+        batch_queue& operator=(const batch_queue&) = delete;
+
+        executor_type get_executor() const {
+            return executor_;
+        }
+
+        std::size_t size() const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return items_.size();
+        }
+
+        void push(T value) {
+            batch::detail::waiter_base<T>* ready = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                items_.push_back(std::move(value));
+                if (waiter_ && (items_.size() >= waiter_->max_items_ || waiter_->deadline_passed_)) {
+                    ready = std::exchange(waiter_, nullptr);
+                    ready->buffer_.swap(items_);
+                    if (!ready->deadline_passed_) {
+                        // The operation completes once its timer has been torn down
+                        ready->cancel_timer_(ready);
+                        ready = nullptr;
+                    }
+                }
+            }
+            if (ready) {
+                ready->complete_(ready);
+            }
+        }
+
+    private:
+        template <class, class, class>
+        friend struct batch::detail::operation;
+
+        executor_type executor_;
+        mutable std::mutex mutex_;
+        std::vector<T> items_;
+        batch::detail::waiter_base<T>* waiter_ = nullptr;
+    };
+
+    namespace batch
+    {
+        namespace detail
+        {
+            template <class T, class Executor, class Receiver>
+            struct timer_receiver
+            {
+                operation<T, Executor, Receiver>* op_;
+
+                void set_value() {
+                    op_->on_deadline();
+                }
+
+                void set_done() noexcept {
+                    op_->on_deadline();
+                }
+
+                void set_error(std::exception_ptr e) noexcept {
+                    op_->on_timer_error(std::move(e));
+                }
+            };
+
+            template <class T, class Executor, class Receiver>
+            struct operation : waiter_base<T>
+            {
+                using queue_type = batch_queue<T, Executor>;
+                using timer_sender_type = asio_ext::schedule_after::detail::sender<Executor>;
+                using timer_operation_type = asio::execution::connect_result_t<
+                    timer_sender_type, timer_receiver<T, Executor, Receiver>>;
+
+                Receiver receiver_;
+                queue_type* queue_;
+                std::chrono::steady_clock::duration max_delay_;
+                asio_ext::optional<timer_operation_type> timer_;
+
+                template <class Rx>
+                operation(Rx&& rx, queue_type& queue, std::size_t max_items,
+                    std::chrono::steady_clock::duration max_delay)
+                    : waiter_base<T>(max_items), receiver_(std::forward<Rx>(rx)), queue_(&queue),
+                    max_delay_(max_delay) {
+                }
+
+                void start() ASIO_NOEXCEPT {
+                    try {
+                        this->cancel_timer_ = &operation::cancel_timer;
+                        this->complete_ = &operation::complete_waiter;
+                        this->buffer_.reserve(this->max_items_);
+                        timer_.emplace(asio::execution::connect(
+                            timer_sender_type{ queue_->get_executor(), max_delay_ },
+                            timer_receiver<T, Executor, Receiver>{this}));
+
+                        bool ready = false;
+                        {
+                            std::lock_guard<std::mutex> lock(queue_->mutex_);
+                            if (queue_->waiter_) {
+                                throw std::logic_error("asio_ext::batch: queue already has a pending batch");
+                            }
+                            if (queue_->items_.size() >= this->max_items_) {
+                                this->buffer_.swap(queue_->items_);
+                                ready = true;
+                            }
+                            else {
+                                queue_->waiter_ = this;
+                                // Started under the lock so a concurrent push can always cancel it
+                                asio::execution::start(*timer_);
+                            }
+                        }
+                        if (ready) {
+                            complete();
+                        }
+                    }
+                    catch (...) {
+                        asio::execution::set_error(std::move(receiver_), std::current_exception());
+                    }
+                }
+
+                void on_deadline() {
+                    bool ready = true;
+                    {
+                        std::lock_guard<std::mutex> lock(queue_->mutex_);
+                        if (queue_->waiter_ == this) {
+                            if (queue_->items_.empty()) {
+                                // Nothing to send yet, the next push completes the batch
+                                this->deadline_passed_ = true;
+                                ready = false;
+                            }
+                            else {
+                                queue_->waiter_ = nullptr;
+                                this->buffer_.swap(queue_->items_);
+                            }
+                        }
+                    }
+                    if (ready) {
+                        complete();
+                    }
+                }
+
+                void on_timer_error(std::exception_ptr e) {
+                    {
+                        std::lock_guard<std::mutex> lock(queue_->mutex_);
+                        if (queue_->waiter_ == this) {
+                            queue_->waiter_ = nullptr;
+                        }
+                    }
+                    asio::execution::set_error(std::move(receiver_), std::move(e));
+                }
+
+                void complete() {
+                    try {
+                        asio::execution::set_value(std::move(receiver_), std::move(this->buffer_));
+                    }
+                    catch (...) {
+                        asio::execution::set_error(std::move(receiver_), std::current_exception());
+                    }
+                }
+
+                static void cancel_timer(waiter_base<T>* self) {
+                    static_cast<operation*>(self)->timer_->cancel();
+                }
+
+                static void complete_waiter(waiter_base<T>* self) {
+                    static_cast<operation*>(self)->complete();
+                }
+            };
+
+            template <class T, class Executor>
+            struct sender
+            {
+                template <template <class...> class Tuple, template <class...> class Variant>
+                using value_types = Variant<Tuple<std::vector<T>>>;
+                template <template <class...> class Variant>
+                using error_types = Variant<std::exception_ptr>;
+                static constexpr bool sends_done = false;
+
+                batch_queue<T, Executor>* queue_;
+                std::size_t max_items_;
+                std::chrono::steady_clock::duration max_delay_;
+
+                template <class Receiver>
+                auto connect(Receiver&& recv) const {
+                    return operation<T, Executor, asio_ext::remove_cvref_t<Receiver>>(
+                        std::forward<Receiver>(recv), *queue_, max_items_, max_delay_);
+                }
+            };
+        } // namespace detail
+
+        struct cpo
+        {
+            // Completes with a std::vector<T> of at least max_items items, or with whatever
+            // has been pushed once max_delay has passed. An idle queue never produces an
+            // empty batch, the first push after the deadline completes the operation.
+            // max_items must be at least 1.
+            template <class T, class Executor, class Rep, class Period>
+            auto operator()(batch_queue<T, Executor>& queue, std::size_t max_items,
+                std::chrono::duration<Rep, Period> max_delay) const {
+                if (max_items == 0) {
+                    throw std::invalid_argument("asio_ext::batch: max_items must be at least 1");
+                }
+                return detail::sender<T, Executor>{
+                    &queue, max_items,
+                    std::chrono::duration_cast<std::chrono::steady_clock::duration>(max_delay)};
+            }
+        };
+
+        template <typename T = cpo>
+        struct static_instance
+        {
+            static const T instance;
+        };
+
+        template <typename T>
+        const T static_instance<T>::instance = {};
+    }
+} // namespace asio_ext
+
+namespace asio {
+namespace execution {
+static ASIO_CONSTEXPR const asio_ext::batch::cpo&
+      batch = asio_ext::batch::static_instance<>::instance;
+} // namespace execution
+} // namespace asio
+
+#if !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class T, class Executor, class Receiver>
+struct start_member<asio_ext::batch::detail::operation<T, Executor, Receiver>>
+{
+    ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+    ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+    typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+#endif // !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class T, class Executor, typename Receiver>
+struct connect_member<asio_ext::batch::detail::sender<T, Executor>, Receiver>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef typename asio_ext::batch::detail::operation<
+      T, Executor, asio_ext::remove_cvref_t<Receiver>> result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_VALUE_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class T, class Executor, class Receiver>
+struct set_value_member<asio_ext::batch::detail::timer_receiver<T, Executor, Receiver>, void()>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_VALUE_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_ERROR_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class T, class Executor, class Receiver, class E>
+struct set_error_member<asio_ext::batch::detail::timer_receiver<T, Executor, Receiver>, E>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_ERROR_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_DONE_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class T, class Executor, class Receiver>
+struct set_done_member<asio_ext::batch::detail::timer_receiver<T, Executor, Receiver>>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_DONE_MEMBER_TRAIT)
@@ -0,0 +1,423 @@
+
+//          Copyright Andreas Wass 2004 - 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+#include <asio/execution/connect.hpp>
+#include <asio/execution/set_done.hpp>
+#include <asio/execution/set_error.hpp>
+#include <asio/execution/set_value.hpp>
+#include <asio/execution/start.hpp>
+
+#include <asio_ext/detail/optional.hpp>
+#include <asio_ext/sender_traits.hpp>
+#include <asio_ext/type_traits.hpp>
+
+namespace asio_ext
+{
+    // What circuit_breaker completes with while the breaker is open
+    class circuit_open_error : public std::runtime_error
+    {
+    public:
+        circuit_open_error() : std::runtime_error("asio_ext::circuit_breaker: circuit is open") {}
+    };
+
+    // Error rate tracking for circuit_breaker. Outcomes are counted in a ring of one
+    // second buckets covering the window. Closed, every call goes through, and once the
+    // window holds at least min_calls outcomes of which failure_ratio or more are errors
+    // the breaker opens. Open, calls fail right away until open_for has passed, then the
+    // next call goes through as the only probe (half open). A successful probe closes
+    // the breaker with an empty window, a failed one opens it again. Each bucket packs
+    // its second and both counts in a single word, so recording is one compare-and-swap.
+    class breaker
+    {
+    public:
+        using clock = std::chrono::steady_clock;
+
+        enum class state
+        {
+            closed,
+            open,
+            half_open
+        };
+
+        explicit breaker(double failure_ratio = 0.5, std::size_t min_calls = 20,
+            std::chrono::seconds window = std::chrono::seconds(10),
+            clock::duration open_for = std::chrono::seconds(5))
+            : failure_ratio_(failure_ratio), min_calls_(min_calls),
+            bucket_count_(static_cast<std::size_t>(window.count())), open_for_(open_for) {
+            if (window.count() < 1 || static_cast<std::uint64_t>(window.count()) > epoch_mask) {
+                throw std::invalid_argument("asio_ext::breaker: window must be at least a second");
+            }
+            if (!(failure_ratio > 0.0 && failure_ratio <= 1.0)) {
+                throw std::invalid_argument("asio_ext::breaker: failure_ratio must be in (0, 1]");
+            }
+            buckets_ = std::make_unique<std::atomic<std::uint64_t>[]>(bucket_count_);
+            for (std::size_t i = 0; i < bucket_count_; ++i) {
+                buckets_[i].store(0, std::memory_order_relaxed);
+            }
+        }
+
+        breaker(const breaker&) = delete;
+        breaker& operator=(const breaker&) = delete;
+
+        state current_state() const noexcept {
+            return state_.load(std::memory_order_acquire);
+        }
+
+        // Returns false if the call has to fail fast. probe is set for the call that
+        // decides whether an open breaker closes.
+        bool try_acquire(bool& probe) noexcept {
+            probe = false;
+            auto current = state_.load(std::memory_order_acquire);
+            if (current == state::closed) {
+                return true;
+            }
+            if (current == state::open &&
+                clock::now().time_since_epoch().count() - opened_at_.load(std::memory_order_relaxed) >=
+                    open_for_.count() &&
+                state_.compare_exchange_strong(current, state::half_open, std::memory_order_acq_rel)) {
+                probe = true;
+                return true;
+            }
+            rejected_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        void record_success(bool probe) noexcept {
+            if (probe) {
+                for (std::size_t i = 0; i < bucket_count_; ++i) {
+                    buckets_[i].store(0, std::memory_order_relaxed);
+                }
+                state_.store(state::closed, std::memory_order_release);
+                return;
+            }
+            record(success_one);
+        }
+
+        void record_failure(bool probe) noexcept {
+            if (probe) {
+                trip(state::half_open);
+                return;
+            }
+            record(failure_one);
+            if (state_.load(std::memory_order_relaxed) == state::closed) {
+                auto counts = window_counts();
+                auto total = counts.first + counts.second;
+                if (total >= min_calls_ && counts.second >= failure_ratio_ * total) {
+                    trip(state::closed);
+                }
+            }
+        }
+
+        // A probe that completed with set_done says nothing, the next call probes again
+        void record_done(bool probe) noexcept {
+            if (probe) {
+                state_.store(state::open, std::memory_order_release);
+            }
+        }
+
+        // Successes and failures in the window
+        std::pair<std::uint64_t, std::uint64_t> window_counts() const noexcept {
+            auto now = epoch_now();
+            std::uint64_t successes = 0;
+            std::uint64_t failures = 0;
+            for (std::size_t i = 0; i < bucket_count_; ++i) {
+                auto bucket = buckets_[i].load(std::memory_order_relaxed);
+                if (((now - (bucket >> epoch_shift)) & epoch_mask) < bucket_count_ && bucket != 0) {
+                    successes += (bucket >> count_bits) & count_mask;
+                    failures += bucket & count_mask;
+                }
+            }
+            return { successes, failures };
+        }
+
+        // Calls failed fast so far
+        std::uint64_t rejected() const noexcept {
+            return rejected_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        // [ epoch second : 20 | successes : 22 | failures : 22 ], counts saturate
+        static constexpr unsigned count_bits = 22;
+        static constexpr unsigned epoch_shift = 2 * count_bits;
+        static constexpr std::uint64_t count_mask = (std::uint64_t(1) << count_bits) - 1;
+        static constexpr std::uint64_t epoch_mask = (std::uint64_t(1) << (64 - epoch_shift)) - 1;
+        static constexpr std::uint64_t success_one = std::uint64_t(1) << count_bits;
+        static constexpr std::uint64_t failure_one = 1;
+
+        static std::uint64_t epoch_now() noexcept {
+            // Offset by one so that an unused bucket (0) never matches
+            return (static_cast<std::uint64_t>(
+                        std::chrono::duration_cast<std::chrono::seconds>(clock::now().time_since_epoch()).count()) +
+                       1) &
+                   epoch_mask;
+        }
+
+        void record(std::uint64_t one) noexcept {
+            auto now = epoch_now();
+            auto& bucket = buckets_[now % bucket_count_];
+            auto value = bucket.load(std::memory_order_relaxed);
+            for (;;) {
+                auto next = (value >> epoch_shift) == now ? value : now << epoch_shift;
+                auto mask = one == failure_one ? count_mask : count_mask << count_bits;
+                if ((next & mask) != mask) {
+                    next += one;
+                }
+                if (bucket.compare_exchange_weak(value, next, std::memory_order_relaxed)) {
+                    return;
+                }
+            }
+        }
+
+        // opened_at_ is stored before open is published, the release pairs with the
+        // acquire in try_acquire so a caller that sees open also sees when it opened
+        void trip(state from) noexcept {
+            if (state_.load(std::memory_order_relaxed) != from) {
+                return;
+            }
+            opened_at_.store(clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+            state_.compare_exchange_strong(from, state::open, std::memory_order_release, std::memory_order_relaxed);
+        }
+
+        double failure_ratio_;
+        std::size_t min_calls_;
+        std::size_t bucket_count_;
+        clock::duration open_for_;
+        std::unique_ptr<std::atomic<std::uint64_t>[]> buckets_;
+        std::atomic<state> state_{ state::closed };
+        std::atomic<clock::rep> opened_at_{ 0 };
+        std::atomic<std::uint64_t> rejected_{ 0 };
+    };
+
+    namespace circuit_breaker
+    {
+        namespace detail
+        {
+            template <class Sender, class Receiver>
+            struct operation_state;
+
+            template <class Sender, class Receiver>
+            struct receiver
+            {
+                operation_state<Sender, Receiver>* op_;
+
+                // Recorded before completing, the breaker may be gone after that
+                template <class... Values>
+                void set_value(Values&&... values) {
+                    if (op_->first_record()) {
+                        op_->breaker_->record_success(op_->probe_);
+                    }
+                    asio::execution::set_value(std::move(op_->receiver_), std::forward<Values>(values)...);
+                }
+
+                void set_done() noexcept {
+                    if (op_->first_record()) {
+                        op_->breaker_->record_done(op_->probe_);
+                    }
+                    asio::execution::set_done(std::move(op_->receiver_));
+                }
+
+                template <class E>
+                void set_error(E&& e) noexcept {
+                    if (op_->first_record()) {
+                        op_->breaker_->record_failure(op_->probe_);
+                    }
+                    asio::execution::set_error(std::move(op_->receiver_), (E&&)e);
+                }
+            };
+
+            template <class Sender, class Receiver>
+            struct operation_state
+            {
+                using next_operation_state = asio::execution::connect_result_t<Sender, receiver<Sender, Receiver>>;
+
+                breaker* breaker_;
+                Sender sender_;
+                // Stays here until completion, so a throwing connect can still be reported to it
+                Receiver receiver_;
+                bool probe_ = false;
+                bool recorded_ = false;
+                asio_ext::optional<next_operation_state> state_;
+
+                template <class Rx>
+                operation_state(breaker* b, Sender&& sender, Rx&& rx)
+                    : breaker_(b), sender_(std::move(sender)), receiver_(std::forward<Rx>(rx)) {
+                }
+
+                void start() ASIO_NOEXCEPT {
+                    if (!breaker_->try_acquire(probe_)) {
+                        asio::execution::set_error(std::move(receiver_), std::make_exception_ptr(circuit_open_error()));
+                        return;
+                    }
+                    try {
+                        auto& state = state_.emplace(
+                            asio::execution::connect(std::move(sender_), receiver<Sender, Receiver>{ this }));
+                        asio::execution::start(state);
+                    }
+                    catch (...) {
+                        // Not the backend's fault, give the probe back
+                        breaker_->record_done(probe_);
+                        asio::execution::set_error(std::move(receiver_), std::current_exception());
+                    }
+                }
+
+                // Once only, a throwing set_value is followed by set_error, which is the
+                // consumer's failure rather than the backend's
+                bool first_record() noexcept {
+                    return !std::exchange(recorded_, true);
+                }
+            };
+
+            template <class Sender>
+            struct sender
+            {
+                template <template <class...> class Tuple, template <class...> class Variant>
+                using value_types =
+                    typename asio::execution::sender_traits<Sender>::template value_types<Tuple, Variant>;
+
+                template <template <class...> class Variant>
+                using error_types = asio_ext::append_error_types<Variant, Sender, std::exception_ptr>;
+
+                static constexpr bool sends_done = asio::execution::sender_traits<Sender>::sends_done;
+
+                breaker* breaker_;
+                Sender sender_;
+
+                template <class Receiver>
+                auto connect(Receiver&& recv) {
+                    return operation_state<Sender, asio_ext::remove_cvref_t<Receiver>>(
+                        breaker_, std::move(sender_), std::forward<Receiver>(recv));
+                }
+            };
+        } // namespace detail
+
+        struct cpo
+        {
+            // Starts sender if the breaker lets the call through and records how it
+            // completes, otherwise completes with a circuit_open_error right away.
+            template <class Sender>
+            auto operator()(breaker& b, Sender&& sender) const {
+                return detail::sender<asio_ext::remove_cvref_t<Sender>>{&b, std::forward<Sender>(sender)};
+            }
+        };
+
+        template <typename T = cpo>
+        struct static_instance
+        {
+            static const T instance;
+        };
+
+        template <typename T>
+        const T static_instance<T>::instance = {};
+    }
+} // namespace asio_ext
+
+namespace asio {
+namespace execution {
+static ASIO_CONSTEXPR const asio_ext::circuit_breaker::cpo&
+      circuit_breaker = asio_ext::circuit_breaker::static_instance<>::instance;
+} // namespace execution
+} // namespace asio
+
+#if !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Sender, class Receiver>
+struct start_member<asio_ext::circuit_breaker::detail::operation_state<Sender, Receiver>>
+{
+    ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+    ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+    typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+#endif // !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Sender, typename Receiver>
+struct connect_member<asio_ext::circuit_breaker::detail::sender<Sender>, Receiver>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef typename asio_ext::circuit_breaker::detail::operation_state<
+      Sender, asio_ext::remove_cvref_t<Receiver>> result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_VALUE_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Sender, class Receiver, class... Values>
+struct set_value_member<asio_ext::circuit_breaker::detail::receiver<Sender, Receiver>, void(Values...)>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_VALUE_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_ERROR_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Sender, class Receiver, class E>
+struct set_error_member<asio_ext::circuit_breaker::detail::receiver<Sender, Receiver>, E>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_ERROR_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_DONE_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Sender, class Receiver>
+struct set_done_member<asio_ext::circuit_breaker::detail::receiver<Sender, Receiver>>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_DONE_MEMBER_TRAIT)
@@ -0,0 +1,44 @@
+
+//          Copyright Andreas Wass 2004 - 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <exception>
+#include <utility>
+
+#include <asio/error.hpp>
+#include <asio/error_code.hpp>
+#include <asio/execution/set_done.hpp>
+#include <asio/execution/set_error.hpp>
+#include <asio/execution/set_value.hpp>
+#include <asio/system_error.hpp>
+
+namespace asio_ext
+{
+    namespace detail
+    {
+        // Maps the result of an asio completion handler onto a receiver:
+        // operation_aborted -> set_done, any other error -> set_error(system_error),
+        // success -> set_value(values...).
+        template <class Receiver, class... Values>
+        void complete_operation(Receiver& receiver, const asio::error_code& ec, Values&&... values) {
+            if (ec == asio::error::operation_aborted) {
+                asio::execution::set_done(std::move(receiver));
+            }
+            else if (ec) {
+                asio::execution::set_error(std::move(receiver), std::make_exception_ptr(asio::system_error(ec)));
+            }
+            else {
+                try {
+                    asio::execution::set_value(std::move(receiver), std::forward<Values>(values)...);
+                }
+                catch (...) {
+                    asio::execution::set_error(std::move(receiver), std::current_exception());
+                }
+            }
+        }
+    } // namespace detail
+} // namespace asio_ext
@@ -0,0 +1,57 @@
+
+//          Copyright Andreas Wass 2004 - 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+namespace asio_ext
+{
+    namespace detail
+    {
+        // Where the threads of a scheduler sleep while there is no work. Producers only
+        // touch the mutex when someone is asleep.
+        class idle_waiters
+        {
+        public:
+            // Sleeps until ready() holds, it is checked under the lock
+            template <class Predicate>
+            void wait(Predicate ready) {
+                std::unique_lock<std::mutex> lock(mutex_);
+                sleepers_.fetch_add(1);
+                wake_.wait(lock, ready);
+                sleepers_.fetch_sub(1);
+            }
+
+            // After publishing work that ready() checks
+            void notify_one() {
+                if (sleepers_.load() > 0) {
+                    // Taking the lock orders us after a sleeper's check of ready()
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    wake_.notify_one();
+                }
+            }
+
+            // Applies update under the lock and wakes every sleeper to check ready() again
+            template <class Update>
+            void notify_all(Update update) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    update();
+                }
+                wake_.notify_all();
+            }
+
+        private:
+            std::mutex mutex_;
+            std::condition_variable wake_;
+            std::atomic<std::size_t> sleepers_{ 0 };
+        };
+    } // namespace detail
+} // namespace asio_ext
@@ -0,0 +1,78 @@
+
+//          Copyright Andreas Wass 2004 - 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <atomic>
+
+namespace asio_ext
+{
+    namespace detail
+    {
+        // Intrusive hook of an mpsc_queue element.
+        struct mpsc_node
+        {
+            std::atomic<mpsc_node*> next_{ nullptr };
+
+            mpsc_node() = default;
+
+            // Elements may be moved before they are queued, never while queued
+            mpsc_node(const mpsc_node&) noexcept {}
+
+            mpsc_node& operator=(const mpsc_node&) = delete;
+        };
+
+        // Intrusive multi-producer single-consumer queue (Vyukov). Pushing is one exchange,
+        // pop() must not be called concurrently.
+        class mpsc_queue
+        {
+        public:
+            mpsc_queue() noexcept : tail_(&stub_), head_(&stub_) {}
+
+            mpsc_queue(const mpsc_queue&) = delete;
+            mpsc_queue& operator=(const mpsc_queue&) = delete;
+
+            void push(mpsc_node* n) noexcept {
+                n->next_.store(nullptr, std::memory_order_relaxed);
+                mpsc_node* previous = tail_.exchange(n, std::memory_order_acq_rel);
+                previous->next_.store(n, std::memory_order_release);
+            }
+
+            // Returns nullptr when empty or when a producer is half way through push()
+            mpsc_node* pop() noexcept {
+                mpsc_node* head = head_;
+                mpsc_node* next = head->next_.load(std::memory_order_acquire);
+                if (head == &stub_) {
+                    if (!next) {
+                        return nullptr;
+                    }
+                    head_ = next;
+                    head = next;
+                    next = next->next_.load(std::memory_order_acquire);
+                }
+                if (next) {
+                    head_ = next;
+                    return head;
+                }
+                if (head != tail_.load(std::memory_order_acquire)) {
+                    return nullptr;
+                }
+                push(&stub_);
+                next = head->next_.load(std::memory_order_acquire);
+                if (next) {
+                    head_ = next;
+                    return head;
+                }
+                return nullptr;
+            }
+
+        private:
+            std::atomic<mpsc_node*> tail_;
+            mpsc_node* head_;
+            mpsc_node stub_;
+        };
+    } // namespace detail
+} // namespace asio_ext
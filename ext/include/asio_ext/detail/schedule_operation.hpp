@@ -0,0 +1,70 @@
+
+//          Copyright Andreas Wass 2004 - 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <exception>
+#include <utility>
+
+#include <asio/execution/set_done.hpp>
+#include <asio/execution/set_error.hpp>
+#include <asio/execution/set_value.hpp>
+
+namespace asio_ext
+{
+    namespace detail
+    {
+        // Type erased head of an operation queued by a scheduler, Task derives from it
+        // and adds whatever links its queue needs.
+        template <class Task>
+        struct schedule_task
+        {
+            // Completes with set_value when run, otherwise with set_done
+            void (*complete_)(Task*, bool run) ASIO_NOEXCEPT = nullptr;
+        };
+
+        // The operation of a schedule() sender, completing Receiver through Task.
+        template <class Task, class Receiver>
+        struct schedule_operation : Task
+        {
+            Receiver receiver_;
+
+            template <class Rx>
+            explicit schedule_operation(Rx&& rx) : receiver_(std::forward<Rx>(rx)) {
+            }
+
+            // Called from start() rather than on construction, connect is also instantiated
+            // for asio's archetype receivers which cannot take every completion
+            void arm() ASIO_NOEXCEPT {
+                this->complete_ = &schedule_operation::complete;
+            }
+
+            static void complete(Task* base, bool run) ASIO_NOEXCEPT {
+                auto* self = static_cast<schedule_operation*>(base);
+                if (!run) {
+                    asio::execution::set_done(std::move(self->receiver_));
+                    return;
+                }
+                try {
+                    asio::execution::set_value(std::move(self->receiver_));
+                }
+                catch (...) {
+                    asio::execution::set_error(std::move(self->receiver_), std::current_exception());
+                }
+            }
+        };
+
+        // What every schedule() sender completes with
+        struct schedule_sender
+        {
+            template <template <class...> class Tuple, template <class...> class Variant>
+            using value_types = Variant<Tuple<>>;
+            template <template <class...> class Variant>
+            using error_types = Variant<std::exception_ptr>;
+            static constexpr bool sends_done = true;
+        };
+    } // namespace detail
+} // namespace asio_ext
@@ -0,0 +1,70 @@
+
+//          Copyright Andreas Wass 2004 - 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <atomic>
+
+namespace asio_ext
+{
+    namespace detail
+    {
+        // Intrusive hook of an operation waiting for a shared result.
+        struct waiter_base
+        {
+            waiter_base* next_ = nullptr;
+            void (*notify_)(waiter_base*) noexcept = nullptr;
+        };
+
+        // Notifies a newest first chain of waiters oldest first. Notifying may destroy the
+        // waiter.
+        inline void notify_in_order(waiter_base* waiters) noexcept {
+            waiter_base* ordered = nullptr;
+            while (waiters) {
+                auto* next = waiters->next_;
+                waiters->next_ = ordered;
+                ordered = waiters;
+                waiters = next;
+            }
+            while (ordered) {
+                auto* next = ordered->next_;
+                ordered->notify_(ordered);
+                ordered = next;
+            }
+        }
+
+        // Lock-free list of the waiters for a result that is produced once. Attaching is
+        // one compare-and-swap, after notify_all() waiters are notified as they attach.
+        class waiter_list
+        {
+        public:
+            // Returns false if the result was there already, waiter has been notified then.
+            bool attach(waiter_base* waiter) noexcept {
+                auto* head = head_.load(std::memory_order_acquire);
+                do {
+                    if (head == &completed_) {
+                        waiter->notify_(waiter);
+                        return false;
+                    }
+                    waiter->next_ = head;
+                } while (!head_.compare_exchange_weak(
+                    head, waiter, std::memory_order_acq_rel, std::memory_order_acquire));
+                return true;
+            }
+
+            // Call once the result is stored, notifies in attach order
+            void notify_all() noexcept {
+                notify_in_order(head_.exchange(&completed_, std::memory_order_acq_rel));
+            }
+
+        private:
+            // Head of the list once the result is available
+            static inline waiter_base completed_;
+
+            std::atomic<waiter_base*> head_{ nullptr };
+        };
+    } // namespace detail
+} // namespace asio_ext
@@ -0,0 +1,508 @@
+
+//          Copyright Andreas Wass 2004 - 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <asio/execution/connect.hpp>
+#include <asio/execution/set_done.hpp>
+#include <asio/execution/start.hpp>
+
+#include <asio_ext/detail/idle_waiters.hpp>
+#include <asio_ext/detail/schedule_operation.hpp>
+#include <asio_ext/type_traits.hpp>
+
+namespace asio_ext
+{
+    class edf_thread_pool;
+
+    namespace edf_detail
+    {
+        using clock = std::chrono::steady_clock;
+
+        struct worker;
+
+        struct task : asio_ext::detail::schedule_task<task>
+        {
+            clock::time_point deadline_;
+            // Pairing heap links, prev_ is the parent for the leftmost child
+            task* child_ = nullptr;
+            task* next_ = nullptr;
+            task* prev_ = nullptr;
+            // The worker the task was pushed to, cancel() may read it while start() runs.
+            // in_heap_ changes under the worker's lock.
+            std::atomic<worker*> owner_{ nullptr };
+            bool in_heap_ = false;
+
+            task() = default;
+
+            // Tasks may be moved before they are queued, never while queued
+            task(const task& other) noexcept
+                : asio_ext::detail::schedule_task<task>(other), deadline_(other.deadline_) {
+            }
+
+            task& operator=(const task&) = delete;
+        };
+
+        // Intrusive min pairing heap ordered by deadline. Push and meld are O(1), pop and
+        // erase amortized O(log n).
+        class pairing_heap
+        {
+        public:
+            bool empty() const noexcept {
+                return root_ == nullptr;
+            }
+
+            task* top() const noexcept {
+                return root_;
+            }
+
+            void push(task* t) noexcept {
+                t->child_ = t->next_ = t->prev_ = nullptr;
+                root_ = meld(root_, t);
+            }
+
+            task* pop() noexcept {
+                auto* t = root_;
+                if (t) {
+                    root_ = merge_pairs(std::exchange(t->child_, nullptr));
+                }
+                return t;
+            }
+
+            void erase(task* t) noexcept {
+                if (t == root_) {
+                    pop();
+                    return;
+                }
+                if (t->prev_->child_ == t) {
+                    t->prev_->child_ = t->next_;
+                }
+                else {
+                    t->prev_->next_ = t->next_;
+                }
+                if (t->next_) {
+                    t->next_->prev_ = t->prev_;
+                }
+                t->next_ = t->prev_ = nullptr;
+                root_ = meld(root_, merge_pairs(std::exchange(t->child_, nullptr)));
+            }
+
+        private:
+            // Both are roots without siblings
+            static task* meld(task* a, task* b) noexcept {
+                if (!a) {
+                    return b;
+                }
+                if (!b) {
+                    return a;
+                }
+                if (b->deadline_ < a->deadline_) {
+                    std::swap(a, b);
+                }
+                b->prev_ = a;
+                b->next_ = a->child_;
+                if (a->child_) {
+                    a->child_->prev_ = b;
+                }
+                a->child_ = b;
+                return a;
+            }
+
+            // Two pass pairing of a sibling list: meld pairs left to right, then fold the
+            // pairs right to left
+            static task* merge_pairs(task* first) noexcept {
+                task* pairs = nullptr;
+                while (first) {
+                    auto* a = first;
+                    auto* b = a->next_;
+                    first = b ? b->next_ : nullptr;
+                    a->next_ = a->prev_ = nullptr;
+                    if (b) {
+                        b->next_ = b->prev_ = nullptr;
+                    }
+                    auto* melded = meld(a, b);
+                    melded->next_ = pairs;
+                    pairs = melded;
+                }
+                task* result = nullptr;
+                while (pairs) {
+                    auto* pair = pairs;
+                    pairs = pair->next_;
+                    pair->next_ = nullptr;
+                    result = meld(result, pair);
+                }
+                return result;
+            }
+
+            task* root_ = nullptr;
+        };
+
+        struct alignas(64) worker
+        {
+            std::mutex mutex_;
+            pairing_heap heap_;
+            // Read without the lock when picking a worker or a victim
+            std::atomic<std::size_t> size_{ 0 };
+            std::atomic<clock::rep> top_{ 0 };
+
+            void push(task* t) noexcept {
+                heap_.push(t);
+                size_.store(size_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                top_.store(heap_.top()->deadline_.time_since_epoch().count(), std::memory_order_relaxed);
+            }
+
+            task* pop() noexcept {
+                auto* t = heap_.pop();
+                if (t) {
+                    removed();
+                }
+                return t;
+            }
+
+            void erase(task* t) noexcept {
+                heap_.erase(t);
+                removed();
+            }
+
+        private:
+            void removed() noexcept {
+                size_.store(size_.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+                if (auto* top = heap_.top()) {
+                    top_.store(top->deadline_.time_since_epoch().count(), std::memory_order_relaxed);
+                }
+            }
+        };
+
+        template <class Receiver>
+        struct operation : asio_ext::detail::schedule_operation<task, Receiver>
+        {
+            edf_thread_pool* pool_;
+
+            template <class Rx>
+            operation(edf_thread_pool* pool, clock::time_point deadline, Rx&& rx)
+                : asio_ext::detail::schedule_operation<task, Receiver>(std::forward<Rx>(rx)), pool_(pool) {
+                this->deadline_ = deadline;
+            }
+
+            inline void start() ASIO_NOEXCEPT;
+
+            // Completes with set_done if the operation is still queued.
+            inline void cancel();
+        };
+
+        struct sender : asio_ext::detail::schedule_sender
+        {
+            sender(edf_thread_pool* pool, clock::time_point deadline) noexcept : pool_(pool), deadline_(deadline) {}
+
+            edf_thread_pool* pool_;
+            clock::time_point deadline_;
+
+            template <class Receiver>
+            auto connect(Receiver&& recv) const {
+                return operation<asio_ext::remove_cvref_t<Receiver>>(pool_, deadline_, std::forward<Receiver>(recv));
+            }
+        };
+    } // namespace edf_detail
+
+    // Earliest deadline first thread pool. Every worker keeps its queued operations in
+    // a pairing heap ordered by deadline. Operations started on a worker go to its own
+    // heap, the others to an idle worker if there is one. A worker runs its earliest deadline
+    // first and, with an empty heap, steals the earliest deadline of all other workers.
+    // Operations whose deadline has passed are shed with set_done instead of being run,
+    // when started as well as when their turn comes, which is also what cancel() and
+    // timeouts built on it complete with.
+    class edf_thread_pool
+    {
+    public:
+        class scheduler_type;
+
+        using clock = edf_detail::clock;
+
+        explicit edf_thread_pool(std::size_t threads = std::max(1u, std::thread::hardware_concurrency()))
+            : worker_count_(std::max<std::size_t>(threads, 1)),
+            workers_(new edf_detail::worker[std::max<std::size_t>(threads, 1)]) {
+            try {
+                for (std::size_t i = 0; i < worker_count_; ++i) {
+                    threads_.emplace_back([this, i] {
+                        work(i);
+                    });
+                }
+            }
+            catch (...) {
+                stop();
+                join();
+                throw;
+            }
+        }
+
+        edf_thread_pool(const edf_thread_pool&) = delete;
+        edf_thread_pool& operator=(const edf_thread_pool&) = delete;
+
+        ~edf_thread_pool() {
+            stop();
+            join();
+            for (std::size_t i = 0; i < worker_count_; ++i) {
+                while (auto* t = workers_[i].pop()) {
+                    t->in_heap_ = false;
+                    t->complete_(t, false);
+                }
+            }
+        }
+
+        inline scheduler_type get_scheduler() noexcept;
+
+        // Workers finish the operation they are running and exit, queued operations
+        // complete with set_done on destruction, later started ones right away.
+        void stop() noexcept {
+            idle_.notify_all([this] {
+                stopped_.store(true, std::memory_order_release);
+            });
+        }
+
+        // Operations shed because their deadline had passed
+        std::uint64_t dropped() const noexcept {
+            return dropped_.load(std::memory_order_relaxed);
+        }
+
+        void submit(edf_detail::task* t) noexcept {
+            if (stopped_.load(std::memory_order_acquire)) {
+                t->complete_(t, false);
+                return;
+            }
+            if (clock::now() > t->deadline_) {
+                drop(t);
+                return;
+            }
+            auto& target = workers_[current().pool_ == this ? current().index_ : pick_worker()];
+            {
+                std::lock_guard<std::mutex> lock(target.mutex_);
+                t->owner_.store(&target, std::memory_order_release);
+                t->in_heap_ = true;
+                target.push(t);
+                queued_.fetch_add(1);
+            }
+            idle_.notify_one();
+        }
+
+        bool cancel(edf_detail::task* t) noexcept {
+            auto* owner = t->owner_.load(std::memory_order_acquire);
+            if (!owner) {
+                return false;
+            }
+            std::lock_guard<std::mutex> lock(owner->mutex_);
+            if (!t->in_heap_) {
+                return false;
+            }
+            owner->erase(t);
+            t->in_heap_ = false;
+            queued_.fetch_sub(1);
+            return true;
+        }
+
+    private:
+        struct worker_identity
+        {
+            const edf_thread_pool* pool_ = nullptr;
+            std::size_t index_ = 0;
+        };
+
+        static worker_identity& current() noexcept {
+            static thread_local worker_identity identity;
+            return identity;
+        }
+
+        // The first worker with an empty heap, round-robin when there is none
+        std::size_t pick_worker() noexcept {
+            std::size_t start = next_.fetch_add(1, std::memory_order_relaxed) % worker_count_;
+            for (std::size_t n = 0; n < worker_count_; ++n) {
+                std::size_t i = (start + n) % worker_count_;
+                if (workers_[i].size_.load(std::memory_order_relaxed) == 0) {
+                    return i;
+                }
+            }
+            return start;
+        }
+
+        void drop(edf_detail::task* t) noexcept {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            t->complete_(t, false);
+        }
+
+        void run_or_drop(edf_detail::task* t) noexcept {
+            if (clock::now() > t->deadline_) {
+                drop(t);
+            }
+            else {
+                t->complete_(t, true);
+            }
+        }
+
+        edf_detail::task* pop(edf_detail::worker& w) noexcept {
+            std::lock_guard<std::mutex> lock(w.mutex_);
+            auto* t = w.pop();
+            if (t) {
+                t->in_heap_ = false;
+                queued_.fetch_sub(1);
+            }
+            return t;
+        }
+
+        // Takes the earliest deadline queued on any other worker
+        edf_detail::task* steal(std::size_t self) noexcept {
+            for (;;) {
+                std::size_t victim = self;
+                auto earliest = clock::rep(0);
+                for (std::size_t i = 0; i < worker_count_; ++i) {
+                    if (i == self || workers_[i].size_.load(std::memory_order_relaxed) == 0) {
+                        continue;
+                    }
+                    auto top = workers_[i].top_.load(std::memory_order_relaxed);
+                    if (victim == self || top < earliest) {
+                        victim = i;
+                        earliest = top;
+                    }
+                }
+                if (victim == self) {
+                    return nullptr;
+                }
+                if (auto* t = pop(workers_[victim])) {
+                    return t;
+                }
+            }
+        }
+
+        void work(std::size_t index) {
+            current() = { this, index };
+            auto& self = workers_[index];
+            while (!stopped_.load(std::memory_order_acquire)) {
+                auto* t = pop(self);
+                if (!t) {
+                    t = steal(index);
+                }
+                if (t) {
+                    run_or_drop(t);
+                    continue;
+                }
+                idle_.wait([this] {
+                    return queued_.load() > 0 || stopped_.load(std::memory_order_relaxed);
+                });
+            }
+        }
+
+        void join() noexcept {
+            for (auto& thread : threads_) {
+                if (thread.joinable()) {
+                    thread.join();
+                }
+            }
+        }
+
+        std::size_t worker_count_;
+        std::unique_ptr<edf_detail::worker[]> workers_;
+        std::vector<std::thread> threads_;
+        std::atomic<std::size_t> queued_{ 0 };
+        std::atomic<std::size_t> next_{ 0 };
+        std::atomic<std::uint64_t> dropped_{ 0 };
+        asio_ext::detail::idle_waiters idle_;
+        std::atomic<bool> stopped_{ false };
+    };
+
+    class edf_thread_pool::scheduler_type
+    {
+    public:
+        explicit scheduler_type(edf_thread_pool& pool) noexcept : pool_(&pool) {}
+
+        // Completes on a worker after every operation with an earlier deadline, or with
+        // set_done once deadline has passed.
+        edf_detail::sender schedule_before(clock::time_point deadline) const noexcept {
+            return { pool_, deadline };
+        }
+
+        // Without a deadline, runs after all work that has one.
+        edf_detail::sender schedule() const noexcept {
+            return { pool_, clock::time_point::max() };
+        }
+
+        edf_thread_pool& get_pool() const noexcept {
+            return *pool_;
+        }
+
+        friend bool operator==(const scheduler_type& lhs, const scheduler_type& rhs) noexcept {
+            return lhs.pool_ == rhs.pool_;
+        }
+
+        friend bool operator!=(const scheduler_type& lhs, const scheduler_type& rhs) noexcept {
+            return lhs.pool_ != rhs.pool_;
+        }
+
+    private:
+        edf_thread_pool* pool_;
+    };
+
+    inline edf_thread_pool::scheduler_type edf_thread_pool::get_scheduler() noexcept {
+        return scheduler_type(*this);
+    }
+
+    template <class Receiver>
+    inline void edf_detail::operation<Receiver>::start() ASIO_NOEXCEPT {
+        this->arm();
+        pool_->submit(this);
+    }
+
+    template <class Receiver>
+    inline void edf_detail::operation<Receiver>::cancel() {
+        if (pool_->cancel(this)) {
+            asio::execution::set_done(std::move(this->receiver_));
+        }
+    }
+} // namespace asio_ext
+
+#if !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Receiver>
+struct start_member<asio_ext::edf_detail::operation<Receiver>>
+{
+    ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+    ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+    typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+#endif // !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <typename Receiver>
+struct connect_member<asio_ext::edf_detail::sender, Receiver>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef typename asio_ext::edf_detail::operation<
+      asio_ext::remove_cvref_t<Receiver>> result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
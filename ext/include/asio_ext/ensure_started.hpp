@@ -0,0 +1,475 @@
+
+//          Copyright Andreas Wass 2004 - 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <variant>
+
+#include <asio/execution/connect.hpp>
+#include <asio/execution/set_done.hpp>
+#include <asio/execution/set_error.hpp>
+#include <asio/execution/set_value.hpp>
+#include <asio/execution/start.hpp>
+
+#include <asio_ext/detail/optional.hpp>
+#include <asio_ext/detail/waiter_list.hpp>
+#include <asio_ext/sender_traits.hpp>
+#include <asio_ext/type_traits.hpp>
+
+namespace asio_ext
+{
+    namespace allocation_detail
+    {
+        // Allocates and constructs a T with a rebound copy of alloc
+        template <class T, class Allocator, class... Args>
+        T* allocate_object(const Allocator& alloc, Args&&... args) {
+            using traits = typename std::allocator_traits<Allocator>::template rebind_traits<T>;
+            typename traits::allocator_type rebound(alloc);
+            auto* object = traits::allocate(rebound, 1);
+            try {
+                traits::construct(rebound, object, std::forward<Args>(args)...);
+            }
+            catch (...) {
+                traits::deallocate(rebound, object, 1);
+                throw;
+            }
+            return object;
+        }
+
+        // Destroys an object made by allocate_object, T keeps its allocator in alloc_
+        template <class T>
+        void destroy_object(T* object) noexcept {
+            using traits =
+                typename std::allocator_traits<decltype(object->alloc_)>::template rebind_traits<T>;
+            typename traits::allocator_type rebound(object->alloc_);
+            traits::destroy(rebound, object);
+            traits::deallocate(rebound, object, 1);
+        }
+    } // namespace allocation_detail
+
+    namespace ensure_started
+    {
+        namespace detail
+        {
+            using asio_ext::detail::waiter_base;
+
+            struct done_tag
+            {};
+
+            template <class Sender, class Allocator>
+            struct shared_state;
+
+            template <class Sender, class Allocator>
+            struct upstream_receiver
+            {
+                shared_state<Sender, Allocator>* state_;
+
+                template <class... Values>
+                void set_value(Values&&... values) {
+                    state_->complete([&]() {
+                        try {
+                            state_->result_.template emplace<1>(
+                                std::tuple<asio_ext::remove_cvref_t<Values>...>(std::forward<Values>(values)...));
+                        }
+                        catch (...) {
+                            state_->result_.template emplace<2>(std::current_exception());
+                        }
+                    });
+                }
+
+                template <class E>
+                void set_error(E&& e) noexcept {
+                    state_->complete([&]() {
+                        state_->result_.template emplace<2>(std::forward<E>(e));
+                    });
+                }
+
+                void set_done() noexcept {
+                    state_->complete([&]() {
+                        state_->result_.template emplace<3>();
+                    });
+                }
+            };
+
+            // Upstream operation and result in one block. Owned by the running upstream and
+            // by the sender or the operation it was connected into.
+            template <class Sender, class Allocator>
+            struct shared_state
+            {
+                using upstream_operation_type =
+                    asio::execution::connect_result_t<Sender, upstream_receiver<Sender, Allocator>>;
+                using values_type =
+                    typename asio::execution::sender_traits<Sender>::template value_types<std::tuple, std::variant>;
+                using errors_type = asio_ext::append_error_types<std::variant, Sender, std::exception_ptr>;
+
+                enum state_type : int
+                {
+                    running,
+                    attached,
+                    completed
+                };
+
+                Allocator alloc_;
+                std::atomic<int> refs_{ 2 };
+                std::atomic<int> state_{ running };
+                waiter_base* waiter_ = nullptr;
+                std::variant<std::monostate, values_type, errors_type, done_tag> result_;
+                asio_ext::optional<upstream_operation_type> upstream_;
+
+                explicit shared_state(const Allocator& alloc) : alloc_(alloc) {}
+
+                template <class S>
+                void start(S&& sender) noexcept {
+                    try {
+                        upstream_.emplace(asio::execution::connect(
+                            std::forward<S>(sender), upstream_receiver<Sender, Allocator>{this}));
+                        asio::execution::start(*upstream_);
+                    }
+                    catch (...) {
+                        complete([&]() {
+                            result_.template emplace<2>(std::current_exception());
+                        });
+                    }
+                }
+
+                // Returns false if the result is already there and the waiter must deliver it
+                bool attach(waiter_base* waiter) noexcept {
+                    waiter_ = waiter;
+                    int expected = running;
+                    return state_.compare_exchange_strong(expected, attached, std::memory_order_acq_rel);
+                }
+
+                template <class Store>
+                void complete(Store&& store) noexcept {
+                    store();
+                    if (state_.exchange(completed, std::memory_order_acq_rel) == attached) {
+                        waiter_->notify_(waiter_);
+                    }
+                    release();
+                }
+
+                void release() noexcept {
+                    if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                        allocation_detail::destroy_object(this);
+                    }
+                }
+
+                template <class Receiver>
+                void deliver(Receiver& receiver) noexcept {
+                    if (auto* values = std::get_if<1>(&result_)) {
+                        try {
+                            std::visit([&](auto& tuple) {
+                                std::apply([&](auto&... vs) {
+                                    asio::execution::set_value(std::move(receiver), std::move(vs)...);
+                                }, tuple);
+                            }, *values);
+                        }
+                        catch (...) {
+                            asio::execution::set_error(std::move(receiver), std::current_exception());
+                        }
+                    }
+                    else if (auto* error = std::get_if<2>(&result_)) {
+                        std::visit([&](auto& e) {
+                            asio::execution::set_error(std::move(receiver), std::move(e));
+                        }, *error);
+                    }
+                    else {
+                        asio::execution::set_done(std::move(receiver));
+                    }
+                }
+            };
+
+            template <class Sender, class Allocator, class Receiver>
+            struct operation : waiter_base
+            {
+                shared_state<Sender, Allocator>* state_;
+                Receiver receiver_;
+
+                template <class Rx>
+                operation(shared_state<Sender, Allocator>* state, Rx&& rx)
+                    : state_(state), receiver_(std::forward<Rx>(rx)) {
+                }
+
+                operation(operation&& other)
+                    : state_(std::exchange(other.state_, nullptr)), receiver_(std::move(other.receiver_)) {
+                }
+
+                ~operation() {
+                    if (state_) {
+                        state_->release();
+                    }
+                }
+
+                void start() ASIO_NOEXCEPT {
+                    notify_ = &operation::notify;
+                    if (!state_->attach(this)) {
+                        state_->deliver(receiver_);
+                    }
+                }
+
+                static void notify(waiter_base* waiter) noexcept {
+                    auto* self = static_cast<operation*>(waiter);
+                    self->state_->deliver(self->receiver_);
+                }
+            };
+
+            template <class Sender, class Allocator>
+            struct sender
+            {
+                template <template <class...> class Tuple, template <class...> class Variant>
+                using value_types =
+                    typename asio::execution::sender_traits<Sender>::template value_types<Tuple, Variant>;
+
+                template <template <class...> class Variant>
+                using error_types = asio_ext::append_error_types<Variant, Sender, std::exception_ptr>;
+
+                static constexpr bool sends_done = asio::execution::sender_traits<Sender>::sends_done;
+
+                shared_state<Sender, Allocator>* state_;
+
+                explicit sender(shared_state<Sender, Allocator>* state) noexcept : state_(state) {}
+                sender(sender&& other) noexcept : state_(std::exchange(other.state_, nullptr)) {}
+                sender(const sender&) = delete;
+
+                ~sender() {
+                    // Dropping the sender detaches the work, it still runs to completion
+                    if (state_) {
+                        state_->release();
+                    }
+                }
+
+                template <class Receiver>
+                auto connect(Receiver&& recv) && {
+                    return operation<Sender, Allocator, asio_ext::remove_cvref_t<Receiver>>(
+                        std::exchange(state_, nullptr), std::forward<Receiver>(recv));
+                }
+            };
+        } // namespace detail
+
+        struct cpo
+        {
+            // Connects and starts sender right away. The returned move-only sender completes
+            // with its result, whether it is started before or after the work completed.
+            // Upstream operation and result share one block allocated through alloc.
+            template <class Sender, class Allocator = std::allocator<std::byte>>
+            auto operator()(Sender&& sender, const Allocator& alloc = Allocator()) const {
+                using state_type = detail::shared_state<asio_ext::remove_cvref_t<Sender>, Allocator>;
+                auto* state = allocation_detail::allocate_object<state_type>(alloc, alloc);
+                state->start(std::forward<Sender>(sender));
+                return detail::sender<asio_ext::remove_cvref_t<Sender>, Allocator>(state);
+            }
+        };
+
+        template <typename T = cpo>
+        struct static_instance
+        {
+            static const T instance;
+        };
+
+        template <typename T>
+        const T static_instance<T>::instance = {};
+    }
+
+    namespace start_detached
+    {
+        namespace detail
+        {
+            template <class Sender, class Allocator>
+            struct detached_state;
+
+            template <class Sender, class Allocator>
+            struct detached_receiver
+            {
+                detached_state<Sender, Allocator>* state_;
+
+                template <class... Values>
+                void set_value(Values&&...) noexcept {
+                    allocation_detail::destroy_object(state_);
+                }
+
+                template <class E>
+                void set_error(E&&) noexcept {
+                    // Nobody is left to observe the error
+                    std::terminate();
+                }
+
+                void set_done() noexcept {
+                    allocation_detail::destroy_object(state_);
+                }
+            };
+
+            template <class Sender, class Allocator>
+            struct detached_state
+            {
+                using operation_type =
+                    asio::execution::connect_result_t<Sender, detached_receiver<Sender, Allocator>>;
+
+                Allocator alloc_;
+                asio_ext::optional<operation_type> op_;
+
+                explicit detached_state(const Allocator& alloc) : alloc_(alloc) {}
+            };
+        } // namespace detail
+
+        struct cpo
+        {
+            // Starts sender and forgets about it. The operation state is allocated through
+            // alloc and freed when it completes. An error calls std::terminate.
+            template <class Sender, class Allocator = std::allocator<std::byte>>
+            void operator()(Sender&& sender, const Allocator& alloc = Allocator()) const {
+                using state_type = detail::detached_state<asio_ext::remove_cvref_t<Sender>, Allocator>;
+                auto* state = allocation_detail::allocate_object<state_type>(alloc, alloc);
+                try {
+                    state->op_.emplace(asio::execution::connect(
+                        std::forward<Sender>(sender), detail::detached_receiver<asio_ext::remove_cvref_t<Sender>, Allocator>{state}));
+                }
+                catch (...) {
+                    allocation_detail::destroy_object(state);
+                    throw;
+                }
+                asio::execution::start(*state->op_);
+            }
+        };
+
+        template <typename T = cpo>
+        struct static_instance
+        {
+            static const T instance;
+        };
+
+        template <typename T>
+        const T static_instance<T>::instance = {};
+    }
+} // namespace asio_ext
+
+namespace asio {
+namespace execution {
+static ASIO_CONSTEXPR const asio_ext::ensure_started::cpo&
+      ensure_started = asio_ext::ensure_started::static_instance<>::instance;
+static ASIO_CONSTEXPR const asio_ext::start_detached::cpo&
+      start_detached = asio_ext::start_detached::static_instance<>::instance;
+} // namespace execution
+} // namespace asio
+
+#if !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Sender, class Allocator, class Receiver>
+struct start_member<asio_ext::ensure_started::detail::operation<Sender, Allocator, Receiver>>
+{
+    ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+    ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+    typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+#endif // !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Sender, class Allocator, typename Receiver>
+struct connect_member<asio_ext::ensure_started::detail::sender<Sender, Allocator>, Receiver>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef typename asio_ext::ensure_started::detail::operation<
+      Sender, Allocator, asio_ext::remove_cvref_t<Receiver>> result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_VALUE_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Sender, class Allocator, class... Values>
+struct set_value_member<asio_ext::ensure_started::detail::upstream_receiver<Sender, Allocator>, void(Values...)>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef void result_type;
+};
+
+template <class Sender, class Allocator, class... Values>
+struct set_value_member<asio_ext::start_detached::detail::detached_receiver<Sender, Allocator>, void(Values...)>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_VALUE_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_ERROR_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Sender, class Allocator, class E>
+struct set_error_member<asio_ext::ensure_started::detail::upstream_receiver<Sender, Allocator>, E>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+template <class Sender, class Allocator, class E>
+struct set_error_member<asio_ext::start_detached::detail::detached_receiver<Sender, Allocator>, E>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_ERROR_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_DONE_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Sender, class Allocator>
+struct set_done_member<asio_ext::ensure_started::detail::upstream_receiver<Sender, Allocator>>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+template <class Sender, class Allocator>
+struct set_done_member<asio_ext::start_detached::detail::detached_receiver<Sender, Allocator>>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_DONE_MEMBER_TRAIT)
@@ -0,0 +1,574 @@
+
+//          Copyright Andreas Wass 2004 - 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <tuple>
+#include <utility>
+#include <variant>
+
+#include <asio/execution/connect.hpp>
+#include <asio/execution/execute.hpp>
+#include <asio/execution/set_done.hpp>
+#include <asio/execution/set_error.hpp>
+#include <asio/execution/set_value.hpp>
+#include <asio/execution/start.hpp>
+
+#include <asio_ext/detail/optional.hpp>
+#include <asio_ext/schedule_after.hpp>
+#include <asio_ext/sender_traits.hpp>
+#include <asio_ext/type_traits.hpp>
+
+namespace asio_ext
+{
+    // Lock-free log2 histogram of latencies with microsecond resolution. Bucket i counts
+    // latencies below 2^i us, percentiles are reported as the upper bound of their bucket.
+    class latency_histogram
+    {
+    public:
+        static constexpr std::size_t bucket_count = 48;
+
+        void record(std::chrono::steady_clock::duration latency) noexcept {
+            auto us = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+            std::size_t bucket = 0;
+            while (us > 0 && bucket + 1 < bucket_count) {
+                us >>= 1;
+                ++bucket;
+            }
+            buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+            count_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        std::uint64_t count() const noexcept {
+            return count_.load(std::memory_order_relaxed);
+        }
+
+        std::chrono::steady_clock::duration percentile(double quantile) const noexcept {
+            auto total = count();
+            auto target = static_cast<std::uint64_t>(quantile * static_cast<double>(total));
+            std::uint64_t seen = 0;
+            for (std::size_t i = 0; i < bucket_count; ++i) {
+                seen += buckets_[i].load(std::memory_order_relaxed);
+                if (seen > target || seen >= total) {
+                    return std::chrono::microseconds(std::uint64_t(1) << i);
+                }
+            }
+            return std::chrono::microseconds(std::uint64_t(1) << (bucket_count - 1));
+        }
+
+    private:
+        std::array<std::atomic<std::uint64_t>, bucket_count> buckets_{};
+        std::atomic<std::uint64_t> count_{ 0 };
+    };
+
+    namespace hedge
+    {
+        namespace detail
+        {
+            template <class Op>
+            using cancel_t = decltype(std::declval<Op&>().cancel());
+
+            // Losers are only cancelled when their operation state offers cancel(),
+            // otherwise the hedge completes once they have finished on their own.
+            template <class Op>
+            void cancel_if_supported(Op& op) {
+                if constexpr (asio_ext::is_detected_v<cancel_t, Op>) {
+                    op.cancel();
+                }
+            }
+
+            enum class slot_state
+            {
+                idle,
+                launching,
+                running,
+                done
+            };
+
+            constexpr std::size_t first_slot = 0;
+            constexpr std::size_t second_slot = 1;
+            constexpr std::size_t timer_slot = 2;
+
+            struct done_tag
+            {};
+
+            template <class Executor, class Factory, class Receiver>
+            struct operation;
+
+            template <class Executor, class Factory, class Receiver, std::size_t Slot>
+            struct attempt_receiver
+            {
+                operation<Executor, Factory, Receiver>* op_;
+
+                template <class... Values>
+                void set_value(Values&&... values) {
+                    op_->template on_value<Slot>(std::forward<Values>(values)...);
+                }
+
+                template <class E>
+                void set_error(E&& e) noexcept {
+                    op_->template on_error<Slot>(std::forward<E>(e));
+                }
+
+                void set_done() noexcept {
+                    op_->template on_done<Slot>();
+                }
+            };
+
+            template <class Executor, class Factory, class Receiver>
+            struct timer_receiver
+            {
+                operation<Executor, Factory, Receiver>* op_;
+
+                void set_value() {
+                    op_->on_timer(true);
+                }
+
+                template <class E>
+                void set_error(E&&) noexcept {
+                    op_->on_timer(false);
+                }
+
+                void set_done() noexcept {
+                    op_->on_timer(false);
+                }
+            };
+
+            template <class Executor, class Factory, class Receiver>
+            struct operation
+            {
+                using clock_type = std::chrono::steady_clock;
+                using attempt_sender_type = decltype(std::declval<Factory&>()());
+                template <std::size_t Slot>
+                using attempt_operation_type = asio::execution::connect_result_t<
+                    attempt_sender_type, attempt_receiver<Executor, Factory, Receiver, Slot>>;
+                using timer_operation_type = asio::execution::connect_result_t<
+                    schedule_after::detail::sender<Executor>, timer_receiver<Executor, Factory, Receiver>>;
+                using values_type = typename asio::execution::sender_traits<
+                    attempt_sender_type>::template value_types<std::tuple, std::variant>;
+                using errors_type = asio_ext::append_error_types<std::variant, attempt_sender_type, std::exception_ptr>;
+
+                static constexpr std::size_t min_samples = 16;
+
+                Executor executor_;
+                Factory factory_;
+                clock_type::duration delay_;
+                latency_histogram* histogram_;
+                Receiver receiver_;
+
+                std::mutex mutex_;
+                // Started slots plus whoever is currently launching, the last one out completes
+                std::size_t pending_ = 0;
+                bool finished_ = false;
+                std::array<slot_state, 3> slots_{};
+                std::array<clock_type::time_point, 2> started_;
+                std::variant<std::monostate, values_type, errors_type, done_tag> result_;
+
+                asio_ext::optional<attempt_operation_type<first_slot>> first_;
+                asio_ext::optional<attempt_operation_type<second_slot>> second_;
+                asio_ext::optional<timer_operation_type> timer_;
+
+                template <class Rx>
+                operation(const Executor& ex, Factory&& factory, clock_type::duration delay,
+                    latency_histogram* histogram, Rx&& rx)
+                    : executor_(ex), factory_(std::move(factory)), delay_(delay), histogram_(histogram),
+                    receiver_(std::forward<Rx>(rx)) {
+                }
+
+                // Only valid before start()
+                operation(operation&& other)
+                    : executor_(std::move(other.executor_)), factory_(std::move(other.factory_)),
+                    delay_(other.delay_), histogram_(other.histogram_), receiver_(std::move(other.receiver_)) {
+                }
+
+                void start() ASIO_NOEXCEPT {
+                    pending_ = 1;
+                    if (histogram_ && histogram_->count() >= min_samples) {
+                        delay_ = histogram_->percentile(0.95);
+                    }
+                    launch<first_slot>();
+                    launch<timer_slot>();
+                    release();
+                }
+
+                template <std::size_t Slot>
+                auto& slot_operation() {
+                    if constexpr (Slot == first_slot) {
+                        return first_;
+                    }
+                    else if constexpr (Slot == second_slot) {
+                        return second_;
+                    }
+                    else {
+                        return timer_;
+                    }
+                }
+
+                template <std::size_t Slot>
+                void launch() {
+                    {
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        if (finished_) {
+                            return;
+                        }
+                        slots_[Slot] = slot_state::launching;
+                        ++pending_;
+                    }
+                    try {
+                        if constexpr (Slot == timer_slot) {
+                            timer_.emplace(asio::execution::connect(
+                                asio::execution::schedule_after(executor_, delay_),
+                                timer_receiver<Executor, Factory, Receiver>{this}));
+                            asio::execution::start(*timer_);
+                        }
+                        else {
+                            started_[Slot] = clock_type::now();
+                            auto& op = slot_operation<Slot>().emplace(asio::execution::connect(
+                                factory_(), attempt_receiver<Executor, Factory, Receiver, Slot>{this}));
+                            asio::execution::start(op);
+                        }
+                    }
+                    catch (...) {
+                        if constexpr (Slot == timer_slot) {
+                            on_timer(false);
+                        }
+                        else {
+                            on_error<Slot>(std::current_exception());
+                        }
+                        return;
+                    }
+                    std::array<bool, 3> cancel{};
+                    {
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        if (slots_[Slot] == slot_state::launching) {
+                            slots_[Slot] = slot_state::running;
+                            // The race was decided while we were launching, nobody else cancels us
+                            cancel[Slot] = finished_;
+                        }
+                    }
+                    if (cancel[Slot]) {
+                        cancel_on_executor(cancel);
+                    }
+                }
+
+                // Attempts and the timer complete on executor_, cancelling from there keeps
+                // cancel() from running concurrently with their I/O objects. Runs inline when
+                // already on executor_. The op stays alive until the cancels have run.
+                void cancel_on_executor(std::array<bool, 3> slots) noexcept {
+                    {
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        ++pending_;
+                    }
+                    auto cancel = [this, slots]() noexcept {
+                        std::array<bool, 3> running{};
+                        {
+                            std::lock_guard<std::mutex> lock(mutex_);
+                            for (std::size_t i = 0; i < slots_.size(); ++i) {
+                                running[i] = slots[i] && slots_[i] == slot_state::running;
+                            }
+                        }
+                        if (running[first_slot]) {
+                            cancel_if_supported(*first_);
+                        }
+                        if (running[second_slot]) {
+                            cancel_if_supported(*second_);
+                        }
+                        if (running[timer_slot]) {
+                            timer_->cancel();
+                        }
+                        release();
+                    };
+                    try {
+                        asio::execution::execute(executor_, cancel);
+                    }
+                    catch (...) {
+                        cancel();
+                    }
+                }
+
+                void on_timer(bool expired) noexcept {
+                    {
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        slots_[timer_slot] = slot_state::done;
+                    }
+                    if (expired) {
+                        launch<second_slot>();
+                    }
+                    release();
+                }
+
+                template <std::size_t Slot, class Store>
+                void on_complete(Store&& store) noexcept {
+                    std::array<bool, 3> cancel{};
+                    bool won = false;
+                    {
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        slots_[Slot] = slot_state::done;
+                        if (!finished_) {
+                            won = finished_ = true;
+                            for (std::size_t i = 0; i < slots_.size(); ++i) {
+                                cancel[i] = slots_[i] == slot_state::running;
+                            }
+                        }
+                    }
+                    if (won) {
+                        store();
+                        if (histogram_) {
+                            histogram_->record(clock_type::now() - started_[Slot]);
+                        }
+                        if (cancel[first_slot] || cancel[second_slot] || cancel[timer_slot]) {
+                            cancel_on_executor(cancel);
+                        }
+                    }
+                    release();
+                }
+
+                template <std::size_t Slot, class... Values>
+                void on_value(Values&&... values) {
+                    on_complete<Slot>([&]() noexcept {
+                        try {
+                            result_.template emplace<1>(
+                                std::tuple<asio_ext::remove_cvref_t<Values>...>(std::forward<Values>(values)...));
+                        }
+                        catch (...) {
+                            result_.template emplace<2>(std::current_exception());
+                        }
+                    });
+                }
+
+                template <std::size_t Slot, class E>
+                void on_error(E&& e) noexcept {
+                    on_complete<Slot>([&]() noexcept {
+                        result_.template emplace<2>(std::forward<E>(e));
+                    });
+                }
+
+                template <std::size_t Slot>
+                void on_done() noexcept {
+                    on_complete<Slot>([&]() noexcept {
+                        result_.template emplace<3>();
+                    });
+                }
+
+                void release() noexcept {
+                    {
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        if (--pending_ > 0) {
+                            return;
+                        }
+                    }
+                    if (auto* values = std::get_if<1>(&result_)) {
+                        try {
+                            std::visit([this](auto& tuple) {
+                                std::apply([this](auto&... vs) {
+                                    asio::execution::set_value(std::move(receiver_), std::move(vs)...);
+                                }, tuple);
+                            }, *values);
+                        }
+                        catch (...) {
+                            asio::execution::set_error(std::move(receiver_), std::current_exception());
+                        }
+                    }
+                    else if (auto* error = std::get_if<2>(&result_)) {
+                        std::visit([this](auto& e) {
+                            asio::execution::set_error(std::move(receiver_), std::move(e));
+                        }, *error);
+                    }
+                    else {
+                        asio::execution::set_done(std::move(receiver_));
+                    }
+                }
+            };
+
+            template <class Executor, class Factory>
+            struct sender
+            {
+                using attempt_sender_type = decltype(std::declval<Factory&>()());
+
+                template <template <class...> class Tuple, template <class...> class Variant>
+                using value_types =
+                    typename asio::execution::sender_traits<attempt_sender_type>::template value_types<Tuple, Variant>;
+
+                template <template <class...> class Variant>
+                using error_types = asio_ext::append_error_types<Variant, attempt_sender_type, std::exception_ptr>;
+
+                static constexpr bool sends_done = asio::execution::sender_traits<attempt_sender_type>::sends_done;
+
+                Executor executor_;
+                Factory factory_;
+                std::chrono::steady_clock::duration delay_;
+                latency_histogram* histogram_;
+
+                template <class Receiver>
+                auto connect(Receiver&& recv) {
+                    return operation<Executor, Factory, asio_ext::remove_cvref_t<Receiver>>(
+                        executor_, std::move(factory_), delay_, histogram_, std::forward<Receiver>(recv));
+                }
+            };
+        } // namespace detail
+
+        struct cpo
+        {
+            // Races factory() against a second factory() started delay after the first, the
+            // first completion wins. Both attempts live inside the operation state. Losers
+            // are cancelled through ex, so attempts whose cancel() touches I/O objects must
+            // complete on ex and ex must not run them concurrently (one thread or a strand).
+            template <class Executor, class Factory, class Rep, class Period>
+            auto operator()(const Executor& ex, Factory&& factory, std::chrono::duration<Rep, Period> delay) const {
+                return detail::sender<Executor, asio_ext::remove_cvref_t<Factory>>{ex,
+                    std::forward<Factory>(factory),
+                    std::chrono::duration_cast<std::chrono::steady_clock::duration>(delay), nullptr};
+            }
+
+            // As above but hedges at the p95 of the latencies recorded in histogram, which every
+            // winning attempt is added to. initial_delay is used until enough samples exist.
+            template <class Executor, class Factory, class Rep, class Period>
+            auto operator()(const Executor& ex, Factory&& factory, latency_histogram& histogram,
+                std::chrono::duration<Rep, Period> initial_delay) const {
+                return detail::sender<Executor, asio_ext::remove_cvref_t<Factory>>{ex,
+                    std::forward<Factory>(factory),
+                    std::chrono::duration_cast<std::chrono::steady_clock::duration>(initial_delay), &histogram};
+            }
+        };
+
+        template <typename T = cpo>
+        struct static_instance
+        {
+            static const T instance;
+        };
+
+        template <typename T>
+        const T static_instance<T>::instance = {};
+    }
+} // namespace asio_ext
+
+namespace asio {
+namespace execution {
+static ASIO_CONSTEXPR const asio_ext::hedge::cpo&
+      hedge = asio_ext::hedge::static_instance<>::instance;
+} // namespace execution
+} // namespace asio
+
+#if !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Executor, class Factory, class Receiver>
+struct start_member<asio_ext::hedge::detail::operation<Executor, Factory, Receiver>>
+{
+    ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+    ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+    typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+#endif // !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Executor, class Factory, typename Receiver>
+struct connect_member<asio_ext::hedge::detail::sender<Executor, Factory>, Receiver>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef typename asio_ext::hedge::detail::operation<
+      Executor, Factory, asio_ext::remove_cvref_t<Receiver>> result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_VALUE_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Executor, class Factory, class Receiver, std::size_t Slot, class... Values>
+struct set_value_member<asio_ext::hedge::detail::attempt_receiver<Executor, Factory, Receiver, Slot>, void(Values...)>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef void result_type;
+};
+
+template <class Executor, class Factory, class Receiver>
+struct set_value_member<asio_ext::hedge::detail::timer_receiver<Executor, Factory, Receiver>, void()>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_VALUE_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_ERROR_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Executor, class Factory, class Receiver, std::size_t Slot, class E>
+struct set_error_member<asio_ext::hedge::detail::attempt_receiver<Executor, Factory, Receiver, Slot>, E>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+template <class Executor, class Factory, class Receiver, class E>
+struct set_error_member<asio_ext::hedge::detail::timer_receiver<Executor, Factory, Receiver>, E>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_ERROR_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_DONE_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Executor, class Factory, class Receiver, std::size_t Slot>
+struct set_done_member<asio_ext::hedge::detail::attempt_receiver<Executor, Factory, Receiver, Slot>>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+template <class Executor, class Factory, class Receiver>
+struct set_done_member<asio_ext::hedge::detail::timer_receiver<Executor, Factory, Receiver>>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_DONE_MEMBER_TRAIT)
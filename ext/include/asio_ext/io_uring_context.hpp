@@ -0,0 +1,624 @@
+
+//          Copyright Andreas Wass 2004 - 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+
+#define ASIO_EXT_HAS_IO_URING 1
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <asio/buffer.hpp>
+#include <asio/error.hpp>
+#include <asio/error_code.hpp>
+#include <asio/execution/connect.hpp>
+#include <asio/execution/set_error.hpp>
+#include <asio/execution/start.hpp>
+#include <asio/system_error.hpp>
+
+#include <asio_ext/detail/complete_operation.hpp>
+#include <asio_ext/type_traits.hpp>
+
+namespace asio_ext
+{
+    namespace io_uring
+    {
+        class context;
+
+        // Index of a file registered through context::register_files.
+        struct registered_file
+        {
+            unsigned index;
+        };
+
+        namespace detail
+        {
+            enum class op_kind
+            {
+                nop,
+                read,
+                write,
+                fsync
+            };
+
+            // Every operation state starts with this header, its address is the SQE user data.
+            struct operation_base
+            {
+                // Called on the thread running the context to queue the SQE.
+                void (*submit_)(operation_base*) ASIO_NOEXCEPT = nullptr;
+                void (*complete_)(operation_base*, int) ASIO_NOEXCEPT = nullptr;
+                operation_base* next_ = nullptr;
+                bool remote_ = false;
+            };
+
+            struct io_request
+            {
+                op_kind kind;
+                int fd;
+                bool fixed_file;
+                std::uint64_t offset;
+                void* data;
+                std::size_t size;
+            };
+
+            inline asio::error_code make_error_code(int error) {
+                return asio::error_code(error, asio::error::get_system_category());
+            }
+
+            [[noreturn]] inline void throw_errno() {
+                throw asio::system_error(make_error_code(errno));
+            }
+
+            template <op_kind Kind, class Receiver>
+            struct operation;
+        } // namespace detail
+
+        // A single threaded io_uring event loop. Operations started on the thread calling
+        // run() write their SQE straight into the submission ring, and everything queued
+        // during one loop iteration goes to the kernel with a single io_uring_enter.
+        // Operations started from any other thread are handed over through a mutex
+        // protected queue and an eventfd wake-up.
+        class context
+        {
+        public:
+            class scheduler_type;
+
+            explicit context(unsigned entries = 256) {
+                io_uring_params params;
+                std::memset(&params, 0, sizeof(params));
+                ring_fd_ = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+                if (ring_fd_ < 0) {
+                    detail::throw_errno();
+                }
+                try {
+                    map_rings(params);
+                    wake_fd_ = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+                    if (wake_fd_ < 0) {
+                        detail::throw_errno();
+                    }
+                    arm_wake();
+                }
+                catch (...) {
+                    release();
+                    throw;
+                }
+            }
+
+            context(const context&) = delete;
+            context& operator=(const context&) = delete;
+
+            ~context() {
+                release();
+            }
+
+            inline scheduler_type get_scheduler() ASIO_NOEXCEPT;
+
+            // Runs the loop until no operations are outstanding or stop() is called.
+            // Returns the number of operations completed.
+            std::size_t run() {
+                // Restored on the way out, also when enter() or a completion throws
+                struct restore_current
+                {
+                    context* previous_;
+                    ~restore_current() {
+                        current_context() = previous_;
+                    }
+                } restore{ std::exchange(current_context(), this) };
+                std::size_t completed_before = completed_;
+                drain_remote();
+                while (!stopped_.load(std::memory_order_acquire) &&
+                    outstanding_.load(std::memory_order_acquire) > 0) {
+                    enter(pending_, 1, IORING_ENTER_GETEVENTS);
+                    reap();
+                }
+                return completed_ - completed_before;
+            }
+
+            void stop() {
+                stopped_.store(true, std::memory_order_release);
+                wake();
+            }
+
+            void restart() {
+                stopped_.store(false, std::memory_order_release);
+            }
+
+            bool running_in_this_thread() const ASIO_NOEXCEPT {
+                return current_context() == this;
+            }
+
+            // Registers fixed buffers, reads and writes that fall inside one of them are
+            // then issued as READ_FIXED/WRITE_FIXED. Call before starting any I/O.
+            void register_buffers(const asio::mutable_buffer* buffers, std::size_t count) {
+                std::vector<iovec> iovecs(count);
+                for (std::size_t i = 0; i < count; ++i) {
+                    iovecs[i].iov_base = buffers[i].data();
+                    iovecs[i].iov_len = buffers[i].size();
+                }
+                if (register_op(IORING_REGISTER_BUFFERS, iovecs.data(), static_cast<unsigned>(count)) < 0) {
+                    detail::throw_errno();
+                }
+                registered_buffers_ = std::move(iovecs);
+            }
+
+            void register_files(const int* fds, unsigned count) {
+                if (register_op(IORING_REGISTER_FILES, fds, count) < 0) {
+                    detail::throw_errno();
+                }
+            }
+
+            // Each of these returns a sender, the descriptor is either a plain fd or a
+            // registered_file. Reads and writes complete with the number of bytes transferred.
+            template <class File>
+            auto async_read_at(File file, std::uint64_t offset, asio::mutable_buffer buffer) ASIO_NOEXCEPT;
+
+            template <class File>
+            auto async_write_at(File file, std::uint64_t offset, asio::const_buffer buffer) ASIO_NOEXCEPT;
+
+            template <class File>
+            auto fsync(File file) ASIO_NOEXCEPT;
+
+        private:
+            template <detail::op_kind, class>
+            friend struct detail::operation;
+
+            static context*& current_context() ASIO_NOEXCEPT {
+                static thread_local context* current = nullptr;
+                return current;
+            }
+
+            static int fd_of(int fd) ASIO_NOEXCEPT {
+                return fd;
+            }
+
+            static int fd_of(registered_file file) ASIO_NOEXCEPT {
+                return static_cast<int>(file.index);
+            }
+
+            int register_op(unsigned opcode, const void* arg, unsigned count) {
+                return static_cast<int>(::syscall(__NR_io_uring_register, ring_fd_, opcode, arg, count));
+            }
+
+            void map_rings(const io_uring_params& params) {
+                sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+                cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+                single_mmap_ = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+                if (single_mmap_) {
+                    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+                }
+                sq_ring_ = map(sq_ring_size_, IORING_OFF_SQ_RING);
+                cq_ring_ = single_mmap_ ? sq_ring_ : map(cq_ring_size_, IORING_OFF_CQ_RING);
+                sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+                sqes_ = static_cast<io_uring_sqe*>(map(sqes_size_, IORING_OFF_SQES));
+
+                auto* sq = static_cast<unsigned char*>(sq_ring_);
+                sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+                sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+                sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+                sq_entries_ = params.sq_entries;
+                sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+                auto* cq = static_cast<unsigned char*>(cq_ring_);
+                cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+                cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+                cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+                cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+            }
+
+            void* map(std::size_t size, unsigned long long offset) {
+                void* ptr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                    static_cast<off_t>(offset));
+                if (ptr == MAP_FAILED) {
+                    detail::throw_errno();
+                }
+                return ptr;
+            }
+
+            void release() ASIO_NOEXCEPT {
+                if (sqes_) {
+                    ::munmap(sqes_, sqes_size_);
+                }
+                if (cq_ring_ && cq_ring_ != sq_ring_) {
+                    ::munmap(cq_ring_, cq_ring_size_);
+                }
+                if (sq_ring_) {
+                    ::munmap(sq_ring_, sq_ring_size_);
+                }
+                if (wake_fd_ >= 0) {
+                    ::close(wake_fd_);
+                }
+                if (ring_fd_ >= 0) {
+                    ::close(ring_fd_);
+                }
+            }
+
+            int enter(unsigned to_submit, unsigned min_complete, unsigned flags) {
+                int result;
+                do {
+                    result = static_cast<int>(
+                        ::syscall(__NR_io_uring_enter, ring_fd_, to_submit, min_complete, flags, nullptr, 0));
+                } while (result < 0 && errno == EINTR);
+                if (result < 0) {
+                    detail::throw_errno();
+                }
+                pending_ -= std::min(pending_, static_cast<unsigned>(result));
+                return result;
+            }
+
+            // Only ever called on the thread running the loop.
+            io_uring_sqe* next_sqe() {
+                unsigned tail = *sq_tail_;
+                if (tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) == sq_entries_) {
+                    // Ring is full, hand what we have to the kernel before queueing more
+                    enter(pending_, 0, 0);
+                }
+                unsigned index = tail & sq_mask_;
+                io_uring_sqe* sqe = &sqes_[index];
+                std::memset(sqe, 0, sizeof(*sqe));
+                sq_array_[index] = index;
+                return sqe;
+            }
+
+            void commit_sqe() ASIO_NOEXCEPT {
+                __atomic_store_n(sq_tail_, *sq_tail_ + 1, __ATOMIC_RELEASE);
+                ++pending_;
+            }
+
+            int registered_buffer_index(const void* data, std::size_t size) const ASIO_NOEXCEPT {
+                auto* begin = static_cast<const unsigned char*>(data);
+                for (std::size_t i = 0; i < registered_buffers_.size(); ++i) {
+                    auto* region = static_cast<const unsigned char*>(registered_buffers_[i].iov_base);
+                    if (begin >= region && begin + size <= region + registered_buffers_[i].iov_len) {
+                        return static_cast<int>(i);
+                    }
+                }
+                return -1;
+            }
+
+            void prepare(detail::operation_base* op, const detail::io_request& request) {
+                io_uring_sqe* sqe = next_sqe();
+                sqe->fd = request.fd;
+                if (request.fixed_file) {
+                    sqe->flags |= IOSQE_FIXED_FILE;
+                }
+                switch (request.kind) {
+                case detail::op_kind::nop:
+                    sqe->opcode = IORING_OP_NOP;
+                    sqe->fd = -1;
+                    break;
+                case detail::op_kind::read:
+                case detail::op_kind::write: {
+                    int fixed = registered_buffer_index(request.data, request.size);
+                    bool is_read = request.kind == detail::op_kind::read;
+                    if (fixed >= 0) {
+                        sqe->opcode = is_read ? IORING_OP_READ_FIXED : IORING_OP_WRITE_FIXED;
+                        sqe->buf_index = static_cast<std::uint16_t>(fixed);
+                    }
+                    else {
+                        sqe->opcode = is_read ? IORING_OP_READ : IORING_OP_WRITE;
+                    }
+                    sqe->off = request.offset;
+                    sqe->addr = reinterpret_cast<std::uint64_t>(request.data);
+                    sqe->len = static_cast<std::uint32_t>(request.size);
+                    break;
+                }
+                case detail::op_kind::fsync:
+                    sqe->opcode = IORING_OP_FSYNC;
+                    break;
+                }
+                sqe->user_data = reinterpret_cast<std::uint64_t>(op);
+                commit_sqe();
+            }
+
+            void arm_wake() {
+                io_uring_sqe* sqe = next_sqe();
+                sqe->opcode = IORING_OP_POLL_ADD;
+                sqe->fd = wake_fd_;
+                sqe->poll32_events = POLLIN;
+                sqe->user_data = 0;
+                commit_sqe();
+            }
+
+            void wake() ASIO_NOEXCEPT {
+                std::uint64_t one = 1;
+                auto ignored = ::write(wake_fd_, &one, sizeof(one));
+                (void)ignored;
+            }
+
+            void reap() {
+                unsigned head = *cq_head_;
+                while (head != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+                    io_uring_cqe* cqe = &cqes_[head & cq_mask_];
+                    auto* op = reinterpret_cast<detail::operation_base*>(cqe->user_data);
+                    int result = cqe->res;
+                    __atomic_store_n(cq_head_, ++head, __ATOMIC_RELEASE);
+                    if (op) {
+                        finish(op, result);
+                    }
+                    else {
+                        std::uint64_t value;
+                        auto ignored = ::read(wake_fd_, &value, sizeof(value));
+                        (void)ignored;
+                        arm_wake();
+                        drain_remote();
+                    }
+                    head = *cq_head_;
+                }
+            }
+
+            void finish(detail::operation_base* op, int result) ASIO_NOEXCEPT {
+                outstanding_.fetch_sub(1, std::memory_order_acq_rel);
+                ++completed_;
+                op->complete_(op, result);
+            }
+
+            void start_operation(detail::operation_base* op) {
+                outstanding_.fetch_add(1, std::memory_order_acq_rel);
+                if (running_in_this_thread()) {
+                    op->submit_(op);
+                    return;
+                }
+                op->remote_ = true;
+                {
+                    std::lock_guard<std::mutex> lock(remote_mutex_);
+                    if (remote_tail_) {
+                        remote_tail_->next_ = op;
+                    }
+                    else {
+                        remote_head_ = op;
+                    }
+                    remote_tail_ = op;
+                }
+                wake();
+            }
+
+            void drain_remote() {
+                detail::operation_base* op;
+                {
+                    std::lock_guard<std::mutex> lock(remote_mutex_);
+                    op = std::exchange(remote_head_, nullptr);
+                    remote_tail_ = nullptr;
+                }
+                while (op) {
+                    auto* next = std::exchange(op->next_, nullptr);
+                    op->submit_(op);
+                    op = next;
+                }
+            }
+
+            int ring_fd_ = -1;
+            int wake_fd_ = -1;
+            bool single_mmap_ = false;
+            void* sq_ring_ = nullptr;
+            void* cq_ring_ = nullptr;
+            io_uring_sqe* sqes_ = nullptr;
+            std::size_t sq_ring_size_ = 0;
+            std::size_t cq_ring_size_ = 0;
+            std::size_t sqes_size_ = 0;
+
+            unsigned* sq_head_ = nullptr;
+            unsigned* sq_tail_ = nullptr;
+            unsigned* sq_array_ = nullptr;
+            unsigned sq_mask_ = 0;
+            unsigned sq_entries_ = 0;
+            unsigned* cq_head_ = nullptr;
+            unsigned* cq_tail_ = nullptr;
+            unsigned cq_mask_ = 0;
+            io_uring_cqe* cqes_ = nullptr;
+
+            unsigned pending_ = 0;
+            std::size_t completed_ = 0;
+            std::atomic<std::size_t> outstanding_{ 0 };
+            std::atomic<bool> stopped_{ false };
+            std::vector<iovec> registered_buffers_;
+
+            std::mutex remote_mutex_;
+            detail::operation_base* remote_head_ = nullptr;
+            detail::operation_base* remote_tail_ = nullptr;
+        };
+
+        namespace detail
+        {
+            template <op_kind Kind, class Receiver>
+            struct operation : operation_base
+            {
+                context* context_;
+                io_request request_;
+                Receiver receiver_;
+
+                template <class Rx>
+                operation(context* ctx, const io_request& request, Rx&& rx)
+                    : context_(ctx), request_(request), receiver_(std::forward<Rx>(rx)) {
+                }
+
+                void start() ASIO_NOEXCEPT {
+                    this->submit_ = &operation::submit;
+                    this->complete_ = &operation::complete;
+                    try {
+                        context_->start_operation(this);
+                    }
+                    catch (...) {
+                        asio::execution::set_error(std::move(receiver_), std::current_exception());
+                    }
+                }
+
+                static void submit(operation_base* base) ASIO_NOEXCEPT {
+                    auto* self = static_cast<operation*>(base);
+                    if (Kind == op_kind::nop && self->remote_) {
+                        // Handed over from another thread and now running on the context,
+                        // no need for a round trip through the kernel
+                        self->context_->finish(self, 0);
+                        return;
+                    }
+                    try {
+                        self->context_->prepare(self, self->request_);
+                    }
+                    catch (...) {
+                        self->context_->outstanding_.fetch_sub(1, std::memory_order_acq_rel);
+                        asio::execution::set_error(std::move(self->receiver_), std::current_exception());
+                    }
+                }
+
+                static void complete(operation_base* base, int result) ASIO_NOEXCEPT {
+                    auto* self = static_cast<operation*>(base);
+                    auto ec = result < 0 ? make_error_code(-result) : asio::error_code();
+                    if constexpr (Kind == op_kind::read || Kind == op_kind::write) {
+                        asio_ext::detail::complete_operation(
+                            self->receiver_, ec, static_cast<std::size_t>(result < 0 ? 0 : result));
+                    }
+                    else {
+                        asio_ext::detail::complete_operation(self->receiver_, ec);
+                    }
+                }
+            };
+
+            template <op_kind Kind>
+            struct sender
+            {
+                template <template <class...> class Tuple, template <class...> class Variant>
+                using value_types = std::conditional_t<Kind == op_kind::read || Kind == op_kind::write,
+                    Variant<Tuple<std::size_t>>, Variant<Tuple<>>>;
+                template <template <class...> class Variant>
+                using error_types = Variant<std::exception_ptr>;
+                static constexpr bool sends_done = true;
+
+                context* context_;
+                io_request request_;
+
+                template <class Receiver>
+                auto connect(Receiver&& recv) const {
+                    return operation<Kind, asio_ext::remove_cvref_t<Receiver>>(
+                        context_, request_, std::forward<Receiver>(recv));
+                }
+            };
+        } // namespace detail
+
+        class context::scheduler_type
+        {
+        public:
+            explicit scheduler_type(context& ctx) ASIO_NOEXCEPT : context_(&ctx) {}
+
+            // Completes on the thread running the context.
+            detail::sender<detail::op_kind::nop> schedule() const ASIO_NOEXCEPT {
+                return { context_, detail::io_request{ detail::op_kind::nop, -1, false, 0, nullptr, 0 } };
+            }
+
+            context& get_context() const ASIO_NOEXCEPT {
+                return *context_;
+            }
+
+            friend bool operator==(const scheduler_type& lhs, const scheduler_type& rhs) ASIO_NOEXCEPT {
+                return lhs.context_ == rhs.context_;
+            }
+
+            friend bool operator!=(const scheduler_type& lhs, const scheduler_type& rhs) ASIO_NOEXCEPT {
+                return lhs.context_ != rhs.context_;
+            }
+
+        private:
+            context* context_;
+        };
+
+        inline context::scheduler_type context::get_scheduler() ASIO_NOEXCEPT {
+            return scheduler_type(*this);
+        }
+
+        template <class File>
+        auto context::async_read_at(File file, std::uint64_t offset, asio::mutable_buffer buffer) ASIO_NOEXCEPT {
+            return detail::sender<detail::op_kind::read>{ this, detail::io_request{ detail::op_kind::read,
+                fd_of(file), std::is_same<File, registered_file>::value, offset, buffer.data(), buffer.size() } };
+        }
+
+        template <class File>
+        auto context::async_write_at(File file, std::uint64_t offset, asio::const_buffer buffer) ASIO_NOEXCEPT {
+            return detail::sender<detail::op_kind::write>{ this, detail::io_request{ detail::op_kind::write,
+                fd_of(file), std::is_same<File, registered_file>::value, offset,
+                const_cast<void*>(buffer.data()), buffer.size() } };
+        }
+
+        template <class File>
+        auto context::fsync(File file) ASIO_NOEXCEPT {
+            return detail::sender<detail::op_kind::fsync>{ this, detail::io_request{ detail::op_kind::fsync,
+                fd_of(file), std::is_same<File, registered_file>::value, 0, nullptr, 0 } };
+        }
+    } // namespace io_uring
+} // namespace asio_ext
+
+#if !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <asio_ext::io_uring::detail::op_kind Kind, class Receiver>
+struct start_member<asio_ext::io_uring::detail::operation<Kind, Receiver>>
+{
+    ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+    ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+    typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+#endif // !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <asio_ext::io_uring::detail::op_kind Kind, typename Receiver>
+struct connect_member<asio_ext::io_uring::detail::sender<Kind>, Receiver>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef typename asio_ext::io_uring::detail::operation<
+      Kind, asio_ext::remove_cvref_t<Receiver>> result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
+
+#endif // defined(__linux__) && __has_include(<linux/io_uring.h>)
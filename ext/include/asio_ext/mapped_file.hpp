@@ -0,0 +1,341 @@
+
+//          Copyright Andreas Wass 2004 - 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#define ASIO_EXT_HAS_MAPPED_FILE 1
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <asio/buffer.hpp>
+#include <asio/error.hpp>
+#include <asio/error_code.hpp>
+#include <asio/execution/connect.hpp>
+#include <asio/execution/schedule.hpp>
+#include <asio/execution/set_done.hpp>
+#include <asio/execution/set_error.hpp>
+#include <asio/execution/set_value.hpp>
+#include <asio/execution/start.hpp>
+#include <asio/system_error.hpp>
+
+#include <asio_ext/detail/optional.hpp>
+#include <asio_ext/type_traits.hpp>
+
+namespace asio_ext
+{
+    namespace mapped_file_detail
+    {
+        inline std::size_t page_size() {
+            static const std::size_t size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+            return size;
+        }
+
+        // True when every page of [begin, begin + length) is in memory, i.e. touching
+        // it will not block on a major page fault.
+        inline bool is_resident(const unsigned char* begin, std::size_t length) {
+            const std::size_t page = page_size();
+            auto first = reinterpret_cast<std::uintptr_t>(begin) & ~(page - 1);
+            auto last = reinterpret_cast<std::uintptr_t>(begin + length);
+            unsigned char residency[256];
+            while (first < last) {
+                std::size_t pages = std::min<std::size_t>((last - first + page - 1) / page, sizeof(residency));
+#if defined(__linux__)
+                unsigned char* vec = residency;
+#else
+                char* vec = reinterpret_cast<char*>(residency);
+#endif
+                if (::mincore(reinterpret_cast<void*>(first), pages * page, vec) != 0) {
+                    return false;
+                }
+                for (std::size_t i = 0; i < pages; ++i) {
+                    if ((residency[i] & 1) == 0) {
+                        return false;
+                    }
+                }
+                first += pages * page;
+            }
+            return true;
+        }
+
+        inline void prefault(const unsigned char* begin, std::size_t length) {
+            const std::size_t page = page_size();
+            volatile unsigned char sink = 0;
+            for (std::size_t offset = 0; offset < length; offset += page) {
+                sink = sink + begin[offset];
+            }
+            if (length > 0) {
+                sink = sink + begin[length - 1];
+            }
+        }
+
+        template <class Scheduler, class Receiver>
+        struct operation;
+
+        template <class Scheduler, class Receiver>
+        struct background_receiver
+        {
+            operation<Scheduler, Receiver>* op_;
+
+            void set_value() {
+                op_->on_background();
+            }
+
+            void set_done() noexcept {
+                asio::execution::set_done(std::move(op_->receiver_));
+            }
+
+            template <class E>
+            void set_error(E&& e) noexcept {
+                asio::execution::set_error(std::move(op_->receiver_), std::forward<E>(e));
+            }
+        };
+
+        template <class Scheduler, class Receiver>
+        struct operation
+        {
+            using schedule_sender_type =
+                decltype(asio::execution::schedule(std::declval<Scheduler&>()));
+            using background_operation_type = asio::execution::connect_result_t<
+                schedule_sender_type, background_receiver<Scheduler, Receiver>>;
+
+            Scheduler scheduler_;
+            asio::const_buffer range_;
+            bool in_bounds_;
+            Receiver receiver_;
+            asio_ext::optional<background_operation_type> background_;
+
+            template <class Rx>
+            operation(const Scheduler& scheduler, asio::const_buffer range, bool in_bounds, Rx&& rx)
+                : scheduler_(scheduler), range_(range), in_bounds_(in_bounds), receiver_(std::forward<Rx>(rx)) {
+            }
+
+            void start() ASIO_NOEXCEPT {
+                try {
+                    if (!in_bounds_) {
+                        throw std::out_of_range("asio_ext::mapped_file: range exceeds the file size");
+                    }
+                    auto* begin = static_cast<const unsigned char*>(range_.data());
+                    if (is_resident(begin, range_.size())) {
+                        asio::execution::set_value(std::move(receiver_), range_);
+                        return;
+                    }
+                    // Let the kernel start reading while we hop to the background scheduler,
+                    // whoever started us never takes the page faults
+                    const std::size_t page = page_size();
+                    auto aligned = reinterpret_cast<std::uintptr_t>(begin) & ~(page - 1);
+                    ::madvise(reinterpret_cast<void*>(aligned),
+                        reinterpret_cast<std::uintptr_t>(begin) + range_.size() - aligned, MADV_WILLNEED);
+                    background_.emplace(asio::execution::connect(asio::execution::schedule(scheduler_),
+                        background_receiver<Scheduler, Receiver>{this}));
+                    asio::execution::start(*background_);
+                }
+                catch (...) {
+                    asio::execution::set_error(std::move(receiver_), std::current_exception());
+                }
+            }
+
+            void on_background() {
+                try {
+                    prefault(static_cast<const unsigned char*>(range_.data()), range_.size());
+                    asio::execution::set_value(std::move(receiver_), range_);
+                }
+                catch (...) {
+                    asio::execution::set_error(std::move(receiver_), std::current_exception());
+                }
+            }
+        };
+
+        template <class Scheduler>
+        struct sender
+        {
+            template <template <class...> class Tuple, template <class...> class Variant>
+            using value_types = Variant<Tuple<asio::const_buffer>>;
+            template <template <class...> class Variant>
+            using error_types = Variant<std::exception_ptr>;
+            static constexpr bool sends_done = true;
+
+            Scheduler scheduler_;
+            asio::const_buffer range_;
+            bool in_bounds_;
+
+            template <class Receiver>
+            auto connect(Receiver&& recv) const {
+                return operation<Scheduler, asio_ext::remove_cvref_t<Receiver>>(
+                    scheduler_, range_, in_bounds_, std::forward<Receiver>(recv));
+            }
+        };
+    } // namespace mapped_file_detail
+
+    // A read-only mapping of a whole file. read_range() completes with a span into the
+    // mapping, no bytes are copied. Ranges that are already in memory complete inline,
+    // the others are prefetched with MADV_WILLNEED and completed on the background
+    // scheduler after their pages have been faulted in.
+    template <class Scheduler>
+    class mapped_file
+    {
+    public:
+        mapped_file(const char* path, const Scheduler& background) : background_(background) {
+            int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                throw_errno();
+            }
+            struct stat info;
+            if (::fstat(fd, &info) != 0) {
+                int error = errno;
+                ::close(fd);
+                throw_errno(error);
+            }
+            size_ = static_cast<std::size_t>(info.st_size);
+            if (size_ > 0) {
+                data_ = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+            }
+            int error = errno;
+            ::close(fd);
+            if (data_ == MAP_FAILED) {
+                data_ = nullptr;
+                throw_errno(error);
+            }
+        }
+
+        mapped_file(const mapped_file&) = delete;
+        mapped_file& operator=(const mapped_file&) = delete;
+
+        ~mapped_file() {
+            if (data_) {
+                ::munmap(data_, size_);
+            }
+        }
+
+        std::size_t size() const noexcept {
+            return size_;
+        }
+
+        asio::const_buffer data() const noexcept {
+            return asio::const_buffer(data_, size_);
+        }
+
+        // The mapping must outlive the returned sender and the span it completes with.
+        mapped_file_detail::sender<Scheduler> read_range(std::size_t offset, std::size_t length) const {
+            bool in_bounds = offset <= size_ && length <= size_ - offset;
+            auto* begin = static_cast<const unsigned char*>(data_) + (in_bounds ? offset : 0);
+            return { background_, asio::const_buffer(begin, in_bounds ? length : 0), in_bounds };
+        }
+
+    private:
+        [[noreturn]] static void throw_errno(int error = errno) {
+            throw asio::system_error(asio::error_code(error, asio::error::get_system_category()));
+        }
+
+        Scheduler background_;
+        void* data_ = nullptr;
+        std::size_t size_ = 0;
+    };
+} // namespace asio_ext
+
+#if !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Scheduler, class Receiver>
+struct start_member<asio_ext::mapped_file_detail::operation<Scheduler, Receiver>>
+{
+    ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+    ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+    typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+#endif // !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Scheduler, typename Receiver>
+struct connect_member<asio_ext::mapped_file_detail::sender<Scheduler>, Receiver>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef typename asio_ext::mapped_file_detail::operation<
+      Scheduler, asio_ext::remove_cvref_t<Receiver>> result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_VALUE_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Scheduler, class Receiver>
+struct set_value_member<asio_ext::mapped_file_detail::background_receiver<Scheduler, Receiver>, void()>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_VALUE_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_ERROR_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Scheduler, class Receiver, class E>
+struct set_error_member<asio_ext::mapped_file_detail::background_receiver<Scheduler, Receiver>, E>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_ERROR_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_DONE_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Scheduler, class Receiver>
+struct set_done_member<asio_ext::mapped_file_detail::background_receiver<Scheduler, Receiver>>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_DONE_MEMBER_TRAIT)
+
+#endif // defined(__unix__) || defined(__APPLE__)
@@ -0,0 +1,601 @@
+
+//          Copyright Andreas Wass 2004 - 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <asio/execution/connect.hpp>
+#include <asio/execution/start.hpp>
+
+#include <asio_ext/detail/schedule_operation.hpp>
+#include <asio_ext/type_traits.hpp>
+
+namespace asio_ext
+{
+    namespace numa_detail
+    {
+        [[noreturn]] inline void throw_invalid(const std::string& what) {
+            throw std::invalid_argument("asio_ext::numa_topology: " + what);
+        }
+
+        // Parses the sysfs cpulist format, e.g. "0-3,8,10-11"
+        inline std::vector<int> parse_cpulist(const std::string& list) {
+            std::vector<int> cpus;
+            std::stringstream ranges(list);
+            std::string range;
+            while (std::getline(ranges, range, ',')) {
+                range.erase(std::remove_if(range.begin(), range.end(), [](unsigned char c) { return std::isspace(c); }),
+                    range.end());
+                if (range.empty()) {
+                    continue;
+                }
+                auto dash = range.find('-');
+                try {
+                    std::size_t used = 0;
+                    int first = std::stoi(range.substr(0, dash), &used);
+                    int last = first;
+                    if (dash != std::string::npos) {
+                        if (used != dash) {
+                            throw_invalid("bad cpu range '" + range + "'");
+                        }
+                        last = std::stoi(range.substr(dash + 1), &used);
+                        used += dash + 1;
+                    }
+                    if (used != range.size() || first < 0 || last < first) {
+                        throw_invalid("bad cpu range '" + range + "'");
+                    }
+                    for (int cpu = first; cpu <= last; ++cpu) {
+                        cpus.push_back(cpu);
+                    }
+                }
+                catch (const std::logic_error&) {
+                    throw_invalid("bad cpu range '" + range + "'");
+                }
+            }
+            return cpus;
+        }
+
+        inline bool read_file(const std::string& path, std::string& content) {
+            std::ifstream file(path);
+            return static_cast<bool>(std::getline(file, content));
+        }
+    } // namespace numa_detail
+
+    // CPUs of every NUMA node and the distances between the nodes, as reported by
+    // /sys/devices/system/node or simulated from a config.
+    class numa_topology
+    {
+    public:
+        // Nodes without distances are all equally far from each other
+        explicit numa_topology(std::vector<std::vector<int>> cpus) : cpus_(std::move(cpus)) {
+            for (std::size_t from = 0; from < cpus_.size(); ++from) {
+                distances_.emplace_back(cpus_.size(), 20);
+                distances_[from][from] = 10;
+            }
+            validate();
+        }
+
+        numa_topology(std::vector<std::vector<int>> cpus, std::vector<std::vector<int>> distances)
+            : cpus_(std::move(cpus)), distances_(std::move(distances)) {
+            validate();
+        }
+
+        // The machine's topology, a single node with every hardware thread if the kernel
+        // does not report one.
+        static numa_topology system() {
+            std::vector<std::vector<int>> cpus;
+            std::vector<std::vector<int>> distances;
+            std::string content;
+            for (std::size_t node = 0;; ++node) {
+                auto dir = "/sys/devices/system/node/node" + std::to_string(node);
+                if (!numa_detail::read_file(dir + "/cpulist", content)) {
+                    break;
+                }
+                cpus.push_back(numa_detail::parse_cpulist(content));
+                std::vector<int> row;
+                if (numa_detail::read_file(dir + "/distance", content)) {
+                    std::stringstream values(content);
+                    for (int value; values >> value;) {
+                        row.push_back(value);
+                    }
+                }
+                distances.push_back(std::move(row));
+            }
+            // Memory-only nodes have no CPUs to run workers on
+            for (std::size_t node = cpus.size(); node-- > 0;) {
+                if (cpus[node].empty()) {
+                    cpus.erase(cpus.begin() + node);
+                    distances.erase(distances.begin() + node);
+                    for (auto& row : distances) {
+                        if (node < row.size()) {
+                            row.erase(row.begin() + node);
+                        }
+                    }
+                }
+            }
+            bool complete = std::all_of(distances.begin(), distances.end(),
+                [&](const std::vector<int>& row) { return row.size() == cpus.size(); });
+            if (cpus.empty()) {
+                std::vector<int> all(std::max(1u, std::thread::hardware_concurrency()));
+                std::iota(all.begin(), all.end(), 0);
+                cpus.push_back(std::move(all));
+                complete = false;
+            }
+            if (!complete) {
+                return numa_topology(std::move(cpus));
+            }
+            return numa_topology(std::move(cpus), std::move(distances));
+        }
+
+        // Simulates a topology from the CPU lists of each node separated by ';', in the
+        // sysfs cpulist format: "0-3,8;4-7,9" is two nodes of five CPUs.
+        static numa_topology parse(const std::string& config) {
+            std::vector<std::vector<int>> cpus;
+            std::size_t begin = 0;
+            for (;;) {
+                auto end = config.find(';', begin);
+                cpus.push_back(numa_detail::parse_cpulist(config.substr(begin, end - begin)));
+                if (end == std::string::npos) {
+                    return numa_topology(std::move(cpus));
+                }
+                begin = end + 1;
+            }
+        }
+
+        std::size_t node_count() const noexcept {
+            return cpus_.size();
+        }
+
+        const std::vector<int>& cpus(std::size_t node) const {
+            return cpus_.at(node);
+        }
+
+        int distance(std::size_t from, std::size_t to) const {
+            return distances_.at(from).at(to);
+        }
+
+    private:
+        void validate() const {
+            if (cpus_.empty()) {
+                numa_detail::throw_invalid("no nodes");
+            }
+            for (const auto& node : cpus_) {
+                if (node.empty()) {
+                    numa_detail::throw_invalid("node without cpus");
+                }
+            }
+            if (distances_.size() != cpus_.size() ||
+                std::any_of(distances_.begin(), distances_.end(),
+                    [&](const std::vector<int>& row) { return row.size() != cpus_.size(); })) {
+                numa_detail::throw_invalid("distances do not match the nodes");
+            }
+        }
+
+        std::vector<std::vector<int>> cpus_;
+        std::vector<std::vector<int>> distances_;
+    };
+
+    class numa_thread_pool;
+
+    namespace numa_detail
+    {
+        struct task : asio_ext::detail::schedule_task<task>
+        {
+            task* next_ = nullptr;
+        };
+
+        // Queue shared by the workers of one node. size_ and idle_ change under the lock
+        // but are read without it by other nodes deciding whether to steal.
+        struct alignas(64) node_queue
+        {
+            std::mutex mutex_;
+            std::condition_variable wake_;
+            task* head_ = nullptr;
+            task* tail_ = nullptr;
+            std::atomic<std::size_t> size_{ 0 };
+            std::atomic<std::size_t> idle_{ 0 };
+            std::size_t steal_signals_ = 0;
+            std::size_t workers_ = 0;
+            // The other nodes, nearest first
+            std::vector<std::size_t> victims_;
+
+            void push_locked(task* t) noexcept {
+                t->next_ = nullptr;
+                (tail_ ? tail_->next_ : head_) = t;
+                tail_ = t;
+                size_.fetch_add(1);
+            }
+
+            task* pop_locked() noexcept {
+                auto* t = head_;
+                if (t) {
+                    head_ = t->next_;
+                    if (!head_) {
+                        tail_ = nullptr;
+                    }
+                    size_.fetch_sub(1);
+                }
+                return t;
+            }
+        };
+
+        template <class Receiver>
+        struct operation : asio_ext::detail::schedule_operation<task, Receiver>
+        {
+            numa_thread_pool* pool_;
+            std::size_t node_;
+
+            template <class Rx>
+            operation(numa_thread_pool* pool, std::size_t node, Rx&& rx)
+                : asio_ext::detail::schedule_operation<task, Receiver>(std::forward<Rx>(rx)), pool_(pool), node_(node) {
+            }
+
+            inline void start() ASIO_NOEXCEPT;
+        };
+
+        struct sender : asio_ext::detail::schedule_sender
+        {
+            sender(numa_thread_pool* pool, std::size_t node) noexcept : pool_(pool), node_(node) {}
+
+            numa_thread_pool* pool_;
+            std::size_t node_;
+
+            template <class Receiver>
+            auto connect(Receiver&& recv) const {
+                return operation<asio_ext::remove_cvref_t<Receiver>>(pool_, node_, std::forward<Receiver>(recv));
+            }
+        };
+    } // namespace numa_detail
+
+    // A thread pool with one worker per CPU of the topology, each pinned to its CPU.
+    // Every node has its own queue shared by its workers, so work scheduled on a node
+    // is balanced between that node's workers without crossing the interconnect. A
+    // worker only steals from another node, nearest first, when its own node's queue
+    // is empty and the other node cannot keep up: it has more queued than workers, or
+    // work has waited there longer than steal_delay. Pool allocations made on a worker
+    // (pool_allocator, pooled) grow thread local slabs first touched by the pinned
+    // worker, so operation states allocated there are node local.
+    // Operations still queued when the pool stops complete with set_done.
+    class numa_thread_pool
+    {
+    public:
+        class scheduler_type;
+
+        static constexpr std::size_t no_node = static_cast<std::size_t>(-1);
+
+        // Pinning is best effort, a simulated topology may name CPUs the machine lacks.
+        // Work queued on a busy node is stolen once it has waited steal_delay, or right
+        // away when the node has more queued than it has workers.
+        explicit numa_thread_pool(const numa_topology& topology = numa_topology::system(), bool pin_workers = true,
+            std::chrono::steady_clock::duration steal_delay = std::chrono::microseconds(500))
+            : node_count_(topology.node_count()), queues_(new numa_detail::node_queue[topology.node_count()]),
+            steal_delay_(steal_delay) {
+            for (std::size_t node = 0; node < node_count_; ++node) {
+                auto& victims = queues_[node].victims_;
+                for (std::size_t other = 0; other < node_count_; ++other) {
+                    if (other != node) {
+                        victims.push_back(other);
+                    }
+                }
+                std::stable_sort(victims.begin(), victims.end(), [&](std::size_t lhs, std::size_t rhs) {
+                    return topology.distance(node, lhs) < topology.distance(node, rhs);
+                });
+                queues_[node].workers_ = topology.cpus(node).size();
+            }
+            try {
+                for (std::size_t node = 0; node < node_count_; ++node) {
+                    for (int cpu : topology.cpus(node)) {
+                        workers_.emplace_back([this, node, cpu, pin_workers] {
+                            if (pin_workers) {
+                                pin(cpu);
+                            }
+                            work(node);
+                        });
+                    }
+                }
+            }
+            catch (...) {
+                stop();
+                join();
+                throw;
+            }
+        }
+
+        numa_thread_pool(const numa_thread_pool&) = delete;
+        numa_thread_pool& operator=(const numa_thread_pool&) = delete;
+
+        ~numa_thread_pool() {
+            stop();
+            join();
+            for (std::size_t node = 0; node < node_count_; ++node) {
+                while (auto* t = queues_[node].pop_locked()) {
+                    t->complete_(t, false);
+                }
+            }
+        }
+
+        inline scheduler_type get_scheduler() noexcept;
+
+        std::size_t node_count() const noexcept {
+            return node_count_;
+        }
+
+        // The node of the calling worker, no_node outside of a pool
+        static std::size_t current_node() noexcept {
+            return current().node_;
+        }
+
+        // Workers finish the operation they are running and exit, queued and later
+        // started operations complete with set_done.
+        void stop() noexcept {
+            for (std::size_t node = 0; node < node_count_; ++node) {
+                {
+                    std::lock_guard<std::mutex> lock(queues_[node].mutex_);
+                    stopped_.store(true, std::memory_order_relaxed);
+                }
+                queues_[node].wake_.notify_all();
+            }
+        }
+
+        // Queues t on node, or on the calling worker's node (round-robin from outside
+        // the pool) for no_node.
+        void submit(numa_detail::task* t, std::size_t node) noexcept {
+            if (node == no_node) {
+                node = current().pool_ == this ? current().node_
+                                               : next_node_.fetch_add(1, std::memory_order_relaxed) % node_count_;
+            }
+            auto& queue = queues_[node];
+            bool stopped;
+            bool wake_local = false;
+            {
+                std::lock_guard<std::mutex> lock(queue.mutex_);
+                stopped = stopped_.load(std::memory_order_relaxed);
+                if (!stopped) {
+                    queue.push_locked(t);
+                    wake_local = queue.idle_.load() > 0;
+                }
+            }
+            if (stopped) {
+                t->complete_(t, false);
+            }
+            else if (wake_local) {
+                queue.wake_.notify_one();
+            }
+            else {
+                signal_thief(node);
+            }
+        }
+
+    private:
+        struct worker_identity
+        {
+            const numa_thread_pool* pool_ = nullptr;
+            std::size_t node_ = no_node;
+        };
+
+        static worker_identity& current() noexcept {
+            static thread_local worker_identity identity;
+            return identity;
+        }
+
+        static void pin(int cpu) noexcept {
+#if defined(__linux__)
+            if (cpu >= 0 && cpu < CPU_SETSIZE) {
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                CPU_SET(cpu, &set);
+                ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set);
+            }
+#else
+            (void)cpu;
+#endif
+        }
+
+        void work(std::size_t node) {
+            current() = worker_identity{ this, node };
+            auto& home = queues_[node];
+            auto woken = [&] {
+                return stopped_.load(std::memory_order_relaxed) || home.head_ || home.steal_signals_ > 0;
+            };
+            std::unique_lock<std::mutex> lock(home.mutex_);
+            while (!stopped_.load(std::memory_order_relaxed)) {
+                if (auto* t = home.pop_locked()) {
+                    lock.unlock();
+                    t->complete_(t, true);
+                    lock.lock();
+                    continue;
+                }
+                // Announce idleness before looking elsewhere, a submit that misses the
+                // stolen work is then guaranteed to see us and signal
+                home.idle_.fetch_add(1);
+                lock.unlock();
+                auto* stolen = steal(node, false);
+                bool waiting_elsewhere = !stolen && steal_candidate(node);
+                lock.lock();
+                if (!stolen) {
+                    if (!waiting_elsewhere) {
+                        home.wake_.wait(lock, woken);
+                    }
+                    else if (!home.wake_.wait_for(lock, steal_delay_, woken)) {
+                        // The other node's own workers had steal_delay to get to it
+                        lock.unlock();
+                        stolen = steal(node, true);
+                        lock.lock();
+                    }
+                    if (home.steal_signals_ > 0) {
+                        --home.steal_signals_;
+                    }
+                }
+                home.idle_.fetch_sub(1);
+                if (stolen) {
+                    lock.unlock();
+                    stolen->complete_(stolen, true);
+                    lock.lock();
+                }
+            }
+        }
+
+        // True when another node has work none of its idle workers is taking
+        bool steal_candidate(std::size_t node) const noexcept {
+            for (std::size_t victim : queues_[node].victims_) {
+                auto& queue = queues_[victim];
+                if (queue.size_.load() > queue.idle_.load()) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Takes work from the nearest node with a backlog its own workers cannot take
+        // right away, or once patient, with work none of its idle workers is taking.
+        numa_detail::task* steal(std::size_t node, bool patient) noexcept {
+            for (std::size_t victim : queues_[node].victims_) {
+                auto& queue = queues_[victim];
+                if (queue.size_.load() > (patient ? queue.idle_.load() : queue.workers_)) {
+                    std::lock_guard<std::mutex> lock(queue.mutex_);
+                    if (auto* t = queue.pop_locked()) {
+                        return t;
+                    }
+                }
+            }
+            return nullptr;
+        }
+
+        // node has no idle worker, wake an idle one on the nearest node to steal
+        void signal_thief(std::size_t node) noexcept {
+            for (std::size_t thief : queues_[node].victims_) {
+                auto& queue = queues_[thief];
+                if (queue.idle_.load() > 0) {
+                    {
+                        std::lock_guard<std::mutex> lock(queue.mutex_);
+                        if (queue.steal_signals_ < queue.workers_) {
+                            ++queue.steal_signals_;
+                        }
+                    }
+                    queue.wake_.notify_one();
+                    return;
+                }
+            }
+        }
+
+        void join() noexcept {
+            for (auto& worker : workers_) {
+                if (worker.joinable()) {
+                    worker.join();
+                }
+            }
+        }
+
+        std::size_t node_count_;
+        std::unique_ptr<numa_detail::node_queue[]> queues_;
+        std::chrono::steady_clock::duration steal_delay_;
+        std::vector<std::thread> workers_;
+        std::atomic<bool> stopped_{ false };
+        std::atomic<std::size_t> next_node_{ 0 };
+    };
+
+    class numa_thread_pool::scheduler_type
+    {
+    public:
+        explicit scheduler_type(numa_thread_pool& pool) noexcept : pool_(&pool) {}
+
+        // Completes on a worker of the calling worker's node, from outside the pool on
+        // the nodes in turn.
+        numa_detail::sender schedule() const noexcept {
+            return { pool_, numa_thread_pool::no_node };
+        }
+
+        // Completes on a worker of node, or one that stole it when node is saturated
+        numa_detail::sender schedule_on_node(std::size_t node) const {
+            if (node >= pool_->node_count()) {
+                throw std::out_of_range("asio_ext::numa_thread_pool: no such node");
+            }
+            return { pool_, node };
+        }
+
+        numa_thread_pool& get_pool() const noexcept {
+            return *pool_;
+        }
+
+        friend bool operator==(const scheduler_type& lhs, const scheduler_type& rhs) noexcept {
+            return lhs.pool_ == rhs.pool_;
+        }
+
+        friend bool operator!=(const scheduler_type& lhs, const scheduler_type& rhs) noexcept {
+            return lhs.pool_ != rhs.pool_;
+        }
+
+    private:
+        numa_thread_pool* pool_;
+    };
+
+    inline numa_thread_pool::scheduler_type numa_thread_pool::get_scheduler() noexcept {
+        return scheduler_type(*this);
+    }
+
+    template <class Receiver>
+    inline void numa_detail::operation<Receiver>::start() ASIO_NOEXCEPT {
+        this->arm();
+        pool_->submit(this, node_);
+    }
+} // namespace asio_ext
+
+#if !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Receiver>
+struct start_member<asio_ext::numa_detail::operation<Receiver>>
+{
+    ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+    ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+    typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+#endif // !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <typename Receiver>
+struct connect_member<asio_ext::numa_detail::sender, Receiver>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef typename asio_ext::numa_detail::operation<
+      asio_ext::remove_cvref_t<Receiver>> result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
@@ -0,0 +1,289 @@
+
+//          Copyright Andreas Wass 2004 - 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <exception>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include <asio/execution/connect.hpp>
+#include <asio/execution/schedule.hpp>
+#include <asio/execution/set_done.hpp>
+#include <asio/execution/set_error.hpp>
+#include <asio/execution/set_value.hpp>
+#include <asio/execution/start.hpp>
+
+#include <boost/mp11/algorithm.hpp>
+#include <boost/mp11/list.hpp>
+
+#include <asio_ext/sender_traits.hpp>
+#include <asio_ext/type_traits.hpp>
+
+namespace asio_ext
+{
+    namespace on
+    {
+        namespace detail
+        {
+            template <class Scheduler>
+            using schedule_sender_t = decltype(asio::execution::schedule(std::declval<Scheduler&>()));
+
+            template <class Receiver, class Scheduler, class Sender>
+            struct operation_state;
+
+            template <class Receiver, class Scheduler, class Sender>
+            struct hop_receiver
+            {
+                operation_state<Receiver, Scheduler, Sender>* state_;
+
+                void set_value() {
+                    // Starting sender destroys this receiver, only use locals!
+                    auto* state = state_;
+                    state->start_sender();
+                }
+
+                void set_done() {
+                    asio::execution::set_done(std::move(state_->receiver_));
+                }
+
+                template <class E>
+                void set_error(E&& error) {
+                    asio::execution::set_error(std::move(state_->receiver_), std::forward<E>(error));
+                }
+            };
+
+            template <class Receiver, class Scheduler, class Sender>
+            struct forward_receiver
+            {
+                operation_state<Receiver, Scheduler, Sender>* state_;
+
+                template <class... Values>
+                void set_value(Values&&... values) {
+                    asio::execution::set_value(std::move(state_->receiver_), std::forward<Values>(values)...);
+                }
+
+                void set_done() {
+                    asio::execution::set_done(std::move(state_->receiver_));
+                }
+
+                template <class E>
+                void set_error(E&& error) {
+                    asio::execution::set_error(std::move(state_->receiver_), std::forward<E>(error));
+                }
+            };
+
+            // Hops to the scheduler, then connects and starts sender from there. The hop
+            // and the sender share one slot.
+            template <class Receiver, class Scheduler, class Sender>
+            struct operation_state
+            {
+                using hop_operation_type = asio::execution::connect_result_t<schedule_sender_t<Scheduler>,
+                    hop_receiver<Receiver, Scheduler, Sender>>;
+                using sender_operation_type =
+                    asio::execution::connect_result_t<Sender, forward_receiver<Receiver, Scheduler, Sender>>;
+
+                template <class Rx>
+                operation_state(const Scheduler& scheduler, Sender&& sender, Rx&& receiver)
+                    : scheduler_(scheduler), sender_(std::move(sender)), receiver_(std::forward<Rx>(receiver)) {
+                }
+
+                void start() ASIO_NOEXCEPT {
+                    try {
+                        auto& ref = ops_.template emplace<1>(asio::execution::connect(
+                            asio::execution::schedule(scheduler_), hop_receiver<Receiver, Scheduler, Sender>{ this }));
+                        asio::execution::start(ref);
+                    }
+                    catch (...) {
+                        asio::execution::set_error(std::move(receiver_), std::current_exception());
+                    }
+                }
+
+                void start_sender() ASIO_NOEXCEPT {
+                    try {
+                        auto& ref = ops_.template emplace<2>(asio::execution::connect(
+                            std::move(sender_), forward_receiver<Receiver, Scheduler, Sender>{ this }));
+                        asio::execution::start(ref);
+                    }
+                    catch (...) {
+                        asio::execution::set_error(std::move(receiver_), std::current_exception());
+                    }
+                }
+
+                Scheduler scheduler_;
+                Sender sender_;
+                Receiver receiver_;
+                std::variant<std::monostate, hop_operation_type, sender_operation_type> ops_;
+            };
+
+            template <class Scheduler, class Sender>
+            struct sender
+            {
+                template <template <class...> class Tuple, template <class...> class Variant>
+                using value_types =
+                    typename asio::execution::sender_traits<Sender>::template value_types<Tuple, Variant>;
+
+                template <template <class...> class Variant>
+                using error_types = boost::mp11::mp_rename<boost::mp11::mp_unique<boost::mp11::mp_push_back<
+                    typename asio::execution::sender_traits<Sender>::template error_types<boost::mp11::mp_list>,
+                    std::exception_ptr>>, Variant>;
+
+                static constexpr bool sends_done = true;
+
+                Scheduler scheduler_;
+                Sender sender_;
+
+                template <class Receiver>
+                auto connect(Receiver&& receiver) {
+                    return operation_state<asio_ext::remove_cvref_t<Receiver>, Scheduler, Sender>(
+                        scheduler_, std::move(sender_), std::forward<Receiver>(receiver));
+                }
+            };
+        } // namespace detail
+
+        struct cpo
+        {
+            // Connects and starts sender from an operation of scheduler, so sender and
+            // whatever it completes inline run there.
+            template <class Scheduler, class Sender>
+            auto operator()(Scheduler&& scheduler, Sender&& sender) const {
+                return detail::sender<asio_ext::remove_cvref_t<Scheduler>, asio_ext::remove_cvref_t<Sender>>{
+                    std::forward<Scheduler>(scheduler), std::forward<Sender>(sender)};
+            }
+        };
+
+        template <typename T = cpo>
+        struct static_instance
+        {
+            static const T instance;
+        };
+
+        template <typename T>
+        const T static_instance<T>::instance = {};
+    }
+} // namespace asio_ext
+
+namespace asio {
+namespace execution {
+static ASIO_CONSTEXPR const asio_ext::on::cpo&
+      on = asio_ext::on::static_instance<>::instance;
+} // namespace execution
+} // namespace asio
+
+#if !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Receiver, class Scheduler, class Sender>
+struct start_member<asio_ext::on::detail::operation_state<Receiver, Scheduler, Sender>>
+{
+    ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+    ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+    typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+#endif // !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Scheduler, class Sender, typename R>
+struct connect_member<asio_ext::on::detail::sender<Scheduler, Sender>, R>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef typename asio_ext::on::detail::operation_state<
+      asio_ext::remove_cvref_t<R>, Scheduler, Sender> result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_VALUE_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Receiver, class Scheduler, class Sender>
+struct set_value_member<asio_ext::on::detail::hop_receiver<Receiver, Scheduler, Sender>, void()>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef void result_type;
+};
+
+template <class Receiver, class Scheduler, class Sender, class... Values>
+struct set_value_member<asio_ext::on::detail::forward_receiver<Receiver, Scheduler, Sender>, void(Values...)>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_VALUE_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_ERROR_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Receiver, class Scheduler, class Sender, class E>
+struct set_error_member<asio_ext::on::detail::hop_receiver<Receiver, Scheduler, Sender>, E>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+template <class Receiver, class Scheduler, class Sender, class E>
+struct set_error_member<asio_ext::on::detail::forward_receiver<Receiver, Scheduler, Sender>, E>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_ERROR_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_DONE_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Receiver, class Scheduler, class Sender>
+struct set_done_member<asio_ext::on::detail::hop_receiver<Receiver, Scheduler, Sender>>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+template <class Receiver, class Scheduler, class Sender>
+struct set_done_member<asio_ext::on::detail::forward_receiver<Receiver, Scheduler, Sender>>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_DONE_MEMBER_TRAIT)
@@ -0,0 +1,203 @@
+
+//          Copyright Andreas Wass 2004 - 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace asio_ext
+{
+    namespace pool_detail
+    {
+        inline constexpr std::size_t cache_line_size = 64;
+        // Slabs are aligned to their size, masking a block address finds its slab
+        inline constexpr std::size_t slab_size = 64 * 1024;
+        inline constexpr std::size_t max_block_size = 4096;
+
+        constexpr std::size_t block_size_for(std::size_t size) noexcept {
+            return (size + cache_line_size - 1) / cache_line_size * cache_line_size;
+        }
+
+        struct free_block
+        {
+            free_block* next_;
+        };
+
+        class thread_pool;
+
+        struct alignas(cache_line_size) slab_header
+        {
+            thread_pool* owner_;
+            slab_header* next_;
+        };
+
+        // Freelist of one block size owned by one thread. Only the owner allocates, blocks
+        // freed by other threads are pushed onto returned_ and reclaimed once the local
+        // list runs dry. The pool outlives its thread until every block has come back.
+        class thread_pool
+        {
+        public:
+            explicit thread_pool(std::size_t block_size) noexcept : block_size_(block_size) {}
+
+            thread_pool(const thread_pool&) = delete;
+            thread_pool& operator=(const thread_pool&) = delete;
+
+            ~thread_pool() {
+                while (slabs_) {
+                    auto* slab = std::exchange(slabs_, slabs_->next_);
+                    slab->~slab_header();
+                    ::operator delete(slab, std::align_val_t(slab_size));
+                }
+            }
+
+            void* allocate() {
+                if (!free_) {
+                    free_ = returned_.exchange(nullptr, std::memory_order_acquire);
+                    if (!free_) {
+                        grow();
+                    }
+                }
+                refs_.fetch_add(1, std::memory_order_relaxed);
+                return std::exchange(free_, free_->next_);
+            }
+
+            void deallocate(void* p, bool owner_thread) noexcept {
+                auto* block = static_cast<free_block*>(p);
+                if (owner_thread) {
+                    block->next_ = free_;
+                    free_ = block;
+                }
+                else {
+                    auto* head = returned_.load(std::memory_order_relaxed);
+                    do {
+                        block->next_ = head;
+                    } while (!returned_.compare_exchange_weak(
+                        head, block, std::memory_order_release, std::memory_order_relaxed));
+                }
+                release();
+            }
+
+            // Drops one reference, the owning thread holds one until it exits
+            void release() noexcept {
+                if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    delete this;
+                }
+            }
+
+            static thread_pool* owner_of(void* p) noexcept {
+                auto address = reinterpret_cast<std::uintptr_t>(p) & ~(slab_size - 1);
+                return reinterpret_cast<slab_header*>(address)->owner_;
+            }
+
+        private:
+            void grow() {
+                auto* memory = static_cast<std::byte*>(::operator new(slab_size, std::align_val_t(slab_size)));
+                slabs_ = new (memory) slab_header{ this, slabs_ };
+                for (auto offset = sizeof(slab_header); offset + block_size_ <= slab_size; offset += block_size_) {
+                    auto* block = reinterpret_cast<free_block*>(memory + offset);
+                    block->next_ = free_;
+                    free_ = block;
+                }
+            }
+
+            std::size_t block_size_;
+            free_block* free_ = nullptr;
+            slab_header* slabs_ = nullptr;
+            std::atomic<std::size_t> refs_{ 1 };
+            alignas(cache_line_size) std::atomic<free_block*> returned_{ nullptr };
+        };
+
+        template <std::size_t BlockSize>
+        struct local_pool
+        {
+            thread_pool* pool_ = nullptr;
+
+            ~local_pool() {
+                if (pool_) {
+                    pool_->release();
+                }
+            }
+
+            static local_pool& instance() noexcept {
+                thread_local local_pool local;
+                return local;
+            }
+
+            thread_pool& get() {
+                if (!pool_) {
+                    pool_ = new thread_pool(BlockSize);
+                }
+                return *pool_;
+            }
+        };
+
+        template <std::size_t BlockSize>
+        void* allocate() {
+            return local_pool<BlockSize>::instance().get().allocate();
+        }
+
+        template <std::size_t BlockSize>
+        void deallocate(void* p) noexcept {
+            auto* owner = thread_pool::owner_of(p);
+            owner->deallocate(p, owner == local_pool<BlockSize>::instance().pool_);
+        }
+    } // namespace pool_detail
+
+    // Allocator recycling single objects through a thread local freelist per block size.
+    // Blocks are cache line aligned and carved from slabs, freeing from another thread
+    // hands the block back to the thread that allocated it. Arrays and objects larger
+    // than 4 KiB or over-aligned go to std::allocator. Stateless, so all instances are
+    // interchangeable and it can be handed to the allocator aware adaptors.
+    template <class T>
+    class pool_allocator
+    {
+    public:
+        using value_type = T;
+
+        pool_allocator() noexcept = default;
+
+        template <class U>
+        pool_allocator(const pool_allocator<U>&) noexcept {}
+
+        T* allocate(std::size_t n) {
+            if constexpr (pooled) {
+                if (n == 1) {
+                    return static_cast<T*>(pool_detail::allocate<block_size>());
+                }
+            }
+            return std::allocator<T>().allocate(n);
+        }
+
+        void deallocate(T* p, std::size_t n) noexcept {
+            if constexpr (pooled) {
+                if (n == 1) {
+                    return pool_detail::deallocate<block_size>(p);
+                }
+            }
+            std::allocator<T>().deallocate(p, n);
+        }
+
+        template <class U>
+        bool operator==(const pool_allocator<U>&) const noexcept {
+            return true;
+        }
+
+        template <class U>
+        bool operator!=(const pool_allocator<U>&) const noexcept {
+            return false;
+        }
+
+    private:
+        static constexpr std::size_t block_size = pool_detail::block_size_for(sizeof(T));
+        static constexpr bool pooled =
+            block_size <= pool_detail::max_block_size && alignof(T) <= pool_detail::cache_line_size;
+    };
+} // namespace asio_ext
@@ -0,0 +1,156 @@
+
+//          Copyright Andreas Wass 2004 - 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <new>
+#include <utility>
+
+#include <asio/execution/connect.hpp>
+#include <asio/execution/start.hpp>
+
+#include <asio_ext/pool_allocator.hpp>
+#include <asio_ext/sender_traits.hpp>
+#include <asio_ext/type_traits.hpp>
+
+namespace asio_ext
+{
+    namespace pooled
+    {
+        namespace detail
+        {
+            template <class Op>
+            using cancel_t = decltype(std::declval<Op&>().cancel());
+
+            template <class Sender, class Receiver>
+            struct operation_state
+            {
+                using next_operation_state = asio::execution::connect_result_t<Sender, Receiver>;
+                using allocator_type = asio_ext::pool_allocator<next_operation_state>;
+
+                next_operation_state* state_;
+
+                template <class Rx>
+                operation_state(Sender&& sender, Rx&& rx) : state_(allocator_type().allocate(1)) {
+                    try {
+                        new (state_) next_operation_state(
+                            asio::execution::connect(std::move(sender), Receiver(std::forward<Rx>(rx))));
+                    }
+                    catch (...) {
+                        allocator_type().deallocate(state_, 1);
+                        throw;
+                    }
+                }
+
+                operation_state(operation_state&& other) noexcept : state_(std::exchange(other.state_, nullptr)) {}
+
+                ~operation_state() {
+                    if (state_) {
+                        state_->~next_operation_state();
+                        allocator_type().deallocate(state_, 1);
+                    }
+                }
+
+                void start() ASIO_NOEXCEPT {
+                    asio::execution::start(*state_);
+                }
+
+                template <class Op = next_operation_state, class = cancel_t<Op>>
+                void cancel() {
+                    state_->cancel();
+                }
+            };
+
+            template <class Sender>
+            struct sender
+            {
+                using sender_type = asio_ext::remove_cvref_t<Sender>;
+
+                template <template <class...> class Tuple, template <class...> class Variant>
+                using value_types =
+                    typename asio::execution::sender_traits<sender_type>::template value_types<Tuple, Variant>;
+
+                template <template <class...> class Variant>
+                using error_types =
+                    typename asio::execution::sender_traits<sender_type>::template error_types<Variant>;
+
+                static constexpr bool sends_done = asio::execution::sender_traits<sender_type>::sends_done;
+
+                sender_type sender_;
+
+                template <class Receiver>
+                auto connect(Receiver&& recv) {
+                    return operation_state<sender_type, asio_ext::remove_cvref_t<Receiver>>(
+                        std::move(sender_), std::forward<Receiver>(recv));
+                }
+            };
+        } // namespace detail
+
+        struct cpo
+        {
+            // Moves the operation state of sender into a block from pool_allocator, the
+            // returned sender's operation state is a single pointer. Operation states of one
+            // pipeline type are recycled through the connecting thread's freelist.
+            template <class Sender>
+            auto operator()(Sender&& sender) const {
+                return detail::sender<Sender>{std::forward<Sender>(sender)};
+            }
+        };
+
+        template <typename T = cpo>
+        struct static_instance
+        {
+            static const T instance;
+        };
+
+        template <typename T>
+        const T static_instance<T>::instance = {};
+    }
+} // namespace asio_ext
+
+namespace asio {
+namespace execution {
+static ASIO_CONSTEXPR const asio_ext::pooled::cpo&
+      pooled = asio_ext::pooled::static_instance<>::instance;
+} // namespace execution
+} // namespace asio
+
+#if !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Sender, class Receiver>
+struct start_member<asio_ext::pooled::detail::operation_state<Sender, Receiver>>
+{
+    ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+    ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+    typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+#endif // !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Sender, typename Receiver>
+struct connect_member<asio_ext::pooled::detail::sender<Sender>, Receiver>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef typename asio_ext::pooled::detail::operation_state<
+      typename asio_ext::pooled::detail::sender<Sender>::sender_type,
+      asio_ext::remove_cvref_t<Receiver>> result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
@@ -0,0 +1,294 @@
+
+//          Copyright Andreas Wass 2004 - 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <asio/execution/connect.hpp>
+#include <asio/execution/start.hpp>
+
+#include <asio_ext/detail/idle_waiters.hpp>
+#include <asio_ext/detail/mpsc_queue.hpp>
+#include <asio_ext/detail/schedule_operation.hpp>
+#include <asio_ext/type_traits.hpp>
+
+namespace asio_ext
+{
+    class priority_context;
+
+    namespace priority_detail
+    {
+        struct task : asio_ext::detail::mpsc_node, asio_ext::detail::schedule_task<task>
+        {
+        };
+
+        template <class Receiver>
+        struct operation : asio_ext::detail::schedule_operation<task, Receiver>
+        {
+            priority_context* context_;
+            std::size_t lane_;
+
+            template <class Rx>
+            operation(priority_context* context, std::size_t lane, Rx&& rx)
+                : asio_ext::detail::schedule_operation<task, Receiver>(std::forward<Rx>(rx)), context_(context),
+                lane_(lane) {
+            }
+
+            inline void start() ASIO_NOEXCEPT;
+        };
+
+        struct sender : asio_ext::detail::schedule_sender
+        {
+            sender(priority_context* context, std::size_t lane) noexcept : context_(context), lane_(lane) {}
+
+            priority_context* context_;
+            std::size_t lane_;
+
+            template <class Receiver>
+            auto connect(Receiver&& recv) const {
+                return operation<asio_ext::remove_cvref_t<Receiver>>(context_, lane_, std::forward<Receiver>(recv));
+            }
+        };
+    } // namespace priority_detail
+
+    // An execution context with one queue per priority lane, lane 0 being the most
+    // urgent. Starting an operation pushes it onto its lane's lock-free queue. The
+    // threads calling run() pick work by weighted round-robin: each round a lane
+    // completes up to its weight in operations, the most urgent lane with work and
+    // weight left first, and a new round starts once no such lane is left. A lane with
+    // queued work therefore waits at most the sum of the other lanes' weights.
+    // Operations still queued when the context is destroyed complete with set_done.
+    class priority_context
+    {
+    public:
+        class scheduler_type;
+
+        explicit priority_context(std::vector<std::size_t> weights = { 8, 4, 1 })
+            : weights_(std::move(weights)), credits_(weights_) {
+            if (weights_.empty()) {
+                throw std::invalid_argument("asio_ext::priority_context: no lanes");
+            }
+            for (auto weight : weights_) {
+                if (weight == 0) {
+                    throw std::invalid_argument("asio_ext::priority_context: a lane needs a weight");
+                }
+            }
+            lanes_ = std::make_unique<asio_ext::detail::mpsc_queue[]>(weights_.size());
+        }
+
+        priority_context(const priority_context&) = delete;
+        priority_context& operator=(const priority_context&) = delete;
+
+        ~priority_context() {
+            for (std::size_t lane = 0; lane < weights_.size(); ++lane) {
+                while (auto* t = lanes_[lane].pop()) {
+                    static_cast<priority_detail::task*>(t)->complete_(static_cast<priority_detail::task*>(t), false);
+                }
+            }
+        }
+
+        // A scheduler for lane, its schedule() completes there.
+        inline scheduler_type get_scheduler(std::size_t lane = 0);
+
+        std::size_t lane_count() const noexcept {
+            return weights_.size();
+        }
+
+        // Runs queued operations, waiting for more, until stop() is called. Returns the
+        // number of operations completed.
+        std::size_t run() {
+            std::size_t count = 0;
+            while (!stopped_.load(std::memory_order_acquire)) {
+                if (auto* t = next()) {
+                    t->complete_(t, true);
+                    ++count;
+                }
+                else {
+                    wait();
+                }
+            }
+            return count;
+        }
+
+        // Runs the operations that are queued without waiting for more.
+        std::size_t poll() {
+            std::size_t count = 0;
+            while (!stopped_.load(std::memory_order_acquire)) {
+                auto* t = next();
+                if (!t) {
+                    break;
+                }
+                t->complete_(t, true);
+                ++count;
+            }
+            return count;
+        }
+
+        // Makes run() and poll() return as soon as possible, queued work stays queued.
+        void stop() {
+            idle_.notify_all([this] {
+                stopped_.store(true, std::memory_order_release);
+            });
+        }
+
+        bool stopped() const noexcept {
+            return stopped_.load(std::memory_order_acquire);
+        }
+
+        void restart() noexcept {
+            stopped_.store(false, std::memory_order_release);
+        }
+
+        void submit(priority_detail::task* t, std::size_t lane) noexcept {
+            lanes_[lane].push(t);
+            queued_.fetch_add(1);
+            idle_.notify_one();
+        }
+
+    private:
+        priority_detail::task* next() {
+            std::lock_guard<std::mutex> lock(dispatch_mutex_);
+            if (queued_.load() == 0) {
+                return nullptr;
+            }
+            for (;;) {
+                for (std::size_t lane = 0; lane < weights_.size(); ++lane) {
+                    if (credits_[lane] == 0) {
+                        continue;
+                    }
+                    if (auto* t = lanes_[lane].pop()) {
+                        --credits_[lane];
+                        queued_.fetch_sub(1);
+                        return static_cast<priority_detail::task*>(t);
+                    }
+                }
+                // No lane with weight left has work, start the next round. When a full
+                // round finds nothing a producer is half way through a push.
+                if (credits_ == weights_) {
+                    std::this_thread::yield();
+                }
+                credits_ = weights_;
+            }
+        }
+
+        void wait() {
+            idle_.wait([this] {
+                return queued_.load() > 0 || stopped_.load(std::memory_order_relaxed);
+            });
+        }
+
+        std::vector<std::size_t> weights_;
+        std::unique_ptr<asio_ext::detail::mpsc_queue[]> lanes_;
+        // Guards popping (the lanes have a single consumer) and the round's credits
+        std::mutex dispatch_mutex_;
+        std::vector<std::size_t> credits_;
+        std::atomic<std::size_t> queued_{ 0 };
+        asio_ext::detail::idle_waiters idle_;
+        std::atomic<bool> stopped_{ false };
+    };
+
+    class priority_context::scheduler_type
+    {
+    public:
+        scheduler_type(priority_context& context, std::size_t lane) noexcept : context_(&context), lane_(lane) {}
+
+        // Completes on the thread running the context, from this scheduler's lane.
+        priority_detail::sender schedule() const noexcept {
+            return { context_, lane_ };
+        }
+
+        // Completes on the thread running the context, from lane.
+        priority_detail::sender schedule(std::size_t lane) const {
+            return { context_, checked(lane) };
+        }
+
+        // The same context on another lane, for on() and via().
+        scheduler_type with_priority(std::size_t lane) const {
+            return scheduler_type(*context_, checked(lane));
+        }
+
+        std::size_t priority() const noexcept {
+            return lane_;
+        }
+
+        priority_context& get_context() const noexcept {
+            return *context_;
+        }
+
+        friend bool operator==(const scheduler_type& lhs, const scheduler_type& rhs) noexcept {
+            return lhs.context_ == rhs.context_ && lhs.lane_ == rhs.lane_;
+        }
+
+        friend bool operator!=(const scheduler_type& lhs, const scheduler_type& rhs) noexcept {
+            return !(lhs == rhs);
+        }
+
+    private:
+        std::size_t checked(std::size_t lane) const {
+            if (lane >= context_->lane_count()) {
+                throw std::out_of_range("asio_ext::priority_context: no such lane");
+            }
+            return lane;
+        }
+
+        priority_context* context_;
+        std::size_t lane_;
+    };
+
+    inline priority_context::scheduler_type priority_context::get_scheduler(std::size_t lane) {
+        return scheduler_type(*this, 0).with_priority(lane);
+    }
+
+    template <class Receiver>
+    inline void priority_detail::operation<Receiver>::start() ASIO_NOEXCEPT {
+        this->arm();
+        context_->submit(this, lane_);
+    }
+} // namespace asio_ext
+
+#if !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Receiver>
+struct start_member<asio_ext::priority_detail::operation<Receiver>>
+{
+    ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+    ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+    typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+#endif // !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <typename Receiver>
+struct connect_member<asio_ext::priority_detail::sender, Receiver>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef typename asio_ext::priority_detail::operation<
+      asio_ext::remove_cvref_t<Receiver>> result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
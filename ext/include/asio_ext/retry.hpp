@@ -0,0 +1,347 @@
+
+//          Copyright Andreas Wass 2004 - 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <random>
+#include <utility>
+#include <variant>
+
+#include <asio/execution/connect.hpp>
+#include <asio/execution/set_done.hpp>
+#include <asio/execution/set_error.hpp>
+#include <asio/execution/set_value.hpp>
+#include <asio/execution/start.hpp>
+
+#include <asio_ext/schedule_after.hpp>
+#include <asio_ext/sender_traits.hpp>
+#include <asio_ext/type_traits.hpp>
+
+namespace asio_ext
+{
+    // How often and how patiently retry() restarts a failing operation. The n:th backoff
+    // is initial_delay * multiplier^(n - 1), capped at max_delay, of which up to the
+    // jitter fraction is randomly shaved off so that clients failing together do not
+    // retry together.
+    struct retry_policy
+    {
+        std::size_t max_attempts = 3;
+        std::chrono::steady_clock::duration initial_delay = std::chrono::milliseconds(10);
+        double multiplier = 2.0;
+        std::chrono::steady_clock::duration max_delay = std::chrono::seconds(1);
+        double jitter = 0.5;
+        // No attempt is started after this much time has passed since start
+        std::chrono::steady_clock::duration max_elapsed = std::chrono::steady_clock::duration::max();
+    };
+
+    namespace retry
+    {
+        namespace detail
+        {
+            template <class Executor, class Factory, class Receiver>
+            struct operation;
+
+            template <class Executor, class Factory, class Receiver>
+            struct attempt_receiver
+            {
+                operation<Executor, Factory, Receiver>* op_;
+
+                template <class... Values>
+                void set_value(Values&&... values) {
+                    asio::execution::set_value(std::move(op_->receiver_), std::forward<Values>(values)...);
+                }
+
+                template <class E>
+                void set_error(E&& e) noexcept {
+                    op_->on_error(std::forward<E>(e));
+                }
+
+                void set_done() noexcept {
+                    asio::execution::set_done(std::move(op_->receiver_));
+                }
+            };
+
+            template <class Executor, class Factory, class Receiver>
+            struct backoff_receiver
+            {
+                operation<Executor, Factory, Receiver>* op_;
+
+                void set_value() {
+                    op_->start_attempt();
+                }
+
+                template <class E>
+                void set_error(E&& e) noexcept {
+                    asio::execution::set_error(std::move(op_->receiver_), std::forward<E>(e));
+                }
+
+                void set_done() noexcept {
+                    asio::execution::set_done(std::move(op_->receiver_));
+                }
+            };
+
+            template <class Executor, class Factory, class Receiver>
+            struct operation
+            {
+                using clock_type = std::chrono::steady_clock;
+                using attempt_sender_type = decltype(std::declval<Factory&>()());
+                using attempt_operation_type = asio::execution::connect_result_t<
+                    attempt_sender_type, attempt_receiver<Executor, Factory, Receiver>>;
+                using backoff_operation_type = asio::execution::connect_result_t<
+                    schedule_after::detail::sender<Executor>, backoff_receiver<Executor, Factory, Receiver>>;
+
+                Executor executor_;
+                Factory factory_;
+                retry_policy policy_;
+                Receiver receiver_;
+                std::size_t attempts_ = 0;
+                clock_type::time_point started_;
+                std::minstd_rand random_;
+                bool cancelled_ = false;
+                // The attempt and the backoff timer are reconnected in place, retrying never allocates
+                std::variant<std::monostate, attempt_operation_type, backoff_operation_type> state_;
+
+                template <class Rx>
+                operation(const Executor& ex, Factory&& factory, const retry_policy& policy, Rx&& rx)
+                    : executor_(ex), factory_(std::move(factory)), policy_(policy), receiver_(std::forward<Rx>(rx)) {
+                }
+
+                void start() ASIO_NOEXCEPT {
+                    started_ = clock_type::now();
+                    random_.seed(static_cast<std::uint_fast32_t>(
+                        started_.time_since_epoch().count() ^ reinterpret_cast<std::uintptr_t>(this)));
+                    start_attempt();
+                }
+
+                // Stops retrying, a pending backoff completes with set_done and a running attempt
+                // completes normally but is not retried. Must be called on the executor and not
+                // concurrently with the operation's completion.
+                void cancel() {
+                    cancelled_ = true;
+                    if (auto* backoff = std::get_if<2>(&state_)) {
+                        backoff->cancel();
+                    }
+                }
+
+                void start_attempt() {
+                    try {
+                        ++attempts_;
+                        auto& attempt = state_.template emplace<1>(asio::execution::connect(
+                            factory_(), attempt_receiver<Executor, Factory, Receiver>{this}));
+                        asio::execution::start(attempt);
+                    }
+                    catch (...) {
+                        asio::execution::set_error(std::move(receiver_), std::current_exception());
+                    }
+                }
+
+                template <class E>
+                void on_error(E&& e) noexcept {
+                    // e may live in the attempt's operation state which is replaced below
+                    auto error = asio_ext::decay_copy(std::forward<E>(e));
+                    try {
+                        auto delay = next_delay();
+                        auto elapsed = clock_type::now() - started_;
+                        if (cancelled_ || attempts_ >= policy_.max_attempts || delay > policy_.max_elapsed ||
+                            elapsed > policy_.max_elapsed - delay) {
+                            asio::execution::set_error(std::move(receiver_), std::move(error));
+                            return;
+                        }
+                        auto& backoff = state_.template emplace<2>(asio::execution::connect(
+                            asio::execution::schedule_after(executor_, delay),
+                            backoff_receiver<Executor, Factory, Receiver>{this}));
+                        asio::execution::start(backoff);
+                    }
+                    catch (...) {
+                        asio::execution::set_error(std::move(receiver_), std::current_exception());
+                    }
+                }
+
+                clock_type::duration next_delay() {
+                    using double_duration = std::chrono::duration<double, clock_type::period>;
+                    double_duration delay = policy_.initial_delay;
+                    for (std::size_t i = 1; i < attempts_ && delay < policy_.max_delay; ++i) {
+                        delay *= policy_.multiplier;
+                    }
+                    delay = std::min<double_duration>(delay, policy_.max_delay);
+                    std::uniform_real_distribution<double> distribution(0.0, std::clamp(policy_.jitter, 0.0, 1.0));
+                    return std::chrono::duration_cast<clock_type::duration>(delay * (1.0 - distribution(random_)));
+                }
+            };
+
+            template <class Executor, class Factory>
+            struct sender
+            {
+                using attempt_sender_type = decltype(std::declval<Factory&>()());
+
+                template <template <class...> class Tuple, template <class...> class Variant>
+                using value_types =
+                    typename asio::execution::sender_traits<attempt_sender_type>::template value_types<Tuple, Variant>;
+
+                template <template <class...> class Variant>
+                using error_types = asio_ext::append_error_types<Variant, attempt_sender_type, std::exception_ptr>;
+
+                static constexpr bool sends_done = true;
+
+                Executor executor_;
+                Factory factory_;
+                retry_policy policy_;
+
+                template <class Receiver>
+                auto connect(Receiver&& recv) {
+                    return operation<Executor, Factory, asio_ext::remove_cvref_t<Receiver>>(
+                        executor_, std::move(factory_), policy_, std::forward<Receiver>(recv));
+                }
+            };
+        } // namespace detail
+
+        struct cpo
+        {
+            // Connects and starts factory() until it completes with a value or done, backing
+            // off on ex between attempts. Once the policy gives up the last error is forwarded.
+            template <class Executor, class Factory>
+            auto operator()(const Executor& ex, Factory&& factory, const retry_policy& policy = {}) const {
+                return detail::sender<Executor, asio_ext::remove_cvref_t<Factory>>{
+                    ex, std::forward<Factory>(factory), policy};
+            }
+        };
+
+        template <typename T = cpo>
+        struct static_instance
+        {
+            static const T instance;
+        };
+
+        template <typename T>
+        const T static_instance<T>::instance = {};
+    }
+} // namespace asio_ext
+
+namespace asio {
+namespace execution {
+static ASIO_CONSTEXPR const asio_ext::retry::cpo&
+      retry = asio_ext::retry::static_instance<>::instance;
+} // namespace execution
+} // namespace asio
+
+#if !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Executor, class Factory, class Receiver>
+struct start_member<asio_ext::retry::detail::operation<Executor, Factory, Receiver>>
+{
+    ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+    ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+    typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+#endif // !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Executor, class Factory, typename Receiver>
+struct connect_member<asio_ext::retry::detail::sender<Executor, Factory>, Receiver>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef typename asio_ext::retry::detail::operation<
+      Executor, Factory, asio_ext::remove_cvref_t<Receiver>> result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_VALUE_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Executor, class Factory, class Receiver, class... Values>
+struct set_value_member<asio_ext::retry::detail::attempt_receiver<Executor, Factory, Receiver>, void(Values...)>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef void result_type;
+};
+
+template <class Executor, class Factory, class Receiver>
+struct set_value_member<asio_ext::retry::detail::backoff_receiver<Executor, Factory, Receiver>, void()>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_VALUE_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_ERROR_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Executor, class Factory, class Receiver, class E>
+struct set_error_member<asio_ext::retry::detail::attempt_receiver<Executor, Factory, Receiver>, E>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+template <class Executor, class Factory, class Receiver, class E>
+struct set_error_member<asio_ext::retry::detail::backoff_receiver<Executor, Factory, Receiver>, E>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_ERROR_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_DONE_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Executor, class Factory, class Receiver>
+struct set_done_member<asio_ext::retry::detail::attempt_receiver<Executor, Factory, Receiver>>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+template <class Executor, class Factory, class Receiver>
+struct set_done_member<asio_ext::retry::detail::backoff_receiver<Executor, Factory, Receiver>>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_DONE_MEMBER_TRAIT)
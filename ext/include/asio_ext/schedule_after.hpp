@@ -0,0 +1,145 @@
+
+//          Copyright Andreas Wass 2004 - 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <chrono>
+#include <exception>
+#include <utility>
+
+#include <asio/basic_waitable_timer.hpp>
+#include <asio/error_code.hpp>
+#include <asio/execution/connect.hpp>
+#include <asio/execution/set_error.hpp>
+#include <asio/execution/start.hpp>
+#include <asio/wait_traits.hpp>
+
+#include <asio_ext/detail/complete_operation.hpp>
+#include <asio_ext/type_traits.hpp>
+
+namespace asio_ext
+{
+    namespace schedule_after
+    {
+        namespace detail
+        {
+            template <class Executor>
+            using timer_type = asio::basic_waitable_timer<
+                std::chrono::steady_clock, asio::wait_traits<std::chrono::steady_clock>, Executor>;
+
+            template <class Executor, class Receiver>
+            struct operation
+            {
+                Receiver receiver_;
+                timer_type<Executor> timer_;
+                std::chrono::steady_clock::duration duration_;
+
+                template <class Rx>
+                operation(Rx&& rx, const Executor& ex, std::chrono::steady_clock::duration duration)
+                    : receiver_(std::forward<Rx>(rx)), timer_(ex), duration_(duration) {
+                }
+
+                void start() ASIO_NOEXCEPT {
+                    try {
+                        timer_.expires_after(duration_);
+                        timer_.async_wait([this](const asio::error_code& ec) {
+                            asio_ext::detail::complete_operation(receiver_, ec);
+                        });
+                    }
+                    catch (...) {
+                        asio::execution::set_error(std::move(receiver_), std::current_exception());
+                    }
+                }
+
+                // Aborts a started wait, the receiver is then completed with set_done.
+                // Must not be called concurrently with the timer's completion handler.
+                void cancel() {
+                    timer_.cancel();
+                }
+            };
+
+            template <class Executor>
+            struct sender
+            {
+                template <template <class...> class Tuple, template <class...> class Variant>
+                using value_types = Variant<Tuple<>>;
+                template <template <class...> class Variant>
+                using error_types = Variant<std::exception_ptr>;
+                static constexpr bool sends_done = true;
+
+                Executor executor_;
+                std::chrono::steady_clock::duration duration_;
+
+                template <class Receiver>
+                auto connect(Receiver&& recv) const {
+                    return operation<Executor, asio_ext::remove_cvref_t<Receiver>>(
+                        std::forward<Receiver>(recv), executor_, duration_);
+                }
+            };
+        } // namespace detail
+
+        struct cpo
+        {
+            template <class Executor, class Rep, class Period>
+            auto operator()(const Executor& ex, std::chrono::duration<Rep, Period> duration) const {
+                return detail::sender<Executor>{
+                    ex, std::chrono::duration_cast<std::chrono::steady_clock::duration>(duration)};
+            }
+        };
+
+        template <typename T = cpo>
+        struct static_instance
+        {
+            static const T instance;
+        };
+
+        template <typename T>
+        const T static_instance<T>::instance = {};
+    }
+} // namespace asio_ext
+
+namespace asio {
+namespace execution {
+static ASIO_CONSTEXPR const asio_ext::schedule_after::cpo&
+      schedule_after = asio_ext::schedule_after::static_instance<>::instance;
+} // namespace execution
+} // namespace asio
+
+#if !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Executor, class Receiver>
+struct start_member<asio_ext::schedule_after::detail::operation<Executor, Receiver>>
+{
+    ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+    ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+    typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+#endif // !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Executor, typename Receiver>
+struct connect_member<asio_ext::schedule_after::detail::sender<Executor>, Receiver>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef typename asio_ext::schedule_after::detail::operation<
+      Executor, asio_ext::remove_cvref_t<Receiver>> result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
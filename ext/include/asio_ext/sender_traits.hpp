@@ -6,7 +6,9 @@
 
 #pragma once
 
+#include <cstddef>
 #include <type_traits>
+#include <asio/execution/connect.hpp>
 #include <boost/mp11/algorithm.hpp>
 #include <asio_ext/type_traits.hpp>
 #include <tuple>
@@ -125,4 +127,14 @@ namespace asio_ext
 
     template<template<class...> class Variant, class Function, class Sender>
     using function_result_types = typename detail::function_result_types_helper<Variant, Function>::template sender_results<Sender>;
+
+    // Size of the operation state produced by connecting Sender to Receiver. Usable in
+    // static_assert to keep adaptors from growing unnoticed.
+    template<class Sender, class Receiver>
+    struct op_state_size
+        : std::integral_constant<std::size_t, sizeof(asio::execution::connect_result_t<Sender, Receiver>)>
+    {};
+
+    template<class Sender, class Receiver>
+    constexpr std::size_t op_state_size_v = op_state_size<Sender, Receiver>::value;
 } // namespace asio_ext
\ No newline at end of file
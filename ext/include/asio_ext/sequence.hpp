@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <exception>
 #include <tuple>
 #include <utility>
@@ -18,6 +19,9 @@
 #include <asio/execution/start.hpp>
 #include <asio/execution/submit.hpp>
 
+#include <boost/mp11/algorithm.hpp>
+#include <boost/mp11/list.hpp>
+
 #include <asio_ext/sender_traits.hpp>
 
 namespace asio_ext
@@ -26,20 +30,16 @@ namespace asio_ext
     {
         namespace detail
         {
-            template <class S1, class S2, class Receiver>
+            template <class Receiver, class... Senders>
             struct operation_state;
 
-            template <class S1, class S2, class Receiver>
-            struct second_receiver
+            template <std::size_t I, class Receiver, class... Senders>
+            struct step_receiver
             {
-                operation_state<S1, S2, Receiver>* state_;
-
-                second_receiver(operation_state<S1, S2, Receiver>* state) : state_(state) {}
+                operation_state<Receiver, Senders...>* state_;
 
                 template <class... Values>
-                void set_value(Values &&... values) {
-                    asio::execution::set_value(std::move(state_->receiver_), std::forward<Values>(values)...);
-                }
+                inline void set_value(Values &&... values);
 
                 void set_done() {
                     asio::execution::set_done(std::move(state_->receiver_));
@@ -51,99 +51,79 @@ namespace asio_ext
                 }
             };
 
-            template <class S1, class S2, class Receiver>
-            struct first_receiver
+            // Runs the senders one after another. Only the running step is connected, each
+            // step replaces the previous one in state_ so the size and the cost of advancing
+            // do not depend on the number of steps.
+            template <class Receiver, class... Senders>
+            struct operation_state
             {
-                operation_state<S1, S2, Receiver>* state_;
+                template <std::size_t... Is>
+                static auto state_type_for(std::index_sequence<Is...>) -> std::variant<std::monostate,
+                    asio::execution::connect_result_t<Senders, step_receiver<Is, Receiver, Senders...>>...>;
 
-                first_receiver(operation_state<S1, S2, Receiver>* state) : state_(state) {}
+                using state_type = decltype(state_type_for(std::index_sequence_for<Senders...>{}));
 
-                template <class... Values>
-                inline void set_value(Values &&...);
-
-                void set_done() {
-                    asio::execution::set_done(std::move(state_->receiver_));
+                template <class Rx>
+                operation_state(std::tuple<Senders...>&& senders, Rx&& receiver)
+                    : senders_(std::move(senders)), receiver_(std::forward<Rx>(receiver)) {
                 }
 
-                template <class E>
-                void set_error(E&& error) {
-                    asio::execution::set_error(std::move(state_->receiver_), std::forward<E>(error));
-                }
-            };
-
-            template <class S1, class S2, class Receiver>
-            struct operation_state
-            {
-                operation_state(S1&& first, S2&& second, Receiver receiver)
-                    : first_sender_(std::move(first)), second_sender_(std::move(second)),
-                    receiver_(std::move(receiver)), state_(std::in_place_index<2>) {
+                void start() ASIO_NOEXCEPT {
+                    start_step<0>();
                 }
 
-                void start() ASIO_NOEXCEPT {
-                    auto& ref = state_.template emplace<0>(
-                        asio::execution::connect(
-                            std::move(first_sender_), 
-                            first_receiver<S1, S2, Receiver>(this)));
-                    asio::execution::start(ref);
+                template <std::size_t I>
+                void start_step() ASIO_NOEXCEPT {
+                    try {
+                        auto& ref = state_.template emplace<I + 1>(asio::execution::connect(
+                            std::move(std::get<I>(senders_)), step_receiver<I, Receiver, Senders...>{this}));
+                        asio::execution::start(ref);
+                    }
+                    catch (...) {
+                        asio::execution::set_error(std::move(receiver_), std::current_exception());
+                    }
                 }
 
-                using first_connect_type = asio_ext::remove_cvref_t<decltype(
-                    asio::execution::connect(
-                        std::declval<S1&&>(), 
-                        std::declval<first_receiver<S1, S2, Receiver>&&>()))>;
-                using second_connect_type = asio_ext::remove_cvref_t<decltype(
-                    asio::execution::connect(
-                        std::declval<S2&>(), 
-                        std::declval<second_receiver<S1, S2, Receiver>&&>()))>;
-                asio_ext::remove_cvref_t<S1> first_sender_;
-                asio_ext::remove_cvref_t<S2> second_sender_;
+                std::tuple<Senders...> senders_;
                 Receiver receiver_;
-                std::variant<first_connect_type, second_connect_type, std::monostate> state_;
+                state_type state_;
             };
 
-            template <class S1, class S2, class Receiver>
+            template <std::size_t I, class Receiver, class... Senders>
             template <class... Values>
-            void first_receiver<S1, S2, Receiver>::set_value(Values &&...) {
-                // this will be destroyed below! Only use local variables!!!
-                auto* state = state_;
-                try {
-                    auto& ref = state->state_.template emplace<1>(
-                        asio::execution::connect(state_->second_sender_, second_receiver(state)));
-                    auto index = state->state_.index();
-                    auto valueless = state->state_.valueless_by_exception();
-                    asio::execution::start(ref);
+            void step_receiver<I, Receiver, Senders...>::set_value(Values &&... values) {
+                if constexpr (I + 1 < sizeof...(Senders)) {
+                    // Starting the next step destroys this receiver, only use locals!
+                    auto* state = state_;
+                    state->template start_step<I + 1>();
                 }
-                catch (...) {
-                    asio::execution::set_error(std::move(state->receiver_), std::current_exception());
+                else {
+                    asio::execution::set_value(std::move(state_->receiver_), std::forward<Values>(values)...);
                 }
             }
 
             template <class... Senders>
-            struct sequence_sender;
-
-            template <class S1, class S2>
-            struct sequence_sender<S1, S2>
+            struct sequence_sender
             {
+                using last_sender_type = boost::mp11::mp_back<boost::mp11::mp_list<Senders...>>;
+
                 template <template <class...> class Tuple, template <class...> class Variant>
-                using value_types = typename asio::execution::sender_traits<S2>::template value_types<Tuple, Variant>;
+                using value_types =
+                    typename asio::execution::sender_traits<last_sender_type>::template value_types<Tuple, Variant>;
 
                 template <template <class...> class Variant>
-                using error_types = asio_ext::append_error_types<Variant, S2, std::exception_ptr>;
-
-                static constexpr bool sends_done = asio::execution::sender_traits<S2>::sends_done;
+                using error_types = boost::mp11::mp_unique<boost::mp11::mp_append<
+                    typename asio::execution::sender_traits<Senders>::template error_types<Variant>...,
+                    Variant<std::exception_ptr>>>;
 
-                asio_ext::remove_cvref_t<S1> first_;
-                asio_ext::remove_cvref_t<S2> second_;
+                static constexpr bool sends_done = (asio::execution::sender_traits<Senders>::sends_done || ...);
 
-                template <class T1, class T2>
-                sequence_sender(T1&& t1, T2&& t2)
-                    : first_(std::move_if_noexcept(t1)), second_(std::move_if_noexcept(t2)) {
-                }
+                std::tuple<Senders...> senders_;
 
                 template <class Receiver>
                 auto connect(Receiver&& receiver) {
-                    return operation_state<S1, S2, asio_ext::remove_cvref_t<Receiver>>(
-                        std::move(first_), std::move(second_), std::move(receiver));
+                    return operation_state<asio_ext::remove_cvref_t<Receiver>, Senders...>(
+                        std::move(senders_), std::forward<Receiver>(receiver));
                 }
             };
         } // namespace detail
@@ -155,12 +135,13 @@ namespace asio_ext
                 return std::forward<Sender>(sender);
             }
 
-            template <class S1, class... Senders>
-            auto operator()(S1&& s1, Senders &&... senders) const {
-                using next_type = decltype(cpo{}(std::forward<Senders>(senders)...));
-                return detail::sequence_sender<asio_ext::remove_cvref_t<S1>,
-                    asio_ext::remove_cvref_t<next_type>>(
-                        std::forward<S1>(s1), next_type(std::forward<Senders>(senders)...));
+            template <class S1, class S2, class... Senders>
+            auto operator()(S1&& s1, S2&& s2, Senders &&... senders) const {
+                using sender_type = detail::sequence_sender<asio_ext::remove_cvref_t<S1>,
+                    asio_ext::remove_cvref_t<S2>, asio_ext::remove_cvref_t<Senders>...>;
+                return sender_type{ std::tuple<asio_ext::remove_cvref_t<S1>, asio_ext::remove_cvref_t<S2>,
+                    asio_ext::remove_cvref_t<Senders>...>(
+                    std::forward<S1>(s1), std::forward<S2>(s2), std::forward<Senders>(senders)...) };
             }
         };
 
@@ -187,8 +168,8 @@ static ASIO_CONSTEXPR const asio_ext::sequence::cpo&
 namespace asio {
 namespace traits {
 
-template <class S1, class S2, class Receiver>
-struct start_member<asio_ext::sequence::detail::operation_state<S1, S2, Receiver>>
+template <class Receiver, class... Senders>
+struct start_member<asio_ext::sequence::detail::operation_state<Receiver, Senders...>>
 {
     ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
     ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
@@ -204,13 +185,13 @@ struct start_member<asio_ext::sequence::detail::operation_state<S1, S2, Receiver
 namespace asio {
 namespace traits {
 
-template <class S1, class S2, typename R>
-struct connect_member<asio_ext::sequence::detail::sequence_sender<S1, S2>, R>
+template <class... Senders, typename R>
+struct connect_member<asio_ext::sequence::detail::sequence_sender<Senders...>, R>
 {
   ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
   ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
   typedef typename 
-      asio_ext::sequence::detail::operation_state<S1, S2, asio_ext::remove_cvref_t<R>> result_type;
+      asio_ext::sequence::detail::operation_state<asio_ext::remove_cvref_t<R>, Senders...> result_type;
 };
 
 } // namespace traits
@@ -223,22 +204,14 @@ struct connect_member<asio_ext::sequence::detail::sequence_sender<S1, S2>, R>
 namespace asio {
 namespace traits {
 
-template <class S1, class S2, class Receiver, class... Values>
-struct set_value_member<asio_ext::sequence::detail::first_receiver<S1, S2, Receiver>, void(Values...)>
+template <std::size_t I, class Receiver, class... Senders, class... Values>
+struct set_value_member<asio_ext::sequence::detail::step_receiver<I, Receiver, Senders...>, void(Values...)>
 {
   ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
   ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
   typedef void result_type;
 };
 
-template <class S1, class S2, class Receiver, class... Values>
-struct set_value_member<asio_ext::sequence::detail::second_receiver<S1, S2, Receiver>, void(Values...)>
-{
-    ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
-    ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
-    typedef void result_type;
-};
-
 } // namespace traits
 } // namespace asio
 
@@ -249,22 +222,14 @@ struct set_value_member<asio_ext::sequence::detail::second_receiver<S1, S2, Rece
 namespace asio {
 namespace traits {
 
-template <class S1, class S2, class Receiver, class E>
-struct set_error_member<asio_ext::sequence::detail::first_receiver<S1, S2, Receiver>, E>
+template <std::size_t I, class Receiver, class... Senders, class E>
+struct set_error_member<asio_ext::sequence::detail::step_receiver<I, Receiver, Senders...>, E>
 {
   ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
   ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
   typedef void result_type;
 };
 
-template <class S1, class S2, class Receiver, class E>
-struct set_error_member<asio_ext::sequence::detail::second_receiver<S1, S2, Receiver>, E>
-{
-    ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
-    ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
-    typedef void result_type;
-};
-
 } // namespace traits
 } // namespace asio
 
@@ -275,22 +240,14 @@ struct set_error_member<asio_ext::sequence::detail::second_receiver<S1, S2, Rece
 namespace asio {
 namespace traits {
 
-template <class S1, class S2, class Receiver>
-struct set_done_member<asio_ext::sequence::detail::first_receiver<S1, S2, Receiver>>
+template <std::size_t I, class Receiver, class... Senders>
+struct set_done_member<asio_ext::sequence::detail::step_receiver<I, Receiver, Senders...>>
 {
   ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
   ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
   typedef void result_type;
 };
 
-template <class S1, class S2, class Receiver>
-struct set_done_member<asio_ext::sequence::detail::second_receiver<S1, S2, Receiver>>
-{
-    ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
-    ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
-    typedef void result_type;
-};
-
 } // namespace traits
 } // namespace asio
 
@@ -0,0 +1,200 @@
+
+//          Copyright Andreas Wass 2004 - 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include <asio/buffer.hpp>
+
+namespace asio_ext
+{
+    class buffer_slab;
+
+    // Reference counted handle to one chunk of a buffer_slab.
+    // Copying a handle shares the chunk, the payload itself is never copied. The chunk
+    // is handed back to the slab when the last handle referring to it is destroyed.
+    // A slab_buffer is both a MutableBufferSequence and a ConstBufferSequence, and
+    // converts to asio::mutable_buffer so a range of handles forms a gather list.
+    class slab_buffer
+    {
+    public:
+        using value_type = asio::mutable_buffer;
+        using const_iterator = const asio::mutable_buffer*;
+
+        slab_buffer() = default;
+        inline slab_buffer(const slab_buffer& other) noexcept;
+        slab_buffer(slab_buffer&& other) noexcept
+            : slab_(std::exchange(other.slab_, nullptr)), index_(other.index_),
+            view_(std::exchange(other.view_, asio::mutable_buffer())) {
+        }
+
+        slab_buffer& operator=(slab_buffer other) noexcept {
+            std::swap(slab_, other.slab_);
+            std::swap(index_, other.index_);
+            std::swap(view_, other.view_);
+            return *this;
+        }
+
+        inline ~slab_buffer();
+
+        void* data() const noexcept {
+            return view_.data();
+        }
+
+        std::size_t size() const noexcept {
+            return view_.size();
+        }
+
+        inline std::size_t capacity() const noexcept;
+
+        // Sets the number of valid bytes, e.g. after a read completed into the chunk.
+        void resize(std::size_t n) noexcept {
+            assert(n <= capacity());
+            view_ = asio::mutable_buffer(view_.data(), n);
+        }
+
+        inline long use_count() const noexcept;
+
+        explicit operator bool() const noexcept {
+            return slab_ != nullptr;
+        }
+
+        const_iterator begin() const noexcept {
+            return &view_;
+        }
+
+        const_iterator end() const noexcept {
+            return &view_ + 1;
+        }
+
+        operator asio::mutable_buffer() const noexcept {
+            return view_;
+        }
+
+        operator asio::const_buffer() const noexcept {
+            return view_;
+        }
+
+    private:
+        friend class buffer_slab;
+
+        slab_buffer(buffer_slab* slab, std::size_t index, asio::mutable_buffer view) noexcept
+            : slab_(slab), index_(index), view_(view) {
+        }
+
+        buffer_slab* slab_ = nullptr;
+        std::size_t index_ = 0;
+        asio::mutable_buffer view_;
+    };
+
+    // One contiguous, fixed size region split into equally sized chunks. Payloads are
+    // written once into a chunk and only slab_buffer handles travel through a pipeline.
+    // Since the region never moves it can be registered with the kernel up front.
+    class buffer_slab
+    {
+    public:
+        buffer_slab(std::size_t chunk_size, std::size_t chunk_count)
+            : chunk_size_(chunk_size), chunk_count_(chunk_count),
+            storage_(new unsigned char[chunk_size * chunk_count]),
+            refs_(new std::atomic<long>[chunk_count]) {
+            free_.reserve(chunk_count);
+            for (std::size_t i = chunk_count; i > 0; --i) {
+                free_.push_back(i - 1);
+            }
+        }
+
+        buffer_slab(const buffer_slab&) = delete;
+        buffer_slab& operator=(const buffer_slab&) = delete;
+
+        ~buffer_slab() {
+            assert(available() == chunk_count_ && "slab_buffer outlived its buffer_slab");
+        }
+
+        // Hands out a full size chunk, throws std::bad_alloc when every chunk is in use.
+        slab_buffer allocate() {
+            std::size_t index;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (free_.empty()) {
+                    throw std::bad_alloc();
+                }
+                index = free_.back();
+                free_.pop_back();
+            }
+            refs_[index].store(1, std::memory_order_relaxed);
+            return slab_buffer(this, index, asio::mutable_buffer(storage_.get() + index * chunk_size_, chunk_size_));
+        }
+
+        std::size_t chunk_size() const noexcept {
+            return chunk_size_;
+        }
+
+        std::size_t chunk_count() const noexcept {
+            return chunk_count_;
+        }
+
+        std::size_t available() const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return free_.size();
+        }
+
+        // The whole backing region.
+        asio::mutable_buffer region() const noexcept {
+            return asio::mutable_buffer(storage_.get(), chunk_size_ * chunk_count_);
+        }
+
+    private:
+        friend class slab_buffer;
+
+        void add_ref(std::size_t index) noexcept {
+            refs_[index].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void release(std::size_t index) noexcept {
+            if (refs_[index].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                // Capacity was reserved for every chunk up front, this never allocates
+                free_.push_back(index);
+            }
+        }
+
+        std::size_t chunk_size_;
+        std::size_t chunk_count_;
+        std::unique_ptr<unsigned char[]> storage_;
+        std::unique_ptr<std::atomic<long>[]> refs_;
+        mutable std::mutex mutex_;
+        std::vector<std::size_t> free_;
+    };
+
+    inline slab_buffer::slab_buffer(const slab_buffer& other) noexcept
+        : slab_(other.slab_), index_(other.index_), view_(other.view_) {
+        if (slab_) {
+            slab_->add_ref(index_);
+        }
+    }
+
+    inline slab_buffer::~slab_buffer() {
+        if (slab_) {
+            slab_->release(index_);
+        }
+    }
+
+    inline std::size_t slab_buffer::capacity() const noexcept {
+        return slab_ ? slab_->chunk_size() : 0;
+    }
+
+    inline long slab_buffer::use_count() const noexcept {
+        return slab_ ? slab_->refs_[index_].load(std::memory_order_relaxed) : 0;
+    }
+} // namespace asio_ext
@@ -0,0 +1,305 @@
+
+//          Copyright Andreas Wass 2004 - 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <variant>
+
+#include <asio/execution/connect.hpp>
+#include <asio/execution/set_done.hpp>
+#include <asio/execution/set_error.hpp>
+#include <asio/execution/set_value.hpp>
+#include <asio/execution/start.hpp>
+
+#include <asio_ext/detail/optional.hpp>
+#include <asio_ext/detail/waiter_list.hpp>
+#include <asio_ext/sender_traits.hpp>
+#include <asio_ext/type_traits.hpp>
+
+namespace asio_ext
+{
+    namespace split
+    {
+        namespace detail
+        {
+            using asio_ext::detail::waiter_base;
+
+            struct done_tag
+            {};
+
+            template <class Sender>
+            struct shared_state;
+
+            template <class Sender>
+            struct upstream_receiver
+            {
+                shared_state<Sender>* state_;
+
+                template <class... Values>
+                void set_value(Values&&... values) {
+                    state_->complete([&]() {
+                        try {
+                            state_->result_.template emplace<1>(
+                                std::tuple<asio_ext::remove_cvref_t<Values>...>(std::forward<Values>(values)...));
+                        }
+                        catch (...) {
+                            state_->result_.template emplace<2>(std::current_exception());
+                        }
+                    });
+                }
+
+                template <class E>
+                void set_error(E&& e) noexcept {
+                    state_->complete([&]() {
+                        state_->result_.template emplace<2>(std::forward<E>(e));
+                    });
+                }
+
+                void set_done() noexcept {
+                    state_->complete([&]() {
+                        state_->result_.template emplace<3>();
+                    });
+                }
+            };
+
+            template <class Sender>
+            struct shared_state
+            {
+                using upstream_operation_type = asio::execution::connect_result_t<Sender, upstream_receiver<Sender>>;
+                using values_type =
+                    typename asio::execution::sender_traits<Sender>::template value_types<std::tuple, std::variant>;
+                using errors_type = asio_ext::append_error_types<std::variant, Sender, std::exception_ptr>;
+
+                Sender sender_;
+                std::atomic_bool started_{ false };
+                asio_ext::detail::waiter_list waiters_;
+                // Keeps the state alive while the upstream runs, even if every consumer is gone
+                std::shared_ptr<shared_state> self_;
+                std::variant<std::monostate, values_type, errors_type, done_tag> result_;
+                asio_ext::optional<upstream_operation_type> upstream_;
+
+                template <class S>
+                explicit shared_state(S&& sender) : sender_(std::forward<S>(sender)) {}
+
+                void attach(waiter_base* waiter, const std::shared_ptr<shared_state>& self) noexcept {
+                    if (!waiters_.attach(waiter)) {
+                        return;
+                    }
+                    if (!started_.exchange(true, std::memory_order_acq_rel)) {
+                        self_ = self;
+                        try {
+                            upstream_.emplace(
+                                asio::execution::connect(std::move(sender_), upstream_receiver<Sender>{this}));
+                            asio::execution::start(*upstream_);
+                        }
+                        catch (...) {
+                            complete([&]() {
+                                result_.template emplace<2>(std::current_exception());
+                            });
+                        }
+                    }
+                }
+
+                template <class Store>
+                void complete(Store&& store) noexcept {
+                    auto keep_alive = std::move(self_);
+                    store();
+                    waiters_.notify_all();
+                }
+
+                template <class Receiver>
+                void deliver(Receiver& receiver) noexcept {
+                    if (auto* values = std::get_if<1>(&result_)) {
+                        try {
+                            std::visit([&](const auto& tuple) {
+                                std::apply([&](const auto&... vs) {
+                                    asio::execution::set_value(std::move(receiver), vs...);
+                                }, tuple);
+                            }, *values);
+                        }
+                        catch (...) {
+                            asio::execution::set_error(std::move(receiver), std::current_exception());
+                        }
+                    }
+                    else if (auto* error = std::get_if<2>(&result_)) {
+                        std::visit([&](const auto& e) {
+                            asio::execution::set_error(std::move(receiver), e);
+                        }, *error);
+                    }
+                    else {
+                        asio::execution::set_done(std::move(receiver));
+                    }
+                }
+            };
+
+            template <class Sender, class Receiver>
+            struct operation : waiter_base
+            {
+                std::shared_ptr<shared_state<Sender>> state_;
+                Receiver receiver_;
+
+                template <class Rx>
+                operation(std::shared_ptr<shared_state<Sender>> state, Rx&& rx)
+                    : state_(std::move(state)), receiver_(std::forward<Rx>(rx)) {
+                }
+
+                void start() ASIO_NOEXCEPT {
+                    notify_ = &operation::notify;
+                    state_->attach(this, state_);
+                }
+
+                static void notify(waiter_base* waiter) noexcept {
+                    auto* self = static_cast<operation*>(waiter);
+                    self->state_->deliver(self->receiver_);
+                }
+            };
+
+            template <class Sender>
+            struct sender
+            {
+                template <template <class...> class Tuple, template <class...> class Variant>
+                using value_types =
+                    typename asio::execution::sender_traits<Sender>::template value_types<Tuple, Variant>;
+
+                template <template <class...> class Variant>
+                using error_types = asio_ext::append_error_types<Variant, Sender, std::exception_ptr>;
+
+                static constexpr bool sends_done = asio::execution::sender_traits<Sender>::sends_done;
+
+                std::shared_ptr<shared_state<Sender>> state_;
+
+                template <class Receiver>
+                auto connect(Receiver&& recv) const {
+                    return operation<Sender, asio_ext::remove_cvref_t<Receiver>>(state_, std::forward<Receiver>(recv));
+                }
+            };
+        } // namespace detail
+
+        struct cpo
+        {
+            // The returned sender is copyable. The first copy to be started connects and starts
+            // sender, every started copy completes with a copy of its result, passed as const
+            // lvalues. Copies started after completion complete inline.
+            template <class Sender>
+            auto operator()(Sender&& sender) const {
+                using state_type = detail::shared_state<asio_ext::remove_cvref_t<Sender>>;
+                return detail::sender<asio_ext::remove_cvref_t<Sender>>{
+                    std::make_shared<state_type>(std::forward<Sender>(sender))};
+            }
+        };
+
+        template <typename T = cpo>
+        struct static_instance
+        {
+            static const T instance;
+        };
+
+        template <typename T>
+        const T static_instance<T>::instance = {};
+    }
+} // namespace asio_ext
+
+namespace asio {
+namespace execution {
+static ASIO_CONSTEXPR const asio_ext::split::cpo&
+      split = asio_ext::split::static_instance<>::instance;
+} // namespace execution
+} // namespace asio
+
+#if !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Sender, class Receiver>
+struct start_member<asio_ext::split::detail::operation<Sender, Receiver>>
+{
+    ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+    ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+    typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+#endif // !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Sender, typename Receiver>
+struct connect_member<asio_ext::split::detail::sender<Sender>, Receiver>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef typename asio_ext::split::detail::operation<
+      Sender, asio_ext::remove_cvref_t<Receiver>> result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_VALUE_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Sender, class... Values>
+struct set_value_member<asio_ext::split::detail::upstream_receiver<Sender>, void(Values...)>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_VALUE_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_ERROR_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Sender, class E>
+struct set_error_member<asio_ext::split::detail::upstream_receiver<Sender>, E>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_ERROR_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_DONE_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Sender>
+struct set_done_member<asio_ext::split::detail::upstream_receiver<Sender>>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_DONE_MEMBER_TRAIT)
@@ -0,0 +1,376 @@
+
+//          Copyright Andreas Wass 2004 - 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include <asio/execution/blocking.hpp>
+#include <asio/execution/connect.hpp>
+#include <asio/execution/schedule.hpp>
+#include <asio/execution/set_done.hpp>
+#include <asio/execution/set_error.hpp>
+#include <asio/execution/set_value.hpp>
+#include <asio/execution/start.hpp>
+#include <asio/prefer.hpp>
+
+#include <asio_ext/detail/mpsc_queue.hpp>
+#include <asio_ext/detail/optional.hpp>
+#include <asio_ext/type_traits.hpp>
+
+namespace asio_ext
+{
+    template <class Scheduler>
+    class strand;
+
+    namespace strand_detail
+    {
+        // A drain must never run inside the call scheduling it, or batches would nest
+        template <class Scheduler>
+        using never_blocking_t = std::decay_t<decltype(
+            asio::prefer(std::declval<const Scheduler&>(), asio::execution::blocking.never))>;
+
+        // Every operation state starts with this header and is queued intrusively.
+        struct node : asio_ext::detail::mpsc_node
+        {
+            // Completes the operation with set_value, it may be destroyed right after.
+            void (*run_)(node*) ASIO_NOEXCEPT = nullptr;
+            // Completes the operation with set_error, or set_done for an empty error.
+            void (*abort_)(node*, std::exception_ptr) ASIO_NOEXCEPT = nullptr;
+            // Schedules a drain on the underlying scheduler from this node's storage.
+            void (*post_)(node*) ASIO_NOEXCEPT = nullptr;
+        };
+
+        template <class Scheduler>
+        struct drain_receiver
+        {
+            strand<Scheduler>* strand_;
+
+            void set_value() noexcept {
+                strand_->drain();
+            }
+
+            void set_done() noexcept {
+                strand_->abort(nullptr);
+            }
+
+            template <class E>
+            void set_error(E&& e) noexcept {
+                if constexpr (std::is_same_v<asio_ext::remove_cvref_t<E>, std::exception_ptr>) {
+                    strand_->abort(std::forward<E>(e));
+                }
+                else {
+                    strand_->abort(std::make_exception_ptr(std::forward<E>(e)));
+                }
+            }
+        };
+
+        template <class Scheduler, class Receiver>
+        struct operation : node
+        {
+            using drain_operation_type = asio::execution::connect_result_t<
+                decltype(asio::execution::schedule(std::declval<never_blocking_t<Scheduler>&>())),
+                drain_receiver<Scheduler>>;
+
+            strand<Scheduler>* strand_;
+            Receiver receiver_;
+            asio_ext::optional<drain_operation_type> drain_;
+
+            template <class Rx>
+            operation(strand<Scheduler>* s, Rx&& rx) : strand_(s), receiver_(std::forward<Rx>(rx)) {
+            }
+
+            void start() ASIO_NOEXCEPT {
+                // Not on construction, for the reason given at detail::schedule_operation::arm()
+                run_ = &operation::run;
+                abort_ = &operation::abort;
+                post_ = &operation::post;
+                strand_->enqueue(this);
+            }
+
+            static void run(node* base) ASIO_NOEXCEPT {
+                auto* self = static_cast<operation*>(base);
+                try {
+                    asio::execution::set_value(std::move(self->receiver_));
+                }
+                catch (...) {
+                    asio::execution::set_error(std::move(self->receiver_), std::current_exception());
+                }
+            }
+
+            static void abort(node* base, std::exception_ptr error) ASIO_NOEXCEPT {
+                auto* self = static_cast<operation*>(base);
+                if (error) {
+                    asio::execution::set_error(std::move(self->receiver_), std::move(error));
+                }
+                else {
+                    asio::execution::set_done(std::move(self->receiver_));
+                }
+            }
+
+            static void post(node* base) ASIO_NOEXCEPT {
+                auto* self = static_cast<operation*>(base);
+                auto* s = self->strand_;
+                try {
+                    self->drain_.emplace(asio::execution::connect(
+                        asio::execution::schedule(s->underlying_), drain_receiver<Scheduler>{ s }));
+                }
+                catch (...) {
+                    s->abort(std::current_exception());
+                    return;
+                }
+                asio::execution::start(*self->drain_);
+            }
+        };
+
+        template <class Scheduler>
+        struct sender
+        {
+            template <template <class...> class Tuple, template <class...> class Variant>
+            using value_types = Variant<Tuple<>>;
+            template <template <class...> class Variant>
+            using error_types = Variant<std::exception_ptr>;
+            static constexpr bool sends_done = true;
+
+            strand<Scheduler>* strand_;
+
+            template <class Receiver>
+            auto connect(Receiver&& recv) const {
+                return operation<Scheduler, asio_ext::remove_cvref_t<Receiver>>(
+                    strand_, std::forward<Receiver>(recv));
+            }
+        };
+    } // namespace strand_detail
+
+    template <class Scheduler>
+    class strand_scheduler;
+
+    // Runs the operations scheduled through it one at a time, in the order they were
+    // started. A schedule() operation queues itself on a lock-free intrusive queue, the
+    // strand never allocates. When the strand is idle the operation completes inline on
+    // the thread starting it, otherwise whoever finds the strand idle schedules one drain
+    // on the underlying scheduler which completes up to batch_size queued operations
+    // before rescheduling itself. blocking.never is preferred on the underlying scheduler
+    // so a drain never nests inside the previous one. If the underlying scheduler fails
+    // or stops, the queued operations complete with its error or set_done.
+    // All operations must have completed before the strand is destroyed.
+    template <class Scheduler>
+    class strand
+    {
+    public:
+        explicit strand(const Scheduler& underlying, std::size_t batch_size = 64)
+            : underlying_(asio::prefer(underlying, asio::execution::blocking.never)), batch_size_(batch_size > 0 ? batch_size : 1) {
+        }
+
+        strand(const strand&) = delete;
+        strand& operator=(const strand&) = delete;
+
+        strand_scheduler<Scheduler> get_scheduler() noexcept {
+            return strand_scheduler<Scheduler>(*this);
+        }
+
+        const strand_detail::never_blocking_t<Scheduler>& underlying_scheduler() const noexcept {
+            return underlying_;
+        }
+
+        void enqueue(strand_detail::node* n) noexcept {
+            std::size_t idle = 0;
+            if (pending_.compare_exchange_strong(idle, 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+                n->run_(n);
+                release();
+                return;
+            }
+            queue_.push(n);
+            if (pending_.fetch_add(1, std::memory_order_acq_rel) == 0) {
+                post_drain();
+            }
+        }
+
+    private:
+        template <class, class>
+        friend struct strand_detail::operation;
+        template <class>
+        friend struct strand_detail::drain_receiver;
+
+        // Called by the owner after completing an operation, hands the strand on if more are queued
+        void release() noexcept {
+            if (pending_.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+                post_drain();
+            }
+        }
+
+        // The queued operation hosting the drain stays alive until the drain completes it first
+        void post_drain() noexcept {
+            front_ = pop_queued();
+            front_->post_(front_);
+        }
+
+        void drain() noexcept {
+            for (std::size_t i = 0; i < batch_size_; ++i) {
+                auto* n = std::exchange(front_, nullptr);
+                if (!n) {
+                    n = pop_queued();
+                }
+                n->run_(n);
+                if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    return;
+                }
+            }
+            post_drain();
+        }
+
+        void abort(std::exception_ptr error) noexcept {
+            do {
+                auto* n = std::exchange(front_, nullptr);
+                if (!n) {
+                    n = pop_queued();
+                }
+                n->abort_(n, error);
+            } while (pending_.fetch_sub(1, std::memory_order_acq_rel) != 1);
+        }
+
+        // Only called while pending_ counts a queued operation, an empty pop means its
+        // producer has not linked it yet
+        strand_detail::node* pop_queued() noexcept {
+            for (;;) {
+                if (auto* n = queue_.pop()) {
+                    return static_cast<strand_detail::node*>(n);
+                }
+                std::this_thread::yield();
+            }
+        }
+
+        strand_detail::never_blocking_t<Scheduler> underlying_;
+        std::size_t batch_size_;
+        // Operations started and not yet completed, whoever raises it from zero owns the strand
+        std::atomic<std::size_t> pending_{ 0 };
+        asio_ext::detail::mpsc_queue queue_;
+        // Owner only: the operation popped to host the next drain
+        strand_detail::node* front_ = nullptr;
+    };
+
+    template <class Scheduler>
+    class strand_scheduler
+    {
+    public:
+        explicit strand_scheduler(strand<Scheduler>& s) noexcept : strand_(&s) {}
+
+        // Completes on the strand, see strand for where it runs.
+        strand_detail::sender<Scheduler> schedule() const noexcept {
+            return { strand_ };
+        }
+
+        strand<Scheduler>& get_strand() const noexcept {
+            return *strand_;
+        }
+
+        friend bool operator==(const strand_scheduler& lhs, const strand_scheduler& rhs) noexcept {
+            return lhs.strand_ == rhs.strand_;
+        }
+
+        friend bool operator!=(const strand_scheduler& lhs, const strand_scheduler& rhs) noexcept {
+            return lhs.strand_ != rhs.strand_;
+        }
+
+    private:
+        strand<Scheduler>* strand_;
+    };
+} // namespace asio_ext
+
+#if !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Scheduler, class Receiver>
+struct start_member<asio_ext::strand_detail::operation<Scheduler, Receiver>>
+{
+    ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+    ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+    typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+#endif // !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Scheduler, typename Receiver>
+struct connect_member<asio_ext::strand_detail::sender<Scheduler>, Receiver>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef typename asio_ext::strand_detail::operation<
+      Scheduler, asio_ext::remove_cvref_t<Receiver>> result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_VALUE_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Scheduler>
+struct set_value_member<asio_ext::strand_detail::drain_receiver<Scheduler>, void()>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_VALUE_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_ERROR_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Scheduler, class E>
+struct set_error_member<asio_ext::strand_detail::drain_receiver<Scheduler>, E>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_ERROR_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_DONE_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Scheduler>
+struct set_done_member<asio_ext::strand_detail::drain_receiver<Scheduler>>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_DONE_MEMBER_TRAIT)
@@ -9,6 +9,7 @@
 #include <atomic>
 #include <exception>
 #include <thread>
+#include <type_traits>
 #include <variant>
 #include <tuple>
 
@@ -18,6 +19,8 @@
 #include <asio/execution/set_error.hpp>
 #include <asio/execution/set_value.hpp>
 
+#include <boost/mp11/algorithm.hpp>
+
 #include <asio_ext/detail/optional.hpp>
 #include <asio_ext/sender_traits.hpp>
 
@@ -140,18 +143,111 @@ namespace asio_ext
                 state_->has_been_set_.store(true);
             }
 
+            template <class Tuple>
+            using decayed_tuple_t = boost::mp11::mp_transform<std::decay_t, Tuple>;
+
+            // The sender's values with references and cv-qualifiers removed
+            template <class Sender>
+            using decayed_value_types = boost::mp11::mp_unique<boost::mp11::mp_transform<decayed_tuple_t,
+                typename asio::execution::sender_traits<std::decay_t<Sender>>::template value_types<std::tuple, std::variant>>>;
+
+            template <class T>
+            struct is_variant : std::false_type
+            {};
+
+            template <class... Ts>
+            struct is_variant<std::variant<Ts...>> : std::true_type
+            {};
+
+            // Waits for a result written straight into caller provided storage
+            template <class Result>
+            struct into_state
+            {
+                asio_ext::optional<Result>* result_;
+                std::exception_ptr exception_;
+                std::atomic_bool has_been_set_{ false };
+
+                explicit into_state(asio_ext::optional<Result>* result) : result_(result) {}
+
+                void get() const {
+                    while (!has_been_set_.load()) {
+                        std::this_thread::yield();
+                    }
+                    if (exception_) {
+                        std::rethrow_exception(exception_);
+                    }
+                }
+            };
+
+            template <class Result>
+            class into_reference
+            {
+            public:
+                into_reference(into_state<Result>& state) : state_(&state) {}
+
+                template <class... Values>
+                void set_value(Values&&... values) {
+                    try {
+                        if constexpr (is_variant<Result>::value) {
+                            state_->result_->emplace(std::in_place_type<std::tuple<std::decay_t<Values>...>>,
+                                std::forward<Values>(values)...);
+                        }
+                        else {
+                            state_->result_->emplace(std::forward<Values>(values)...);
+                        }
+                    }
+                    catch (...) {
+                        state_->exception_ = std::current_exception();
+                    }
+                    state_->has_been_set_.store(true);
+                }
+
+                void set_done() {
+                    state_->has_been_set_.store(true);
+                }
+
+                void set_error(std::exception_ptr ex) {
+                    state_->exception_ = ex;
+                    state_->has_been_set_.store(true);
+                }
+
+            private:
+                into_state<Result>* state_;
+            };
+
+            // Leaves result empty if the sender completed with set_done
+            template <class Result, class Sender>
+            asio_ext::optional<Result>& run_into(Sender&& sender, asio_ext::optional<Result>& result) {
+                result.reset();
+                into_state<Result> state{ &result };
+                auto op = asio::execution::connect(std::forward<Sender>(sender), into_reference<Result>(state));
+                asio::execution::start(op);
+                state.get();
+                return result;
+            }
+
+            // Several value signatures, completes with the variant of decayed value tuples
             template<class T>
             struct valued_sync_wait_impl
             {
                 template<class Sender>
                 static auto run(Sender&& sender)
                 {
-                    using decayed = std::decay_t<Sender>;
-                    using value_types = typename asio::execution::sender_traits<decayed>::template value_types<std::tuple, std::variant>;
-                    shared_state<value_types> state;
-                    auto op = asio::execution::connect(std::forward<Sender>(sender), state.ref());
-                    asio::execution::start(op);
-                    return state.get();
+                    asio_ext::optional<decayed_value_types<Sender>> result;
+                    run_into(std::forward<Sender>(sender), result);
+                    return result;
+                }
+            };
+
+            // One signature with several values, completes with a tuple
+            template <class T1, class T2, class... Ts>
+            struct valued_sync_wait_impl<std::variant<std::tuple<T1, T2, Ts...>>>
+            {
+                template <class Sender>
+                static auto run(Sender&& sender) {
+                    asio_ext::optional<std::tuple<std::decay_t<T1>, std::decay_t<T2>, std::decay_t<Ts>...>> result;
+                    run_into(std::forward<Sender>(sender), result);
+                    return result;
                 }
             };
 
@@ -191,6 +287,16 @@ namespace asio_ext
                 using value_types = typename asio::execution::sender_traits<decayed>::template value_types<std::tuple, std::variant>;
                 return detail::valued_sync_wait_impl<value_types>::run(std::forward<Sender>(sender));
             }
+
+            // Emplaces the values of a single signature sender into result, which can be reused
+            // across calls. result is left empty if the sender completed with set_done.
+            template <class Sender, class... Values>
+            asio_ext::optional<std::tuple<Values...>>& operator()(
+                Sender&& sender, asio_ext::optional<std::tuple<Values...>>& result) const {
+                static_assert(std::is_same_v<detail::decayed_value_types<Sender>, std::variant<std::tuple<Values...>>>,
+                    "result must hold the sender's decayed values");
+                return detail::run_into(std::forward<Sender>(sender), result);
+            }
         };
 
         template <typename T = cpo>
@@ -205,10 +311,47 @@ namespace asio_ext
     
 } // namespace asio_ext
 
+namespace asio_ext
+{
+    namespace sync_wait_with_variant
+    {
+        struct cpo
+        {
+            // Waits for a sender with any number of value signatures. The result holds the
+            // decayed values of the signature it completed with, or is empty after set_done.
+            template <class Sender>
+            auto operator()(Sender&& sender) const {
+                asio_ext::optional<sync_wait::detail::decayed_value_types<Sender>> result;
+                sync_wait::detail::run_into(std::forward<Sender>(sender), result);
+                return result;
+            }
+
+            template <class Sender, class... Tuples>
+            asio_ext::optional<std::variant<Tuples...>>& operator()(
+                Sender&& sender, asio_ext::optional<std::variant<Tuples...>>& result) const {
+                static_assert(std::is_same_v<sync_wait::detail::decayed_value_types<Sender>, std::variant<Tuples...>>,
+                    "result must hold the sender's decayed value types");
+                return sync_wait::detail::run_into(std::forward<Sender>(sender), result);
+            }
+        };
+
+        template <typename T = cpo>
+        struct static_instance
+        {
+            static const T instance;
+        };
+
+        template <typename T>
+        const T static_instance<T>::instance = {};
+    }
+} // namespace asio_ext
+
 namespace asio {
 namespace execution {
     static ASIO_CONSTEXPR const asio_ext::sync_wait::cpo&
         sync_wait = asio_ext::sync_wait::static_instance<>::instance;
+    static ASIO_CONSTEXPR const asio_ext::sync_wait_with_variant::cpo&
+        sync_wait_with_variant = asio_ext::sync_wait_with_variant::static_instance<>::instance;
 } // namespace execution
 } // namespace asio
 
@@ -232,6 +375,14 @@ struct set_value_member<asio_ext::sync_wait::detail::reference<void>, void(Value
   typedef void result_type;
 };
 
+template <class Result, class... Values>
+struct set_value_member<asio_ext::sync_wait::detail::into_reference<Result>, void(Values...)>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef void result_type;
+};
+
 } // namespace traits
 } // namespace asio
 
@@ -258,6 +409,14 @@ struct set_error_member<asio_ext::sync_wait::detail::reference<void>, E>
   typedef void result_type;
 };
 
+template <class Result, typename E>
+struct set_error_member<asio_ext::sync_wait::detail::into_reference<Result>, E>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
 } // namespace traits
 } // namespace asio
 
@@ -284,6 +443,14 @@ struct set_done_member<asio_ext::sync_wait::detail::reference<void>>
   typedef void result_type;
 };
 
+template <class Result>
+struct set_done_member<asio_ext::sync_wait::detail::into_reference<Result>>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
 } // namespace traits
 } // namespace asio
 
@@ -0,0 +1,277 @@
+
+//          Copyright Andreas Wass 2004 - 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include <asio/execution/connect.hpp>
+#include <asio/execution/set_done.hpp>
+#include <asio/execution/set_error.hpp>
+#include <asio/execution/set_value.hpp>
+#include <asio/execution/start.hpp>
+
+#include <boost/mp11/algorithm.hpp>
+
+#include <asio_ext/detail/optional.hpp>
+#include <asio_ext/sync_wait.hpp>
+#include <asio_ext/type_traits.hpp>
+
+namespace asio_ext
+{
+    namespace sync_wait_all
+    {
+        namespace detail
+        {
+            template <class ValueTypes>
+            struct single_result
+            {
+                static_assert(boost::mp11::mp_size<ValueTypes>::value == 1,
+                    "sync_wait_all senders must complete with exactly one set of values");
+                using tuple_type = boost::mp11::mp_first<ValueTypes>;
+                // void, the value or a tuple of the values
+                using type = std::conditional_t<std::tuple_size_v<tuple_type> == 0, void,
+                    std::conditional_t<std::tuple_size_v<tuple_type> == 1,
+                    boost::mp11::mp_first<boost::mp11::mp_push_back<tuple_type, void>>, tuple_type>>;
+            };
+
+            template <class Sender>
+            using result_t = typename single_result<sync_wait::detail::decayed_value_types<Sender>>::type;
+
+            // Stored per result so void senders still have somewhere to complete to
+            struct no_value
+            {};
+
+            template <class Sender>
+            using stored_result_t =
+                asio_ext::optional<std::conditional_t<std::is_void_v<result_t<Sender>>, no_value, result_t<Sender>>>;
+
+            struct slot_base
+            {
+                slot_base* next_ = nullptr;
+                std::exception_ptr error_;
+            };
+
+            template <class Sender>
+            struct slot_receiver
+            {
+                slot_base* slot_;
+                stored_result_t<Sender>* result_;
+                std::atomic<slot_base*>* completed_;
+
+                template <class... Values>
+                void set_value(Values&&... values) {
+                    try {
+                        if constexpr (sizeof...(Values) == 0) {
+                            result_->emplace();
+                        }
+                        else {
+                            result_->emplace(std::forward<Values>(values)...);
+                        }
+                    }
+                    catch (...) {
+                        slot_->error_ = std::current_exception();
+                    }
+                    push();
+                }
+
+                template <class E>
+                void set_error(E&& e) noexcept {
+                    if constexpr (std::is_same_v<asio_ext::remove_cvref_t<E>, std::exception_ptr>) {
+                        slot_->error_ = std::forward<E>(e);
+                    }
+                    else {
+                        slot_->error_ = std::make_exception_ptr(std::forward<E>(e));
+                    }
+                    push();
+                }
+
+                void set_done() noexcept {
+                    push();
+                }
+
+                // Last thing the receiver does, the loop may destroy the operation right after
+                void push() noexcept {
+                    auto* slot = slot_;
+                    auto* completed = completed_;
+                    auto* head = completed->load(std::memory_order_relaxed);
+                    do {
+                        slot->next_ = head;
+                    } while (!completed->compare_exchange_weak(
+                        head, slot, std::memory_order_release, std::memory_order_relaxed));
+                }
+            };
+
+            template <class Sender>
+            struct slot : slot_base
+            {
+                using operation_type = asio::execution::connect_result_t<Sender, slot_receiver<Sender>>;
+                asio_ext::optional<operation_type> op_;
+            };
+
+            template <class Range>
+            using sender_of = std::decay_t<decltype(*std::begin(std::declval<Range&>()))>;
+
+            // What an element is constructed from, a move is only safe out of an rvalue range
+            template <class Range>
+            using element_ref_t =
+                std::conditional_t<std::is_lvalue_reference_v<Range>, const sender_of<Range>&, sender_of<Range>&&>;
+        } // namespace detail
+
+        struct cpo
+        {
+            // Runs every sender of range on the calling thread with at most max_concurrency
+            // of them in flight. The operation states live in one array of max_concurrency
+            // slots, a slot is reused for the next sender once its operation completed.
+            // Returns the results in range order, empty where a sender completed with
+            // set_done. Once a sender fails no more are started and the first error is
+            // rethrown after the ones in flight have completed. Senders are copied out of
+            // an lvalue range and moved out of an rvalue one.
+            template <class Range>
+            auto operator()(Range&& range, std::size_t max_concurrency) const {
+                using sender_type = detail::sender_of<Range>;
+                using slot_type = detail::slot<sender_type>;
+                using stored_type = detail::stored_result_t<sender_type>;
+
+                auto it = std::begin(range);
+                auto end = std::end(range);
+                std::vector<stored_type> results(static_cast<std::size_t>(std::distance(it, end)));
+                std::size_t slot_count = std::min(max_concurrency > 0 ? max_concurrency : 1, results.size());
+                auto slots = std::make_unique<slot_type[]>(slot_count);
+
+                std::atomic<detail::slot_base*> completed{ nullptr };
+                std::exception_ptr first_error;
+                std::size_t next = 0;
+                std::size_t active = 0;
+
+                auto launch = [&](slot_type& s) {
+                    try {
+                        s.op_.emplace(asio::execution::connect(
+                            sender_type(static_cast<detail::element_ref_t<Range>>(*it)),
+                            detail::slot_receiver<sender_type>{ &s, &results[next], &completed }));
+                    }
+                    catch (...) {
+                        first_error = std::current_exception();
+                        return;
+                    }
+                    ++it;
+                    ++next;
+                    ++active;
+                    asio::execution::start(*s.op_);
+                };
+
+                for (std::size_t i = 0; i < slot_count && !first_error; ++i) {
+                    launch(slots[i]);
+                }
+                while (active > 0) {
+                    auto* done = completed.exchange(nullptr, std::memory_order_acquire);
+                    if (!done) {
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    while (done) {
+                        auto* s = static_cast<slot_type*>(std::exchange(done, done->next_));
+                        s->op_.reset();
+                        --active;
+                        if (s->error_ && !first_error) {
+                            first_error = std::exchange(s->error_, nullptr);
+                        }
+                        if (!first_error && it != end) {
+                            launch(*s);
+                        }
+                    }
+                }
+                if (first_error) {
+                    std::rethrow_exception(first_error);
+                }
+                if constexpr (!std::is_void_v<detail::result_t<sender_type>>) {
+                    return results;
+                }
+            }
+        };
+
+        template <typename T = cpo>
+        struct static_instance
+        {
+            static const T instance;
+        };
+
+        template <typename T>
+        const T static_instance<T>::instance = {};
+    }
+} // namespace asio_ext
+
+namespace asio {
+namespace execution {
+static ASIO_CONSTEXPR const asio_ext::sync_wait_all::cpo&
+      sync_wait_all = asio_ext::sync_wait_all::static_instance<>::instance;
+} // namespace execution
+} // namespace asio
+
+#if !defined(ASIO_HAS_DEDUCED_SET_VALUE_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Sender, class... Values>
+struct set_value_member<asio_ext::sync_wait_all::detail::slot_receiver<Sender>, void(Values...)>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_VALUE_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_ERROR_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Sender, class E>
+struct set_error_member<asio_ext::sync_wait_all::detail::slot_receiver<Sender>, E>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_ERROR_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_DONE_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Sender>
+struct set_done_member<asio_ext::sync_wait_all::detail::slot_receiver<Sender>>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_DONE_MEMBER_TRAIT)
@@ -0,0 +1,317 @@
+
+//          Copyright Andreas Wass 2004 - 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include <asio/execution/connect.hpp>
+#include <asio/execution/set_done.hpp>
+#include <asio/execution/set_error.hpp>
+#include <asio/execution/set_value.hpp>
+#include <asio/execution/start.hpp>
+
+#include <boost/mp11/algorithm.hpp>
+#include <boost/mp11/list.hpp>
+
+#include <asio_ext/sender_traits.hpp>
+#include <asio_ext/type_traits.hpp>
+
+namespace asio_ext
+{
+    namespace then_chain
+    {
+        namespace detail
+        {
+            template <class ValueTypes>
+            struct single_value_set
+            {
+                static_assert(boost::mp11::mp_size<ValueTypes>::value == 1,
+                    "then_chain stages must complete with exactly one set of values");
+                using type = boost::mp11::mp_transform<std::decay_t, boost::mp11::mp_first<ValueTypes>>;
+            };
+
+            // Values of a stage as they are stored for the next factory
+            template <class Sender>
+            using stage_values_t = typename single_value_set<typename asio::execution::sender_traits<
+                Sender>::template value_types<std::tuple, std::variant>>::type;
+
+            template <class Function, class Tuple>
+            struct apply_result;
+
+            template <class Function, class... Ts>
+            struct apply_result<Function, std::tuple<Ts...>>
+            {
+                using type = asio_ext::remove_cvref_t<std::invoke_result_t<Function&, Ts&...>>;
+            };
+
+            // Sender and stored value types of every stage
+            template <class Sender, class... Functions>
+            struct chain;
+
+            template <class Sender>
+            struct chain<Sender>
+            {
+                using senders = boost::mp11::mp_list<Sender>;
+                using values = boost::mp11::mp_list<>;
+            };
+
+            template <class Sender, class Function, class... Rest>
+            struct chain<Sender, Function, Rest...>
+            {
+                using stage_values = stage_values_t<Sender>;
+                using next = chain<typename apply_result<Function, stage_values>::type, Rest...>;
+                using senders = boost::mp11::mp_push_front<typename next::senders, Sender>;
+                using values = boost::mp11::mp_push_front<typename next::values, stage_values>;
+            };
+
+            template <class Receiver, class Sender, class... Functions>
+            struct operation_state;
+
+            template <std::size_t I, class Receiver, class Sender, class... Functions>
+            struct stage_receiver
+            {
+                operation_state<Receiver, Sender, Functions...>* state_;
+
+                template <class... Values>
+                void set_value(Values&&... values) {
+                    if constexpr (I < sizeof...(Functions)) {
+                        // Advancing destroys this receiver, only use locals!
+                        auto* state = state_;
+                        state->template advance<I>(std::forward<Values>(values)...);
+                    }
+                    else {
+                        asio::execution::set_value(std::move(state_->receiver_), std::forward<Values>(values)...);
+                    }
+                }
+
+                void set_done() {
+                    asio::execution::set_done(std::move(state_->receiver_));
+                }
+
+                template <class E>
+                void set_error(E&& error) {
+                    asio::execution::set_error(std::move(state_->receiver_), std::forward<E>(error));
+                }
+            };
+
+            // Holds the running stage and the values of the stage before it. Stage I + 1 is
+            // connected in the slot stage I ran in, the factory gets lvalues to the stored
+            // values which stay alive until stage I + 1 has completed.
+            template <class Receiver, class Sender, class... Functions>
+            struct operation_state
+            {
+                using chain_type = chain<Sender, Functions...>;
+
+                template <std::size_t... Is>
+                static auto ops_type_for(std::index_sequence<Is...>) -> std::variant<std::monostate,
+                    asio::execution::connect_result_t<boost::mp11::mp_at_c<typename chain_type::senders, Is>,
+                        stage_receiver<Is, Receiver, Sender, Functions...>>...>;
+
+                using ops_type = decltype(ops_type_for(std::make_index_sequence<sizeof...(Functions) + 1>{}));
+                using values_type = boost::mp11::mp_rename<
+                    boost::mp11::mp_push_front<typename chain_type::values, std::monostate>, std::variant>;
+
+                template <class Rx>
+                operation_state(Sender&& sender, std::tuple<Functions...>&& functions, Rx&& receiver)
+                    : sender_(std::move(sender)), functions_(std::move(functions)),
+                    receiver_(std::forward<Rx>(receiver)) {
+                }
+
+                void start() ASIO_NOEXCEPT {
+                    try {
+                        auto& ref = ops_.template emplace<1>(asio::execution::connect(
+                            std::move(sender_), stage_receiver<0, Receiver, Sender, Functions...>{this}));
+                        asio::execution::start(ref);
+                    }
+                    catch (...) {
+                        asio::execution::set_error(std::move(receiver_), std::current_exception());
+                    }
+                }
+
+                template <std::size_t I, class... Values>
+                void advance(Values&&... values) ASIO_NOEXCEPT {
+                    try {
+                        // The values may refer to the stored ones, copy them out before replacing
+                        boost::mp11::mp_at_c<typename chain_type::values, I> incoming(std::forward<Values>(values)...);
+                        auto& stored = values_.template emplace<I + 1>(std::move(incoming));
+                        auto& ref = ops_.template emplace<I + 2>(
+                            asio::execution::connect(std::apply(std::get<I>(functions_), stored),
+                                stage_receiver<I + 1, Receiver, Sender, Functions...>{this}));
+                        asio::execution::start(ref);
+                    }
+                    catch (...) {
+                        asio::execution::set_error(std::move(receiver_), std::current_exception());
+                    }
+                }
+
+                Sender sender_;
+                std::tuple<Functions...> functions_;
+                Receiver receiver_;
+                values_type values_;
+                ops_type ops_;
+            };
+
+            template <class Sender, class... Functions>
+            struct sender
+            {
+                using senders = typename chain<Sender, Functions...>::senders;
+
+                template <template <class...> class Tuple, template <class...> class Variant>
+                using value_types = typename asio::execution::sender_traits<
+                    boost::mp11::mp_back<senders>>::template value_types<Tuple, Variant>;
+
+                template <class S>
+                using errors_of = typename asio::execution::sender_traits<S>::template error_types<boost::mp11::mp_list>;
+
+                template <template <class...> class Variant>
+                using error_types = boost::mp11::mp_rename<boost::mp11::mp_unique<boost::mp11::mp_push_back<
+                    boost::mp11::mp_apply<boost::mp11::mp_append, boost::mp11::mp_transform<errors_of, senders>>,
+                    std::exception_ptr>>, Variant>;
+
+                template <class S>
+                using sends_done_of = std::bool_constant<asio::execution::sender_traits<S>::sends_done>;
+
+                static constexpr bool sends_done = boost::mp11::mp_any_of<senders, sends_done_of>::value;
+
+                Sender sender_;
+                std::tuple<Functions...> functions_;
+
+                template <class Receiver>
+                auto connect(Receiver&& receiver) {
+                    return operation_state<asio_ext::remove_cvref_t<Receiver>, Sender, Functions...>(
+                        std::move(sender_), std::move(functions_), std::forward<Receiver>(receiver));
+                }
+            };
+        } // namespace detail
+
+        struct cpo
+        {
+            // Runs sender, then each function in turn with lvalues to the previous stage's
+            // values, and runs the sender it returns. Completes with the last stage's values.
+            // Every stage must complete with a single set of values. Values and stages live
+            // inline in the operation state, advancing does not allocate.
+            template <class Sender, class... Functions>
+            auto operator()(Sender&& sender, Functions&&... functions) const {
+                return detail::sender<asio_ext::remove_cvref_t<Sender>, asio_ext::remove_cvref_t<Functions>...>{
+                    std::forward<Sender>(sender),
+                    std::tuple<asio_ext::remove_cvref_t<Functions>...>(std::forward<Functions>(functions)...)};
+            }
+        };
+
+        template <typename T = cpo>
+        struct static_instance
+        {
+            static const T instance;
+        };
+
+        template <typename T>
+        const T static_instance<T>::instance = {};
+    }
+} // namespace asio_ext
+
+namespace asio {
+namespace execution {
+static ASIO_CONSTEXPR const asio_ext::then_chain::cpo&
+      then_chain = asio_ext::then_chain::static_instance<>::instance;
+} // namespace execution
+} // namespace asio
+
+#if !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Receiver, class Sender, class... Functions>
+struct start_member<asio_ext::then_chain::detail::operation_state<Receiver, Sender, Functions...>>
+{
+    ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+    ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+    typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+#endif // !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Sender, class... Functions, typename R>
+struct connect_member<asio_ext::then_chain::detail::sender<Sender, Functions...>, R>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef typename asio_ext::then_chain::detail::operation_state<
+      asio_ext::remove_cvref_t<R>, Sender, Functions...> result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_VALUE_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <std::size_t I, class Receiver, class Sender, class... Functions, class... Values>
+struct set_value_member<asio_ext::then_chain::detail::stage_receiver<I, Receiver, Sender, Functions...>, void(Values...)>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_VALUE_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_ERROR_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <std::size_t I, class Receiver, class Sender, class... Functions, class E>
+struct set_error_member<asio_ext::then_chain::detail::stage_receiver<I, Receiver, Sender, Functions...>, E>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_ERROR_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_DONE_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <std::size_t I, class Receiver, class Sender, class... Functions>
+struct set_done_member<asio_ext::then_chain::detail::stage_receiver<I, Receiver, Sender, Functions...>>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_DONE_MEMBER_TRAIT)
@@ -0,0 +1,232 @@
+
+//          Copyright Andreas Wass 2004 - 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <cstdint>
+#include <utility>
+
+#include <asio/execution/connect.hpp>
+#include <asio/execution/set_done.hpp>
+#include <asio/execution/set_error.hpp>
+#include <asio/execution/set_value.hpp>
+#include <asio/execution/start.hpp>
+
+#include <asio_ext/type_traits.hpp>
+
+#if defined(ASIO_EXT_ENABLE_TRACING)
+#include <asio_ext/tracing.hpp>
+#endif
+
+namespace asio_ext
+{
+    namespace traced
+    {
+#if defined(ASIO_EXT_ENABLE_TRACING)
+        namespace detail
+        {
+            using tracer_type = ASIO_EXT_TRACER;
+            using asio_ext::tracing::event_type;
+
+            template <class Receiver>
+            struct receiver
+            {
+                Receiver next_;
+                const char* name_;
+                std::uint64_t id_;
+
+                template <class... Values>
+                void set_value(Values&&... values) {
+                    tracer_type::record(name_, id_, event_type::set_value);
+                    asio::execution::set_value(std::move(next_), std::forward<Values>(values)...);
+                }
+
+                template <class E>
+                void set_error(E&& e) noexcept {
+                    tracer_type::record(name_, id_, event_type::set_error);
+                    asio::execution::set_error(std::move(next_), std::forward<E>(e));
+                }
+
+                void set_done() noexcept {
+                    tracer_type::record(name_, id_, event_type::set_done);
+                    asio::execution::set_done(std::move(next_));
+                }
+            };
+
+            template <class Sender, class Receiver>
+            struct operation
+            {
+                using next_operation_state = asio::execution::connect_result_t<Sender, receiver<Receiver>>;
+
+                const char* name_;
+                std::uint64_t id_;
+                next_operation_state state_;
+
+                operation(Sender&& sender, receiver<Receiver>&& rx)
+                    : name_(rx.name_), id_(rx.id_),
+                    state_(asio::execution::connect(std::move(sender), std::move(rx))) {
+                }
+
+                void start() ASIO_NOEXCEPT {
+                    tracer_type::record(name_, id_, event_type::start);
+                    asio::execution::start(state_);
+                }
+            };
+
+            template <class Sender>
+            struct sender
+            {
+                template <template <class...> class Tuple, template <class...> class Variant>
+                using value_types =
+                    typename asio::execution::sender_traits<Sender>::template value_types<Tuple, Variant>;
+
+                template <template <class...> class Variant>
+                using error_types = typename asio::execution::sender_traits<Sender>::template error_types<Variant>;
+
+                static constexpr bool sends_done = asio::execution::sender_traits<Sender>::sends_done;
+
+                Sender sender_;
+                const char* name_;
+
+                template <class Receiver>
+                auto connect(Receiver&& recv) {
+                    using receiver_type = receiver<asio_ext::remove_cvref_t<Receiver>>;
+                    auto id = tracer_type::next_id();
+                    tracer_type::record(name_, id, event_type::connect);
+                    return operation<Sender, asio_ext::remove_cvref_t<Receiver>>(
+                        std::move(sender_), receiver_type{std::forward<Receiver>(recv), name_, id});
+                }
+            };
+        } // namespace detail
+#endif
+
+        struct cpo
+        {
+            // Records connect/start/completion of the wrapped operation with ASIO_EXT_TRACER.
+            // Without ASIO_EXT_ENABLE_TRACING the sender is returned untouched.
+            // The name must outlive the trace, pass a string literal.
+            template <class Sender>
+            auto operator()(Sender&& sender, const char* name) const {
+#if defined(ASIO_EXT_ENABLE_TRACING)
+                return detail::sender<asio_ext::remove_cvref_t<Sender>>{std::forward<Sender>(sender), name};
+#else
+                (void)name;
+                return asio_ext::remove_cvref_t<Sender>(std::forward<Sender>(sender));
+#endif
+            }
+        };
+
+        template <typename T = cpo>
+        struct static_instance
+        {
+            static const T instance;
+        };
+
+        template <typename T>
+        const T static_instance<T>::instance = {};
+    }
+} // namespace asio_ext
+
+namespace asio {
+namespace execution {
+static ASIO_CONSTEXPR const asio_ext::traced::cpo&
+      traced = asio_ext::traced::static_instance<>::instance;
+} // namespace execution
+} // namespace asio
+
+#if defined(ASIO_EXT_ENABLE_TRACING)
+
+#if !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Sender, class Receiver>
+struct start_member<asio_ext::traced::detail::operation<Sender, Receiver>>
+{
+    ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+    ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+    typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+#endif // !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Sender, typename Receiver>
+struct connect_member<asio_ext::traced::detail::sender<Sender>, Receiver>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef typename asio_ext::traced::detail::operation<
+      Sender, asio_ext::remove_cvref_t<Receiver>> result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_VALUE_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Receiver, class... Values>
+struct set_value_member<asio_ext::traced::detail::receiver<Receiver>, void(Values...)>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_VALUE_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_ERROR_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Receiver, class E>
+struct set_error_member<asio_ext::traced::detail::receiver<Receiver>, E>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_ERROR_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_DONE_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Receiver>
+struct set_done_member<asio_ext::traced::detail::receiver<Receiver>>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_DONE_MEMBER_TRAIT)
+
+#endif // defined(ASIO_EXT_ENABLE_TRACING)
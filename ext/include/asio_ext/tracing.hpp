@@ -0,0 +1,203 @@
+
+//          Copyright Andreas Wass 2004 - 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace asio_ext
+{
+    namespace tracing
+    {
+        enum class event_type : unsigned char
+        {
+            connect,
+            start,
+            set_value,
+            set_error,
+            set_done
+        };
+
+        struct event
+        {
+            const char* name;
+            std::uint64_t id;
+            std::int64_t timestamp_ns;
+            event_type type;
+        };
+
+        // Events recorded by one thread. Only the owning thread writes, so recording is a
+        // plain store plus a release increment of the head. Once full the oldest events
+        // are overwritten.
+        class thread_buffer
+        {
+        public:
+            static constexpr std::size_t capacity = 4096;
+
+            explicit thread_buffer(std::uint32_t thread_index) : thread_index_(thread_index) {}
+
+            void record(const event& e) noexcept {
+                auto head = head_.load(std::memory_order_relaxed);
+                events_[head & (capacity - 1)] = e;
+                head_.store(head + 1, std::memory_order_release);
+            }
+
+            template <class Function>
+            void for_each(Function&& fn) const {
+                auto head = head_.load(std::memory_order_acquire);
+                for (auto i = head > capacity ? head - capacity : 0; i < head; ++i) {
+                    fn(events_[i & (capacity - 1)]);
+                }
+            }
+
+            void clear() noexcept {
+                head_.store(0, std::memory_order_release);
+            }
+
+            std::uint32_t thread_index() const noexcept {
+                return thread_index_;
+            }
+
+        private:
+            std::array<event, capacity> events_;
+            std::atomic<std::uint64_t> head_{ 0 };
+            std::uint32_t thread_index_;
+        };
+
+        // The default tracer. A tracer is any type providing
+        //   static std::uint64_t next_id() noexcept;
+        //   static void record(const char* name, std::uint64_t id, event_type type) noexcept;
+        // and is selected for the whole program by defining ASIO_EXT_TRACER.
+        class ring_buffer_tracer
+        {
+        public:
+            static std::uint64_t next_id() noexcept {
+                static std::atomic<std::uint64_t> id{ 0 };
+                return id.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            static void record(const char* name, std::uint64_t id, event_type type) noexcept {
+                auto now = std::chrono::steady_clock::now().time_since_epoch();
+                local_buffer().record(
+                    event{ name, id, std::chrono::duration_cast<std::chrono::nanoseconds>(now).count(), type });
+            }
+
+            // Calls fn(thread_index, event) for every recorded event. Only meaningful while
+            // no traced operations are running.
+            template <class Function>
+            static void for_each_event(Function&& fn) {
+                auto& reg = get_registry();
+                std::lock_guard<std::mutex> lock(reg.mutex_);
+                for (auto& buffer : reg.buffers_) {
+                    buffer->for_each([&](const event& e) { fn(buffer->thread_index(), e); });
+                }
+            }
+
+            static void clear() {
+                auto& reg = get_registry();
+                std::lock_guard<std::mutex> lock(reg.mutex_);
+                for (auto& buffer : reg.buffers_) {
+                    buffer->clear();
+                }
+            }
+
+        private:
+            struct registry
+            {
+                std::mutex mutex_;
+                // Buffers are kept after their thread exits so its events can still be exported
+                std::vector<std::unique_ptr<thread_buffer>> buffers_;
+            };
+
+            static registry& get_registry() {
+                static registry reg;
+                return reg;
+            }
+
+            static thread_buffer& local_buffer() {
+                static thread_local thread_buffer* buffer = nullptr;
+                if (!buffer) {
+                    auto& reg = get_registry();
+                    std::lock_guard<std::mutex> lock(reg.mutex_);
+                    reg.buffers_.push_back(
+                        std::make_unique<thread_buffer>(static_cast<std::uint32_t>(reg.buffers_.size())));
+                    buffer = reg.buffers_.back().get();
+                }
+                return *buffer;
+            }
+        };
+
+        namespace detail
+        {
+            inline void write_json_string(std::ostream& os, const char* str) {
+                os << '"';
+                for (; str && *str; ++str) {
+                    if (*str == '"' || *str == '\\') {
+                        os << '\\';
+                    }
+                    os << *str;
+                }
+                os << '"';
+            }
+
+            inline const char* phase(event_type type) {
+                switch (type) {
+                case event_type::connect:
+                    return "n";
+                case event_type::start:
+                    return "b";
+                default:
+                    return "e";
+                }
+            }
+
+            inline const char* signal_name(event_type type) {
+                switch (type) {
+                case event_type::connect:
+                    return "connect";
+                case event_type::start:
+                    return "start";
+                case event_type::set_value:
+                    return "set_value";
+                case event_type::set_error:
+                    return "set_error";
+                default:
+                    return "set_done";
+                }
+            }
+        } // namespace detail
+
+        // Writes everything recorded by the ring_buffer_tracer in the Chrome trace event
+        // format, loadable by chrome://tracing and Perfetto. Every traced operation is one
+        // async slice from start to completion, connect shows up as an instant event.
+        inline void write_chrome_trace(std::ostream& os) {
+            os << "{\"traceEvents\":[";
+            bool first = true;
+            ring_buffer_tracer::for_each_event([&](std::uint32_t thread_index, const event& e) {
+                os << (first ? "" : ",") << "\n{\"name\":";
+                first = false;
+                detail::write_json_string(os, e.name);
+                os << ",\"cat\":\"asio_ext\",\"ph\":\"" << detail::phase(e.type) << "\",\"id\":" << e.id
+                   << ",\"pid\":1,\"tid\":" << thread_index << ",\"ts\":" << (e.timestamp_ns / 1000) << '.'
+                   << (e.timestamp_ns % 1000 / 100) << ",\"args\":{\"signal\":\""
+                   << detail::signal_name(e.type) << "\"}}";
+            });
+            os << "\n]}\n";
+        }
+    } // namespace tracing
+} // namespace asio_ext
+
+#if !defined(ASIO_EXT_TRACER)
+#define ASIO_EXT_TRACER ::asio_ext::tracing::ring_buffer_tracer
+#endif
@@ -0,0 +1,320 @@
+
+//          Copyright Andreas Wass 2004 - 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <exception>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include <asio/execution/connect.hpp>
+#include <asio/execution/schedule.hpp>
+#include <asio/execution/set_done.hpp>
+#include <asio/execution/set_error.hpp>
+#include <asio/execution/set_value.hpp>
+#include <asio/execution/start.hpp>
+
+#include <boost/mp11/algorithm.hpp>
+#include <boost/mp11/list.hpp>
+
+#include <asio_ext/sender_traits.hpp>
+#include <asio_ext/type_traits.hpp>
+
+namespace asio_ext
+{
+    namespace via
+    {
+        namespace detail
+        {
+            template <class Tuple>
+            using decay_tuple = boost::mp11::mp_transform<std::decay_t, Tuple>;
+
+            // Every value signature of Sender as a decayed tuple, after an empty alternative
+            template <class Sender>
+            using values_t = boost::mp11::mp_rename<boost::mp11::mp_push_front<
+                boost::mp11::mp_unique<boost::mp11::mp_transform<decay_tuple,
+                    typename asio::execution::sender_traits<Sender>::template value_types<std::tuple,
+                        boost::mp11::mp_list>>>,
+                std::monostate>, std::variant>;
+
+            template <class Scheduler>
+            using schedule_sender_t = decltype(asio::execution::schedule(std::declval<Scheduler&>()));
+
+            template <class Receiver, class Sender, class Scheduler>
+            struct operation_state;
+
+            template <class Receiver, class Sender, class Scheduler>
+            struct source_receiver
+            {
+                operation_state<Receiver, Sender, Scheduler>* state_;
+
+                template <class... Values>
+                void set_value(Values&&... values) {
+                    // Hopping destroys this receiver, only use locals!
+                    auto* state = state_;
+                    state->hop(std::forward<Values>(values)...);
+                }
+
+                void set_done() {
+                    asio::execution::set_done(std::move(state_->receiver_));
+                }
+
+                template <class E>
+                void set_error(E&& error) {
+                    asio::execution::set_error(std::move(state_->receiver_), std::forward<E>(error));
+                }
+            };
+
+            template <class Receiver, class Sender, class Scheduler>
+            struct hop_receiver
+            {
+                operation_state<Receiver, Sender, Scheduler>* state_;
+
+                void set_value() {
+                    state_->deliver();
+                }
+
+                void set_done() {
+                    asio::execution::set_done(std::move(state_->receiver_));
+                }
+
+                template <class E>
+                void set_error(E&& error) {
+                    asio::execution::set_error(std::move(state_->receiver_), std::forward<E>(error));
+                }
+            };
+
+            // Runs sender, keeps its values and completes the receiver with them from an
+            // operation of the scheduler. The source and the hop share one slot.
+            template <class Receiver, class Sender, class Scheduler>
+            struct operation_state
+            {
+                using source_operation_type =
+                    asio::execution::connect_result_t<Sender, source_receiver<Receiver, Sender, Scheduler>>;
+                using hop_operation_type = asio::execution::connect_result_t<schedule_sender_t<Scheduler>,
+                    hop_receiver<Receiver, Sender, Scheduler>>;
+
+                template <class Rx>
+                operation_state(Sender&& sender, const Scheduler& scheduler, Rx&& receiver)
+                    : sender_(std::move(sender)), scheduler_(scheduler), receiver_(std::forward<Rx>(receiver)) {
+                }
+
+                void start() ASIO_NOEXCEPT {
+                    try {
+                        auto& ref = ops_.template emplace<1>(asio::execution::connect(
+                            std::move(sender_), source_receiver<Receiver, Sender, Scheduler>{ this }));
+                        asio::execution::start(ref);
+                    }
+                    catch (...) {
+                        asio::execution::set_error(std::move(receiver_), std::current_exception());
+                    }
+                }
+
+                template <class... Values>
+                void hop(Values&&... values) ASIO_NOEXCEPT {
+                    try {
+                        // The values may live in the source operation, store them before replacing it
+                        values_.template emplace<std::tuple<std::decay_t<Values>...>>(std::forward<Values>(values)...);
+                        auto& ref = ops_.template emplace<2>(asio::execution::connect(
+                            asio::execution::schedule(scheduler_), hop_receiver<Receiver, Sender, Scheduler>{ this }));
+                        asio::execution::start(ref);
+                    }
+                    catch (...) {
+                        asio::execution::set_error(std::move(receiver_), std::current_exception());
+                    }
+                }
+
+                void deliver() ASIO_NOEXCEPT {
+                    try {
+                        std::visit([this](auto& values) {
+                            if constexpr (!std::is_same_v<std::decay_t<decltype(values)>, std::monostate>) {
+                                std::apply([this](auto&... vs) {
+                                    asio::execution::set_value(std::move(receiver_), std::move(vs)...);
+                                }, values);
+                            }
+                        }, values_);
+                    }
+                    catch (...) {
+                        asio::execution::set_error(std::move(receiver_), std::current_exception());
+                    }
+                }
+
+                Sender sender_;
+                Scheduler scheduler_;
+                Receiver receiver_;
+                values_t<Sender> values_;
+                std::variant<std::monostate, source_operation_type, hop_operation_type> ops_;
+            };
+
+            template <class Sender, class Scheduler>
+            struct sender
+            {
+                template <template <class...> class Tuple, template <class...> class Variant>
+                using value_types =
+                    typename asio::execution::sender_traits<Sender>::template value_types<Tuple, Variant>;
+
+                template <template <class...> class Variant>
+                using error_types = boost::mp11::mp_rename<boost::mp11::mp_unique<boost::mp11::mp_push_back<
+                    typename asio::execution::sender_traits<Sender>::template error_types<boost::mp11::mp_list>,
+                    std::exception_ptr>>, Variant>;
+
+                static constexpr bool sends_done = true;
+
+                Sender sender_;
+                Scheduler scheduler_;
+
+                template <class Receiver>
+                auto connect(Receiver&& receiver) {
+                    return operation_state<asio_ext::remove_cvref_t<Receiver>, Sender, Scheduler>(
+                        std::move(sender_), scheduler_, std::forward<Receiver>(receiver));
+                }
+            };
+        } // namespace detail
+
+        struct cpo
+        {
+            // Runs sender and completes with its values on an operation of scheduler.
+            // Errors and set_done are forwarded from wherever they happen.
+            template <class Sender, class Scheduler>
+            auto operator()(Sender&& sender, Scheduler&& scheduler) const {
+                return detail::sender<asio_ext::remove_cvref_t<Sender>, asio_ext::remove_cvref_t<Scheduler>>{
+                    std::forward<Sender>(sender), std::forward<Scheduler>(scheduler)};
+            }
+        };
+
+        template <typename T = cpo>
+        struct static_instance
+        {
+            static const T instance;
+        };
+
+        template <typename T>
+        const T static_instance<T>::instance = {};
+    }
+} // namespace asio_ext
+
+namespace asio {
+namespace execution {
+static ASIO_CONSTEXPR const asio_ext::via::cpo&
+      via = asio_ext::via::static_instance<>::instance;
+} // namespace execution
+} // namespace asio
+
+#if !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Receiver, class Sender, class Scheduler>
+struct start_member<asio_ext::via::detail::operation_state<Receiver, Sender, Scheduler>>
+{
+    ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+    ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+    typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+#endif // !defined(ASIO_HAS_DEDUCED_START_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Sender, class Scheduler, typename R>
+struct connect_member<asio_ext::via::detail::sender<Sender, Scheduler>, R>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef typename asio_ext::via::detail::operation_state<
+      asio_ext::remove_cvref_t<R>, Sender, Scheduler> result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_CONNECT_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_VALUE_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Receiver, class Sender, class Scheduler, class... Values>
+struct set_value_member<asio_ext::via::detail::source_receiver<Receiver, Sender, Scheduler>, void(Values...)>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef void result_type;
+};
+
+template <class Receiver, class Sender, class Scheduler>
+struct set_value_member<asio_ext::via::detail::hop_receiver<Receiver, Sender, Scheduler>, void()>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = false);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_VALUE_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_ERROR_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Receiver, class Sender, class Scheduler, class E>
+struct set_error_member<asio_ext::via::detail::source_receiver<Receiver, Sender, Scheduler>, E>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+template <class Receiver, class Sender, class Scheduler, class E>
+struct set_error_member<asio_ext::via::detail::hop_receiver<Receiver, Sender, Scheduler>, E>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_ERROR_MEMBER_TRAIT)
+
+#if !defined(ASIO_HAS_DEDUCED_SET_DONE_MEMBER_TRAIT)
+
+namespace asio {
+namespace traits {
+
+template <class Receiver, class Sender, class Scheduler>
+struct set_done_member<asio_ext::via::detail::source_receiver<Receiver, Sender, Scheduler>>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+template <class Receiver, class Sender, class Scheduler>
+struct set_done_member<asio_ext::via::detail::hop_receiver<Receiver, Sender, Scheduler>>
+{
+  ASIO_STATIC_CONSTEXPR(bool, is_valid = true);
+  ASIO_STATIC_CONSTEXPR(bool, is_noexcept = true);
+  typedef void result_type;
+};
+
+} // namespace traits
+} // namespace asio
+
+#endif // !defined(ASIO_HAS_DEDUCED_SET_DONE_MEMBER_TRAIT)
@@ -109,7 +109,7 @@ namespace asio_ext
                 template <typename Rx>
                 operation_state(sender_storage_t<Senders...>&& senders, Rx&& receiver)
                     : senders_(std::move(senders)),
-                    state_(std::make_unique<shared_state_t>(std::forward<Rx>(receiver),
+                    state_(std::make_shared<shared_state_t>(std::forward<Rx>(receiver),
                         std::tuple_size_v<sender_storage_t<Senders...>>)) {
                 }
 
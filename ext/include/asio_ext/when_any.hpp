@@ -102,7 +102,7 @@ namespace asio_ext
 
                 template <typename Rx>
                 operation_state(sender_storage_t<Senders...>&& senders, Rx&& receiver) : senders_(std::move(senders)),
-                    state_(std::make_unique<shared_state_t>(std::forward<Rx>(receiver))) {}
+                    state_(std::make_shared<shared_state_t>(std::forward<Rx>(receiver))) {}
 
                 void start() ASIO_NOEXCEPT {
                     auto sender_to_op = [this](auto&&...senders) {
@@ -0,0 +1,132 @@
+#include <doctest/doctest.h>
+#include <asio_ext/admission_controller.hpp>
+#include <asio_ext/async_semaphore.hpp>
+#include <asio_ext/just.hpp>
+#include <asio_ext/make_receiver.hpp>
+#include <asio_ext/sync_wait.hpp>
+#include <asio_ext/transform.hpp>
+
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+using namespace asio::execution;
+using namespace std::chrono_literals;
+
+namespace
+{
+    // Completes with set_error when its receiver's set_value throws
+    struct retrying_sender
+    {
+        template <template <class...> class Tuple, template <class...> class Variant>
+        using value_types = Variant<Tuple<>>;
+
+        template <template <class...> class Variant>
+        using error_types = Variant<std::exception_ptr>;
+
+        static constexpr bool sends_done = false;
+
+        template <class Receiver>
+        struct operation
+        {
+            Receiver receiver_;
+
+            void start() noexcept {
+                try {
+                    asio::execution::set_value(std::move(receiver_));
+                }
+                catch (...) {
+                    asio::execution::set_error(std::move(receiver_), std::current_exception());
+                }
+            }
+        };
+
+        template <class Receiver>
+        auto connect(Receiver&& rx) {
+            return operation<asio_ext::remove_cvref_t<Receiver>>{ std::forward<Receiver>(rx) };
+        }
+    };
+
+    auto slow(std::chrono::milliseconds duration) {
+        return transform(just(), [duration] {
+            std::this_thread::sleep_for(duration);
+        });
+    }
+}
+
+TEST_CASE("admission_controller: admits while sojourn times are within target")
+{
+    asio_ext::admission_controller controller(20ms, 50ms);
+    for (int i = 0; i < 10; ++i) {
+        REQUIRE(sync_wait(admit(controller, just(int(i)))) == i);
+    }
+    REQUIRE(!controller.shedding());
+    REQUIRE(controller.shed() == 0);
+    REQUIRE(controller.in_flight() == 0);
+}
+
+TEST_CASE("admission_controller: sheds with set_done after an interval above target")
+{
+    asio_ext::admission_controller controller(20ms, 50ms);
+    // One slow operation alone does not start shedding
+    sync_wait(admit(controller, slow(30ms)));
+    REQUIRE(!controller.shedding());
+    std::this_thread::sleep_for(50ms);
+    sync_wait(admit(controller, slow(30ms)));
+    REQUIRE(controller.shedding());
+
+    // Nothing is in flight so the next operation is let through as a probe
+    asio_ext::async_semaphore semaphore(0);
+    auto probe = asio::execution::connect(admit(controller, semaphore.acquire()), asio_ext::value_channel([] {}));
+    asio::execution::start(probe);
+    REQUIRE(controller.in_flight() == 1);
+
+    bool ran = false;
+    bool done = false;
+    auto refused = asio::execution::connect(admit(controller, just(1)), asio_ext::value_channel([&](int) {
+        ran = true;
+    }) + asio_ext::done_channel([&] {
+        done = true;
+    }));
+    asio::execution::start(refused);
+    REQUIRE(!ran);
+    REQUIRE(done);
+    REQUIRE(controller.shed() == 1);
+
+    // The probe completes within target, which stops the shedding
+    semaphore.release();
+    REQUIRE(controller.in_flight() == 0);
+    REQUIRE(!controller.shedding());
+    REQUIRE(sync_wait(admit(controller, just(2))) == 2);
+}
+
+TEST_CASE("admission_controller: errors are forwarded and reported")
+{
+    asio_ext::admission_controller controller;
+    REQUIRE_THROWS_AS(sync_wait(admit(controller, transform(just(), []() -> int {
+        throw std::runtime_error("failed");
+    }))), std::runtime_error);
+    REQUIRE(controller.in_flight() == 0);
+}
+
+TEST_CASE("admission_controller: a throwing set_value followed by set_error is reported once")
+{
+    asio_ext::admission_controller controller;
+    // Keeps one admitted operation in flight so a second report would be visible
+    asio_ext::async_semaphore semaphore(0);
+    auto pending = asio::execution::connect(admit(controller, semaphore.acquire()), asio_ext::value_channel([] {}));
+    asio::execution::start(pending);
+
+    bool failed = false;
+    auto op = asio::execution::connect(admit(controller, retrying_sender{}), asio_ext::value_channel([] {
+        throw std::runtime_error("receiver failed");
+    }) + asio_ext::error_channel([&](std::exception_ptr) {
+        failed = true;
+    }));
+    asio::execution::start(op);
+    REQUIRE(failed);
+    REQUIRE(controller.in_flight() == 1);
+
+    semaphore.release();
+    REQUIRE(controller.in_flight() == 0);
+}
@@ -0,0 +1,172 @@
+#include "allocation_counter.hpp"
+
+#include <doctest/doctest.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    thread_local std::size_t allocation_count = 0;
+    thread_local std::size_t deallocation_count = 0;
+    thread_local std::size_t allocated_byte_count = 0;
+
+    void* counted_allocate(std::size_t size) {
+        ++allocation_count;
+        allocated_byte_count += size;
+        if (void* p = std::malloc(size == 0 ? 1 : size)) {
+            return p;
+        }
+        throw std::bad_alloc();
+    }
+
+    void* counted_allocate(std::size_t size, std::align_val_t alignment) {
+        ++allocation_count;
+        allocated_byte_count += size;
+        auto align = static_cast<std::size_t>(alignment);
+        // aligned_alloc wants a size that is a multiple of the alignment
+        std::size_t rounded = size == 0 ? align : (size + align - 1) / align * align;
+        if (void* p = std::aligned_alloc(align, rounded)) {
+            return p;
+        }
+        throw std::bad_alloc();
+    }
+
+    void counted_deallocate(void* p) noexcept {
+        if (p) {
+            ++deallocation_count;
+            std::free(p);
+        }
+    }
+} // namespace
+
+namespace allocation_counter
+{
+    std::size_t allocations() noexcept {
+        return allocation_count;
+    }
+
+    std::size_t deallocations() noexcept {
+        return deallocation_count;
+    }
+
+    std::size_t allocated_bytes() noexcept {
+        return allocated_byte_count;
+    }
+} // namespace allocation_counter
+
+void* operator new(std::size_t size) {
+    return counted_allocate(size);
+}
+
+void* operator new[](std::size_t size) {
+    return counted_allocate(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return counted_allocate(size);
+    }
+    catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return counted_allocate(size);
+    }
+    catch (...) {
+        return nullptr;
+    }
+}
+
+void operator delete(void* p) noexcept {
+    counted_deallocate(p);
+}
+
+void operator delete[](void* p) noexcept {
+    counted_deallocate(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    counted_deallocate(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    counted_deallocate(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+    counted_deallocate(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+    counted_deallocate(p);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return counted_allocate(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return counted_allocate(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    try {
+        return counted_allocate(size, alignment);
+    }
+    catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    try {
+        return counted_allocate(size, alignment);
+    }
+    catch (...) {
+        return nullptr;
+    }
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+    counted_deallocate(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept {
+    counted_deallocate(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+    counted_deallocate(p);
+}
+
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept {
+    counted_deallocate(p);
+}
+
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+    counted_deallocate(p);
+}
+
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+    counted_deallocate(p);
+}
+
+TEST_CASE("allocation_counter: over-aligned allocations are counted")
+{
+    struct alignas(64) line
+    {
+        char data[64];
+    };
+    allocation_counter::scope scope;
+    auto* p = new line;
+    REQUIRE(reinterpret_cast<std::uintptr_t>(p) % 64 == 0);
+    delete p;
+    REQUIRE(scope.allocations() == 1);
+    REQUIRE(scope.deallocations() == 1);
+    REQUIRE(scope.allocated_bytes() == sizeof(line));
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+
+// Counts calls to the global operator new/delete made by the current thread,
+// over-aligned ones included.
+// The replacement operators live in allocation_counter.cpp.
+namespace allocation_counter
+{
+    std::size_t allocations() noexcept;
+    std::size_t deallocations() noexcept;
+    std::size_t allocated_bytes() noexcept;
+
+    // Snapshot of the counters, reports what happened on this thread since construction.
+    class scope
+    {
+    public:
+        scope() noexcept
+            : allocations_(allocation_counter::allocations()),
+            deallocations_(allocation_counter::deallocations()),
+            bytes_(allocation_counter::allocated_bytes()) {
+        }
+
+        std::size_t allocations() const noexcept {
+            return allocation_counter::allocations() - allocations_;
+        }
+
+        std::size_t deallocations() const noexcept {
+            return allocation_counter::deallocations() - deallocations_;
+        }
+
+        std::size_t allocated_bytes() const noexcept {
+            return allocation_counter::allocated_bytes() - bytes_;
+        }
+
+    private:
+        std::size_t allocations_;
+        std::size_t deallocations_;
+        std::size_t bytes_;
+    };
+} // namespace allocation_counter
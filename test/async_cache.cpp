@@ -0,0 +1,147 @@
+#include <doctest/doctest.h>
+#include <asio/io_context.hpp>
+#include <asio_ext/async_cache.hpp>
+#include <asio_ext/just.hpp>
+#include <asio_ext/let.hpp>
+#include <asio_ext/make_receiver.hpp>
+#include <asio_ext/schedule_after.hpp>
+#include <asio_ext/sync_wait.hpp>
+#include <asio_ext/transform.hpp>
+#include <asio_ext/when_all.hpp>
+
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace asio::execution;
+
+TEST_CASE("async_cache: loaded values are served inline")
+{
+    asio_ext::async_cache<int, std::string> cache(16);
+    int loads = 0;
+    auto loader = [&]() {
+        return transform(just(), [&]() {
+            ++loads;
+            return std::string("value");
+        });
+    };
+    REQUIRE(sync_wait(cache.get(1, loader)) == "value");
+    REQUIRE(sync_wait(cache.get(1, loader)) == "value");
+    REQUIRE(loads == 1);
+    REQUIRE(cache.size() == 1);
+
+    cache.erase(1);
+    REQUIRE(cache.size() == 0);
+    REQUIRE(sync_wait(cache.get(1, loader)) == "value");
+    REQUIRE(loads == 2);
+}
+
+TEST_CASE("async_cache: concurrent gets share one load")
+{
+    asio::io_context ctx;
+    asio_ext::async_cache<int, int> cache(16);
+    int loads = 0;
+    auto loader = [&]() {
+        return transform(schedule_after(ctx.get_executor(), std::chrono::milliseconds(1)), [&]() {
+            return ++loads * 10;
+        });
+    };
+    std::vector<int> results;
+    auto op1 = asio::execution::connect(cache.get(1, loader), asio_ext::value_channel([&](int v) { results.push_back(v); }));
+    auto op2 = asio::execution::connect(cache.get(1, loader), asio_ext::value_channel([&](int v) { results.push_back(v); }));
+    auto op3 = asio::execution::connect(cache.get(2, loader), asio_ext::value_channel([&](int v) { results.push_back(v); }));
+    asio::execution::start(op1);
+    asio::execution::start(op2);
+    asio::execution::start(op3);
+    REQUIRE(cache.size() == 2);
+    ctx.run();
+    REQUIRE(loads == 2);
+    REQUIRE(results.size() == 3);
+    REQUIRE(results[0] == results[1]);
+    REQUIRE(results[0] != results[2]);
+
+    bool served_inline = false;
+    auto op4 = asio::execution::connect(cache.get(1, loader), asio_ext::value_channel([&](int v) {
+        served_inline = v == results[0];
+    }));
+    asio::execution::start(op4);
+    REQUIRE(served_inline);
+}
+
+TEST_CASE("async_cache: failed loads are shared but not cached")
+{
+    asio_ext::async_cache<int, int> cache(16);
+    int loads = 0;
+    auto failing = [&]() {
+        return transform(just(), [&]() -> int {
+            ++loads;
+            throw std::runtime_error("failed");
+        });
+    };
+    REQUIRE_THROWS_AS(sync_wait(cache.get(1, failing)), std::runtime_error);
+    REQUIRE(cache.size() == 0);
+    REQUIRE_THROWS_AS(sync_wait(cache.get(1, failing)), std::runtime_error);
+    REQUIRE(loads == 2);
+}
+
+TEST_CASE("async_cache: evicts entries not referenced since the last sweep")
+{
+    // One shard holding two entries
+    asio_ext::async_cache<int, int> cache(2, 1);
+    int loads = 0;
+    auto loader = [&]() {
+        return transform(just(), [&]() {
+            return ++loads;
+        });
+    };
+    sync_wait(cache.get(1, loader));
+    sync_wait(cache.get(2, loader));
+    // The sweep clears both reference bits and evicts 1
+    sync_wait(cache.get(3, loader));
+    REQUIRE(cache.size() == 2);
+    // 2 has not been referenced since, 3 was just inserted
+    sync_wait(cache.get(4, loader));
+    REQUIRE(loads == 4);
+    sync_wait(cache.get(3, loader));
+    REQUIRE(loads == 4);
+    sync_wait(cache.get(2, loader));
+    REQUIRE(loads == 5);
+    REQUIRE(cache.size() == 2);
+}
+
+TEST_CASE("async_cache: composes with when_all and let")
+{
+    asio_ext::async_cache<std::string, int> cache(64, 4);
+    int loads = 0;
+    auto loader = [&]() {
+        return transform(just(), [&]() {
+            ++loads;
+            return 21;
+        });
+    };
+    int sum = 0;
+    sync_wait(when_all(
+        transform(cache.get("a", loader), [&](int v) { sum += v; }),
+        transform(cache.get("a", loader), [&](int v) { sum += v; })));
+    REQUIRE(sum == 42);
+    REQUIRE(loads == 1);
+
+    int doubled = sync_wait(let(cache.get("a", loader), [&](int& v) {
+        return just(v * 2);
+    }));
+    REQUIRE(doubled == 42);
+    REQUIRE(loads == 1);
+}
+
+TEST_CASE("async_cache: many keys survive shard rehashing")
+{
+    asio_ext::async_cache<int, int> cache(1000, 4);
+    for (int i = 0; i < 1000; ++i) {
+        REQUIRE(sync_wait(cache.get(i, [i]() { return just(i * 2); })) == i * 2);
+    }
+    REQUIRE(cache.size() == 1000);
+    for (int i = 0; i < 1000; ++i) {
+        REQUIRE(sync_wait(cache.get(i, []() { return just(-1); })) == i * 2);
+    }
+}
@@ -0,0 +1,166 @@
+#include <doctest/doctest.h>
+#include <asio_ext/async_mutex.hpp>
+#include <asio_ext/just.hpp>
+#include <asio_ext/let.hpp>
+#include <asio_ext/make_receiver.hpp>
+#include <asio_ext/sync_wait.hpp>
+#include <asio_ext/transform.hpp>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace asio::execution;
+
+TEST_CASE("async_mutex: lock is handed to the next waiter on unlock")
+{
+    asio_ext::async_mutex mutex;
+    std::vector<int> order;
+    auto op1 = asio::execution::connect(mutex.lock(), asio_ext::value_channel([&]() { order.push_back(1); }));
+    auto op2 = asio::execution::connect(mutex.lock(), asio_ext::value_channel([&]() { order.push_back(2); }));
+    auto op3 = asio::execution::connect(mutex.lock(), asio_ext::value_channel([&]() { order.push_back(3); }));
+    asio::execution::start(op1);
+    asio::execution::start(op2);
+    asio::execution::start(op3);
+    REQUIRE(order == std::vector<int>{1});
+    REQUIRE_FALSE(mutex.try_lock());
+    mutex.unlock();
+    REQUIRE(order == std::vector<int>{1, 2});
+    mutex.unlock();
+    REQUIRE(order == std::vector<int>{1, 2, 3});
+    mutex.unlock();
+    REQUIRE(mutex.try_lock());
+    mutex.unlock();
+}
+
+TEST_CASE("async_mutex: let scopes the critical section")
+{
+    asio_ext::async_mutex mutex;
+    bool locked_inside = false;
+    sync_wait(let(mutex.scoped_lock(), [&](asio_ext::async_lock_guard<asio_ext::async_mutex>& guard) {
+        return transform(just(), [&]() {
+            locked_inside = guard.owns_lock() && !mutex.try_lock();
+        });
+    }));
+    REQUIRE(locked_inside);
+    REQUIRE(mutex.try_lock());
+    mutex.unlock();
+}
+
+TEST_CASE("async_mutex: cancelled waiter does not get the lock")
+{
+    asio_ext::async_mutex mutex;
+    bool done = false;
+    bool locked = false;
+    REQUIRE(mutex.try_lock());
+    auto op1 = asio::execution::connect(mutex.lock(), asio_ext::done_channel([&]() { done = true; }));
+    auto op2 = asio::execution::connect(mutex.lock(), asio_ext::value_channel([&]() { locked = true; }));
+    asio::execution::start(op1);
+    asio::execution::start(op2);
+    op1.cancel();
+    REQUIRE(done);
+    mutex.unlock();
+    REQUIRE(locked);
+}
+
+TEST_CASE("async_mutex: critical sections never overlap across threads")
+{
+    asio_ext::async_mutex mutex;
+    int counter = 0;
+    std::atomic_int inside{ 0 };
+    bool overlapped = false;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 2000; ++i) {
+                sync_wait(let(mutex.scoped_lock(), [&](auto&) {
+                    return transform(just(), [&]() {
+                        overlapped |= ++inside > 1;
+                        ++counter;
+                        --inside;
+                    });
+                }));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    REQUIRE_FALSE(overlapped);
+    REQUIRE(counter == 8000);
+}
+
+TEST_CASE("async_shared_mutex: readers share, writers exclude")
+{
+    asio_ext::async_shared_mutex mutex;
+    int readers = 0;
+    bool writer = false;
+    auto reader1 = asio::execution::connect(mutex.lock_shared(), asio_ext::value_channel([&]() { ++readers; }));
+    auto reader2 = asio::execution::connect(mutex.lock_shared(), asio_ext::value_channel([&]() { ++readers; }));
+    auto writer_op = asio::execution::connect(mutex.lock(), asio_ext::value_channel([&]() { writer = true; }));
+    asio::execution::start(reader1);
+    asio::execution::start(reader2);
+    REQUIRE(readers == 2);
+    asio::execution::start(writer_op);
+    REQUIRE_FALSE(writer);
+    mutex.unlock_shared();
+    REQUIRE_FALSE(writer);
+    mutex.unlock_shared();
+    REQUIRE(writer);
+    REQUIRE_FALSE(mutex.try_lock_shared());
+    mutex.unlock();
+    REQUIRE(mutex.try_lock());
+    mutex.unlock();
+}
+
+TEST_CASE("async_shared_mutex: queued writer holds back later readers")
+{
+    asio_ext::async_shared_mutex mutex;
+    std::vector<int> order;
+    REQUIRE(mutex.try_lock_shared());
+    auto writer_op = asio::execution::connect(mutex.lock(), asio_ext::value_channel([&]() { order.push_back(0); }));
+    auto reader1 = asio::execution::connect(mutex.lock_shared(), asio_ext::value_channel([&]() { order.push_back(1); }));
+    auto reader2 = asio::execution::connect(mutex.lock_shared(), asio_ext::value_channel([&]() { order.push_back(2); }));
+    asio::execution::start(writer_op);
+    asio::execution::start(reader1);
+    asio::execution::start(reader2);
+    REQUIRE(order.empty());
+    mutex.unlock_shared();
+    REQUIRE(order == std::vector<int>{0});
+    mutex.unlock();
+    REQUIRE(order == std::vector<int>{0, 1, 2});
+    mutex.unlock_shared();
+    mutex.unlock_shared();
+}
+
+TEST_CASE("async_shared_mutex: cancelling a queued writer releases the readers behind it")
+{
+    asio_ext::async_shared_mutex mutex;
+    bool done = false;
+    bool reader = false;
+    REQUIRE(mutex.try_lock_shared());
+    auto writer_op = asio::execution::connect(mutex.lock(), asio_ext::done_channel([&]() { done = true; }));
+    auto reader_op = asio::execution::connect(mutex.lock_shared(), asio_ext::value_channel([&]() { reader = true; }));
+    asio::execution::start(writer_op);
+    asio::execution::start(reader_op);
+    REQUIRE_FALSE(reader);
+    writer_op.cancel();
+    REQUIRE(done);
+    REQUIRE(reader);
+    mutex.unlock_shared();
+    mutex.unlock_shared();
+}
+
+TEST_CASE("async_shared_mutex: scoped shared lock composes with let")
+{
+    asio_ext::async_shared_mutex mutex;
+    bool writer_blocked = false;
+    sync_wait(let(mutex.scoped_lock_shared(), [&](auto&) {
+        return transform(just(), [&]() {
+            writer_blocked = !mutex.try_lock();
+        });
+    }));
+    REQUIRE(writer_blocked);
+    REQUIRE(mutex.try_lock());
+    mutex.unlock();
+}
@@ -0,0 +1,117 @@
+#include <doctest/doctest.h>
+#include <asio/io_context.hpp>
+#include <asio_ext/async_scope.hpp>
+#include <asio_ext/just.hpp>
+#include <asio_ext/make_receiver.hpp>
+#include <asio_ext/schedule_after.hpp>
+#include <asio_ext/sync_wait.hpp>
+#include <asio_ext/transform.hpp>
+#include "allocation_counter.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <exception>
+
+using namespace asio::execution;
+
+namespace
+{
+    // Completes inline, reporting whether its operation state was suitably aligned
+    struct aligned_sender
+    {
+        template <template <class...> class Tuple, template <class...> class Variant>
+        using value_types = Variant<Tuple<>>;
+        template <template <class...> class Variant>
+        using error_types = Variant<std::exception_ptr>;
+        static constexpr bool sends_done = false;
+
+        template <class Receiver>
+        struct alignas(64) operation
+        {
+            Receiver receiver_;
+            bool* aligned_;
+
+            void start() noexcept {
+                *aligned_ = reinterpret_cast<std::uintptr_t>(this) % 64 == 0;
+                asio::execution::set_value(std::move(receiver_));
+            }
+        };
+
+        bool* aligned;
+
+        template <class Receiver>
+        operation<asio_ext::remove_cvref_t<Receiver>> connect(Receiver&& receiver) const {
+            return { std::forward<Receiver>(receiver), aligned };
+        }
+    };
+} // namespace
+
+TEST_CASE("async_scope: on_empty completes once spawned work drained")
+{
+    asio::io_context ctx;
+    asio_ext::async_scope scope;
+    int runs = 0;
+    for (int i = 0; i < 3; ++i) {
+        REQUIRE(scope.spawn(transform(schedule_after(ctx.get_executor(), std::chrono::milliseconds(1 + i)), [&]() {
+            ++runs;
+        })));
+    }
+    REQUIRE(scope.size() == 3);
+    bool empty = false;
+    auto op = asio::execution::connect(scope.on_empty(), asio_ext::value_channel([&]() { empty = true; }));
+    asio::execution::start(op);
+    REQUIRE(!empty);
+    ctx.run();
+    REQUIRE(runs == 3);
+    REQUIRE(empty);
+    REQUIRE(scope.size() == 0);
+}
+
+TEST_CASE("async_scope: on_empty of an idle scope completes inline")
+{
+    asio_ext::async_scope scope;
+    REQUIRE(scope.spawn(just()));
+    REQUIRE(scope.size() == 0);
+    sync_wait(scope.on_empty());
+}
+
+TEST_CASE("async_scope: request_stop cancels running work and rejects new work")
+{
+    asio::io_context ctx;
+    asio_ext::async_scope scope;
+    // The timer operations offer cancel(), they complete with set_done once stopped
+    scope.spawn(schedule_after(ctx.get_executor(), std::chrono::hours(1)));
+    scope.spawn(schedule_after(ctx.get_executor(), std::chrono::hours(1)));
+    bool empty = false;
+    auto op = asio::execution::connect(scope.on_empty(), asio_ext::value_channel([&]() { empty = true; }));
+    asio::execution::start(op);
+    scope.request_stop();
+    REQUIRE(scope.stop_requested());
+    REQUIRE(!scope.spawn(just()));
+    ctx.run();
+    REQUIRE(empty);
+    REQUIRE(scope.size() == 0);
+}
+
+TEST_CASE("async_scope: operation states are recycled through the slab")
+{
+    asio_ext::async_scope scope(256, 4);
+    REQUIRE(scope.spawn(just()));
+    allocation_counter::scope allocations;
+    for (int i = 0; i < 100; ++i) {
+        REQUIRE(scope.spawn(just(i)));
+    }
+    REQUIRE(allocations.allocations() == 0);
+}
+
+TEST_CASE("async_scope: over-aligned operation states are allocated aligned")
+{
+    asio_ext::async_scope scope(256, 4);
+    for (int i = 0; i < 8; ++i) {
+        bool aligned = false;
+        allocation_counter::scope allocations;
+        REQUIRE(scope.spawn(aligned_sender{ &aligned }));
+        REQUIRE(aligned);
+        REQUIRE(allocations.deallocations() == 1);
+    }
+}
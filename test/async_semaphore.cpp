@@ -0,0 +1,116 @@
+#include <doctest/doctest.h>
+#include <asio/io_context.hpp>
+#include <asio_ext/async_semaphore.hpp>
+#include <asio_ext/just.hpp>
+#include <asio_ext/make_receiver.hpp>
+#include <asio_ext/schedule_after.hpp>
+#include <asio_ext/sync_wait.hpp>
+#include <asio_ext/transform.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace asio::execution;
+
+TEST_CASE("async_semaphore: permits are granted inline until exhausted")
+{
+    asio_ext::async_semaphore semaphore(2);
+    int acquired = 0;
+    auto op1 = asio::execution::connect(semaphore.acquire(), asio_ext::value_channel([&]() { ++acquired; }));
+    auto op2 = asio::execution::connect(semaphore.acquire(), asio_ext::value_channel([&]() { ++acquired; }));
+    auto op3 = asio::execution::connect(semaphore.acquire(), asio_ext::value_channel([&]() { ++acquired; }));
+    asio::execution::start(op1);
+    asio::execution::start(op2);
+    REQUIRE(acquired == 2);
+    REQUIRE(semaphore.available() == 0);
+    asio::execution::start(op3);
+    REQUIRE(acquired == 2);
+    semaphore.release();
+    REQUIRE(acquired == 3);
+    REQUIRE(semaphore.available() == 0);
+}
+
+TEST_CASE("async_semaphore: waiters are served in FIFO order")
+{
+    asio_ext::async_semaphore semaphore(0);
+    std::vector<int> order;
+    auto op1 = asio::execution::connect(semaphore.acquire(), asio_ext::value_channel([&]() { order.push_back(1); }));
+    auto op2 = asio::execution::connect(semaphore.acquire(), asio_ext::value_channel([&]() { order.push_back(2); }));
+    auto op3 = asio::execution::connect(semaphore.acquire(), asio_ext::value_channel([&]() { order.push_back(3); }));
+    asio::execution::start(op1);
+    asio::execution::start(op2);
+    asio::execution::start(op3);
+    REQUIRE_FALSE(semaphore.try_acquire());
+    semaphore.release(2);
+    REQUIRE(order == std::vector<int>{1, 2});
+    semaphore.release();
+    REQUIRE(order == std::vector<int>{1, 2, 3});
+}
+
+TEST_CASE("async_semaphore: cancelled waiter completes with set_done")
+{
+    asio_ext::async_semaphore semaphore(0);
+    bool done = false;
+    bool acquired = false;
+    auto op1 = asio::execution::connect(semaphore.acquire(), asio_ext::done_channel([&]() { done = true; }));
+    auto op2 = asio::execution::connect(semaphore.acquire(), asio_ext::value_channel([&]() { acquired = true; }));
+    asio::execution::start(op1);
+    asio::execution::start(op2);
+    op1.cancel();
+    REQUIRE(done);
+    semaphore.release();
+    REQUIRE(acquired);
+}
+
+TEST_CASE("async_semaphore: with_permit holds the permit until the sender completes")
+{
+    asio::io_context ctx;
+    asio_ext::async_semaphore semaphore(2);
+    int completed = 0;
+    auto make_op = [&]() {
+        return asio::execution::connect(
+            with_permit(semaphore, schedule_after(ctx.get_executor(), std::chrono::milliseconds(1))),
+            asio_ext::value_channel([&]() { ++completed; }));
+    };
+    using operation_type = decltype(make_op());
+    std::vector<asio_ext::optional<operation_type>> ops(6);
+    for (auto& op : ops) {
+        op.emplace(make_op());
+        asio::execution::start(*op);
+    }
+    REQUIRE(semaphore.available() == 0);
+    REQUIRE(ctx.run_one() == 1);
+    REQUIRE(completed == 1);
+    REQUIRE(semaphore.available() == 0);
+    ctx.run();
+    REQUIRE(completed == 6);
+    REQUIRE(semaphore.available() == 2);
+}
+
+TEST_CASE("async_semaphore: permits are never oversubscribed across threads")
+{
+    asio_ext::async_semaphore semaphore(2);
+    std::atomic_int in_flight{ 0 };
+    std::atomic_int max_in_flight{ 0 };
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 2000; ++i) {
+                sync_wait(with_permit(semaphore, transform(just(), [&]() {
+                    int now = ++in_flight;
+                    int max = max_in_flight.load();
+                    while (now > max && !max_in_flight.compare_exchange_weak(max, now)) {
+                    }
+                    --in_flight;
+                })));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    REQUIRE(max_in_flight.load() <= 2);
+    REQUIRE(semaphore.available() == 2);
+}
@@ -0,0 +1,63 @@
+#include <doctest/doctest.h>
+#include <asio/io_context.hpp>
+#include <asio/local/connect_pair.hpp>
+#include <asio/local/stream_protocol.hpp>
+#include <asio_ext/async_read_some.hpp>
+#include <asio_ext/async_write.hpp>
+#include <asio_ext/make_receiver.hpp>
+#include <asio_ext/slab.hpp>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace asio::execution;
+
+TEST_CASE("async_write: gather write of slab buffers is read back into a slab buffer")
+{
+    asio::io_context ctx;
+    asio::local::stream_protocol::socket writer(ctx), reader(ctx);
+    asio::local::connect_pair(writer, reader);
+
+    asio_ext::buffer_slab slab(16, 3);
+    auto hello = slab.allocate();
+    auto world = slab.allocate();
+    std::memcpy(hello.data(), "hello ", 6);
+    hello.resize(6);
+    std::memcpy(world.data(), "world", 5);
+    world.resize(5);
+
+    std::size_t written = 0;
+    auto write_op = asio::execution::connect(
+        async_write(writer, std::vector<asio_ext::slab_buffer>{hello, world}),
+        asio_ext::value_channel([&](std::size_t n) { written = n; }));
+
+    std::string received;
+    auto read_op = asio::execution::connect(
+        async_read_some(reader, slab.allocate()),
+        asio_ext::value_channel([&](asio_ext::slab_buffer buffer, std::size_t n) {
+            buffer.resize(n);
+            received.assign(static_cast<const char*>(buffer.data()), buffer.size());
+        }));
+
+    asio::execution::start(write_op);
+    asio::execution::start(read_op);
+    ctx.run();
+
+    REQUIRE(written == 11);
+    REQUIRE(received == "hello world");
+}
+
+TEST_CASE("async_write: errors are reported through set_error")
+{
+    asio::io_context ctx;
+    asio::local::stream_protocol::socket writer(ctx);
+    bool failed = false;
+    const char payload[] = "x";
+    auto op = asio::execution::connect(async_write(writer, asio::buffer(payload)),
+        asio_ext::value_channel([](std::size_t) {}) +
+        asio_ext::error_channel([&](std::exception_ptr) { failed = true; }));
+    asio::execution::start(op);
+    ctx.run();
+    REQUIRE(failed);
+}
@@ -0,0 +1,65 @@
+#include <doctest/doctest.h>
+#include <asio/io_context.hpp>
+#include <asio_ext/batch.hpp>
+#include <asio_ext/make_receiver.hpp>
+
+#include <chrono>
+#include <stdexcept>
+#include <vector>
+
+using namespace asio::execution;
+
+TEST_CASE("batch: completes when max_items is reached")
+{
+    asio::io_context ctx;
+    asio_ext::batch_queue<int> queue(ctx.get_executor(), 4);
+    std::vector<int> result;
+    auto op = asio::execution::connect(batch(queue, 3, std::chrono::hours(1)), asio_ext::value_channel([&](std::vector<int> items) {
+        result = std::move(items);
+    }));
+    asio::execution::start(op);
+    queue.push(1);
+    queue.push(2);
+    REQUIRE(result.empty());
+    queue.push(3);
+    ctx.run();
+    REQUIRE(result == std::vector<int>{1, 2, 3});
+    REQUIRE(queue.size() == 0);
+}
+
+TEST_CASE("batch: completes with a partial batch after max_delay")
+{
+    asio::io_context ctx;
+    asio_ext::batch_queue<int> queue(ctx.get_executor(), 4);
+    std::vector<int> result;
+    auto op = asio::execution::connect(batch(queue, 3, std::chrono::milliseconds(1)), asio_ext::value_channel([&](std::vector<int> items) {
+        result = std::move(items);
+    }));
+    asio::execution::start(op);
+    queue.push(1);
+    ctx.run();
+    REQUIRE(result == std::vector<int>{1});
+}
+
+TEST_CASE("batch: idle queue completes on the first push after max_delay")
+{
+    asio::io_context ctx;
+    asio_ext::batch_queue<int> queue(ctx.get_executor(), 4);
+    bool called = false;
+    auto op = asio::execution::connect(batch(queue, 3, std::chrono::milliseconds(1)), asio_ext::value_channel([&](std::vector<int> items) {
+        REQUIRE(items == std::vector<int>{7});
+        called = true;
+    }));
+    asio::execution::start(op);
+    ctx.run();
+    REQUIRE_FALSE(called);
+    queue.push(7);
+    REQUIRE(called);
+}
+
+TEST_CASE("batch: rejects a max_items of 0")
+{
+    asio::io_context ctx;
+    asio_ext::batch_queue<int> queue(ctx.get_executor(), 4);
+    REQUIRE_THROWS_AS(batch(queue, 0, std::chrono::hours(1)), std::invalid_argument);
+}
@@ -0,0 +1,133 @@
+#include <doctest/doctest.h>
+#include <asio_ext/async_semaphore.hpp>
+#include <asio_ext/circuit_breaker.hpp>
+#include <asio_ext/just.hpp>
+#include <asio_ext/make_receiver.hpp>
+#include <asio_ext/sync_wait.hpp>
+#include <asio_ext/transform.hpp>
+#include "throwing_connect.hpp"
+
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+using namespace asio::execution;
+using namespace std::chrono_literals;
+
+namespace
+{
+    auto failing(int& calls) {
+        return transform(just(), [&calls]() -> int {
+            ++calls;
+            throw std::runtime_error("backend down");
+        });
+    }
+
+    void trip(asio_ext::breaker& b, int& calls) {
+        for (int i = 0; i < 4; ++i) {
+            REQUIRE_THROWS_AS(sync_wait(circuit_breaker(b, failing(calls))), std::runtime_error);
+        }
+    }
+}
+
+TEST_CASE("circuit_breaker: stays closed below the failure ratio")
+{
+    asio_ext::breaker b(0.5, 4);
+    int calls = 0;
+    for (int i = 0; i < 6; ++i) {
+        REQUIRE(sync_wait(circuit_breaker(b, just(int(i)))) == i);
+    }
+    REQUIRE_THROWS_AS(sync_wait(circuit_breaker(b, failing(calls))), std::runtime_error);
+    REQUIRE_THROWS_AS(sync_wait(circuit_breaker(b, failing(calls))), std::runtime_error);
+    REQUIRE(b.current_state() == asio_ext::breaker::state::closed);
+    REQUIRE(b.window_counts() == std::make_pair(std::uint64_t(6), std::uint64_t(2)));
+}
+
+TEST_CASE("circuit_breaker: fails fast with circuit_open_error once open")
+{
+    asio_ext::breaker b(0.5, 4, 10s, 1h);
+    int calls = 0;
+    trip(b, calls);
+    REQUIRE(b.current_state() == asio_ext::breaker::state::open);
+    REQUIRE(calls == 4);
+
+    REQUIRE_THROWS_AS(sync_wait(circuit_breaker(b, failing(calls))), asio_ext::circuit_open_error);
+    REQUIRE(calls == 4);
+    REQUIRE(b.rejected() == 1);
+}
+
+TEST_CASE("circuit_breaker: lets a single probe through when half open")
+{
+    asio_ext::breaker b(0.5, 4, 10s, 20ms);
+    int calls = 0;
+    trip(b, calls);
+    std::this_thread::sleep_for(30ms);
+
+    asio_ext::async_semaphore semaphore(0);
+    bool probed = false;
+    auto probe = asio::execution::connect(circuit_breaker(b, semaphore.acquire()), asio_ext::value_channel([&] {
+        probed = true;
+    }));
+    asio::execution::start(probe);
+    REQUIRE(b.current_state() == asio_ext::breaker::state::half_open);
+    REQUIRE_THROWS_AS(sync_wait(circuit_breaker(b, just(1))), asio_ext::circuit_open_error);
+
+    // A successful probe closes the breaker with a clean window
+    semaphore.release();
+    REQUIRE(probed);
+    REQUIRE(b.current_state() == asio_ext::breaker::state::closed);
+    REQUIRE(b.window_counts() == std::make_pair(std::uint64_t(0), std::uint64_t(0)));
+    REQUIRE(sync_wait(circuit_breaker(b, just(2))) == 2);
+}
+
+TEST_CASE("circuit_breaker: a failed probe opens the breaker again")
+{
+    asio_ext::breaker b(0.5, 4, 10s, 20ms);
+    int calls = 0;
+    trip(b, calls);
+    std::this_thread::sleep_for(30ms);
+    REQUIRE_THROWS_AS(sync_wait(circuit_breaker(b, failing(calls))), std::runtime_error);
+    REQUIRE(calls == 5);
+    REQUIRE(b.current_state() == asio_ext::breaker::state::open);
+    REQUIRE_THROWS_AS(sync_wait(circuit_breaker(b, just(1))), asio_ext::circuit_open_error);
+}
+
+TEST_CASE("circuit_breaker: a throwing connect completes the receiver with the error")
+{
+    asio_ext::breaker b(0.5, 4);
+    auto owned = std::make_shared<int>(1);
+    std::exception_ptr error;
+    auto op = asio::execution::connect(circuit_breaker(b, throwing_connect{}), asio_ext::value_channel([owned](int) {
+    }) + asio_ext::error_channel([&error, owned](std::exception_ptr e) {
+        // Still holding its captures, the receiver was not moved from
+        REQUIRE(*owned == 1);
+        error = e;
+    }));
+    asio::execution::start(op);
+    REQUIRE(error);
+    REQUIRE_THROWS_AS(std::rethrow_exception(error), std::runtime_error);
+    REQUIRE(b.window_counts() == std::make_pair(std::uint64_t(0), std::uint64_t(0)));
+}
+
+TEST_CASE("circuit_breaker: a throwing consumer is not recorded as a backend failure")
+{
+    asio_ext::breaker b(0.5, 4);
+    bool failed = false;
+    // just completes with set_error when set_value throws
+    auto op = asio::execution::connect(circuit_breaker(b, just(1)), asio_ext::value_channel([](int) {
+        throw std::runtime_error("consumer failed");
+    }) + asio_ext::error_channel([&](std::exception_ptr) {
+        failed = true;
+    }));
+    asio::execution::start(op);
+    REQUIRE(failed);
+    REQUIRE(b.window_counts() == std::make_pair(std::uint64_t(1), std::uint64_t(0)));
+}
+
+TEST_CASE("circuit_breaker: rejects invalid settings")
+{
+    REQUIRE_THROWS_AS(asio_ext::breaker(0.5, 4, 0s), std::invalid_argument);
+    REQUIRE_THROWS_AS(asio_ext::breaker(0.0), std::invalid_argument);
+    REQUIRE_THROWS_AS(asio_ext::breaker(1.5), std::invalid_argument);
+}
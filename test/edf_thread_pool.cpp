@@ -0,0 +1,258 @@
+#include <doctest/doctest.h>
+#include <asio_ext/edf_thread_pool.hpp>
+#include <asio_ext/make_receiver.hpp>
+#include <asio_ext/sync_wait.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace asio::execution;
+using namespace std::chrono_literals;
+
+namespace
+{
+    using function_operation = asio::execution::connect_result_t<asio_ext::edf_detail::sender,
+        decltype(asio_ext::value_channel(std::function<void()>()))>;
+
+    // Keeps a worker busy until released
+    struct blocker
+    {
+        template <class Scheduler>
+        explicit blocker(Scheduler scheduler)
+            : op_(asio::execution::connect(scheduler.schedule_before(asio_ext::edf_thread_pool::clock::now() + 1h),
+                asio_ext::value_channel(std::function<void()>([this] {
+                    blocked_.set_value();
+                    release_.get_future().wait();
+                })))) {
+            asio::execution::start(op_);
+            blocked_.get_future().wait();
+        }
+
+        void release() {
+            release_.set_value();
+        }
+
+        std::promise<void> blocked_;
+        std::promise<void> release_;
+        function_operation op_;
+    };
+}
+
+TEST_CASE("edf_thread_pool: pairing heap pops in deadline order after erasing")
+{
+    std::mt19937 rng(42);
+    std::vector<asio_ext::edf_detail::task> tasks(500);
+    asio_ext::edf_detail::pairing_heap heap;
+    for (auto& t : tasks) {
+        t.deadline_ = asio_ext::edf_thread_pool::clock::time_point(std::chrono::milliseconds(rng() % 1000));
+        heap.push(&t);
+    }
+    // Pop a few to give the heap some depth, then erase every third task
+    std::vector<asio_ext::edf_detail::task*> popped;
+    for (int i = 0; i < 10; ++i) {
+        popped.push_back(heap.pop());
+    }
+    for (std::size_t i = 0; i < tasks.size(); i += 3) {
+        if (std::find(popped.begin(), popped.end(), &tasks[i]) == popped.end()) {
+            heap.erase(&tasks[i]);
+        }
+    }
+    std::size_t remaining = 0;
+    auto previous = popped.back()->deadline_;
+    while (auto* t = heap.pop()) {
+        REQUIRE(t->deadline_ >= previous);
+        REQUIRE((t - tasks.data()) % 3 != 0);
+        previous = t->deadline_;
+        ++remaining;
+    }
+    std::size_t expected = std::count_if(tasks.begin(), tasks.end(), [&](auto& t) {
+        return (&t - tasks.data()) % 3 != 0 && std::find(popped.begin(), popped.end(), &t) == popped.end();
+    });
+    REQUIRE(remaining == expected);
+}
+
+TEST_CASE("edf_thread_pool: queued work runs earliest deadline first")
+{
+    asio_ext::edf_thread_pool pool(1);
+    auto scheduler = pool.get_scheduler();
+    blocker block(scheduler);
+
+    std::mutex mutex;
+    std::string order;
+    std::promise<void> finished;
+    auto append = [&](std::string item) {
+        std::lock_guard<std::mutex> lock(mutex);
+        order += item;
+        if (order.size() == 4) {
+            finished.set_value();
+        }
+    };
+    auto now = asio_ext::edf_thread_pool::clock::now();
+    auto op_c = asio::execution::connect(scheduler.schedule_before(now + 30min), asio_ext::value_channel([&] {
+        append("c");
+    }));
+    auto op_d = asio::execution::connect(scheduler.schedule(), asio_ext::value_channel([&] {
+        append("d");
+    }));
+    auto op_a = asio::execution::connect(scheduler.schedule_before(now + 10min), asio_ext::value_channel([&] {
+        append("a");
+    }));
+    auto op_b = asio::execution::connect(scheduler.schedule_before(now + 20min), asio_ext::value_channel([&] {
+        append("b");
+    }));
+    asio::execution::start(op_c);
+    asio::execution::start(op_d);
+    asio::execution::start(op_a);
+    asio::execution::start(op_b);
+    block.release();
+    finished.get_future().wait();
+    REQUIRE(order == "abcd");
+}
+
+TEST_CASE("edf_thread_pool: late work is dropped with set_done")
+{
+    asio_ext::edf_thread_pool pool(1);
+    auto scheduler = pool.get_scheduler();
+
+    bool done = false;
+    auto late = asio::execution::connect(scheduler.schedule_before(asio_ext::edf_thread_pool::clock::now() - 1ms),
+        asio_ext::done_channel([&] {
+            done = true;
+        }));
+    asio::execution::start(late);
+    REQUIRE(done);
+    REQUIRE(pool.dropped() == 1);
+
+    // Misses its deadline while queued behind the blocker
+    blocker block(scheduler);
+    std::promise<bool> ran;
+    auto queued = asio::execution::connect(scheduler.schedule_before(asio_ext::edf_thread_pool::clock::now() + 10ms),
+        asio_ext::value_channel([&] {
+            ran.set_value(true);
+        }) + asio_ext::done_channel([&] {
+            ran.set_value(false);
+        }));
+    asio::execution::start(queued);
+    std::this_thread::sleep_for(30ms);
+    block.release();
+    REQUIRE(!ran.get_future().get());
+    REQUIRE(pool.dropped() == 2);
+}
+
+TEST_CASE("edf_thread_pool: cancel takes queued work out of the heap")
+{
+    asio_ext::edf_thread_pool pool(1);
+    auto scheduler = pool.get_scheduler();
+    blocker block(scheduler);
+
+    int values = 0;
+    int dones = 0;
+    auto op = asio::execution::connect(scheduler.schedule(), asio_ext::value_channel([&] {
+        ++values;
+    }) + asio_ext::done_channel([&] {
+        ++dones;
+    }));
+    asio::execution::start(op);
+    op.cancel();
+    REQUIRE(dones == 1);
+    op.cancel();
+    REQUIRE(dones == 1);
+
+    block.release();
+    sync_wait(scheduler.schedule());
+    REQUIRE(values == 0);
+    REQUIRE(pool.dropped() == 0);
+}
+
+TEST_CASE("edf_thread_pool: cancel races with start without losing the operation")
+{
+    asio_ext::edf_thread_pool pool(1);
+    auto scheduler = pool.get_scheduler();
+    blocker block(scheduler);
+
+    std::atomic<int> values{ 0 };
+    std::atomic<int> dones{ 0 };
+    for (int i = 0; i < 200; ++i) {
+        auto op = asio::execution::connect(scheduler.schedule(), asio_ext::value_channel([&] {
+            ++values;
+        }) + asio_ext::done_channel([&] {
+            ++dones;
+        }));
+        std::atomic<bool> go{ false };
+        // Keeps cancelling until the operation is found in a heap
+        std::thread canceller([&] {
+            while (!go.load()) {
+            }
+            while (dones.load() == i) {
+                op.cancel();
+            }
+        });
+        go.store(true);
+        asio::execution::start(op);
+        canceller.join();
+    }
+    REQUIRE(dones == 200);
+
+    block.release();
+    sync_wait(scheduler.schedule());
+    REQUIRE(values == 0);
+}
+
+TEST_CASE("edf_thread_pool: an idle worker steals the earliest deadline")
+{
+    asio_ext::edf_thread_pool pool(2);
+    auto scheduler = pool.get_scheduler();
+    std::optional<function_operation> inner;
+    std::promise<std::thread::id> inner_ran;
+    std::thread::id outer_ran;
+    std::promise<bool> stolen;
+    // Work started from a busy worker goes to its own heap, the idle one has to steal it
+    auto outer = asio::execution::connect(scheduler.schedule(), asio_ext::value_channel([&] {
+        outer_ran = std::this_thread::get_id();
+        asio::execution::start(inner.emplace(asio::execution::connect(
+            scheduler.schedule_before(asio_ext::edf_thread_pool::clock::now() + 1min),
+            asio_ext::value_channel(std::function<void()>([&] {
+                inner_ran.set_value(std::this_thread::get_id());
+            })))));
+        auto ran = inner_ran.get_future();
+        stolen.set_value(ran.wait_for(10s) == std::future_status::ready && ran.get() != outer_ran);
+    }));
+    asio::execution::start(outer);
+    REQUIRE(stolen.get_future().get());
+
+    std::atomic<int> count{ 0 };
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([&] {
+            for (int j = 0; j < 500; ++j) {
+                sync_wait(scheduler.schedule_before(asio_ext::edf_thread_pool::clock::now() + 1min));
+                ++count;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    REQUIRE(count == 2000);
+}
+
+TEST_CASE("edf_thread_pool: operations started after stop complete with set_done")
+{
+    asio_ext::edf_thread_pool pool(1);
+    pool.stop();
+    bool done = false;
+    auto op = asio::execution::connect(pool.get_scheduler().schedule(), asio_ext::done_channel([&] {
+        done = true;
+    }));
+    asio::execution::start(op);
+    REQUIRE(done);
+}
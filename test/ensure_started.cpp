@@ -0,0 +1,140 @@
+#include <doctest/doctest.h>
+#include <asio/io_context.hpp>
+#include <asio_ext/ensure_started.hpp>
+#include <asio_ext/just.hpp>
+#include <asio_ext/make_receiver.hpp>
+#include <asio_ext/schedule_after.hpp>
+#include <asio_ext/sync_wait.hpp>
+#include <asio_ext/transform.hpp>
+#include "allocation_counter.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+using namespace asio::execution;
+
+namespace
+{
+    struct counted_resource
+    {
+        std::size_t allocations = 0;
+        std::size_t deallocations = 0;
+    };
+
+    template <class T>
+    struct counting_allocator
+    {
+        using value_type = T;
+
+        counted_resource* resource_;
+
+        explicit counting_allocator(counted_resource* resource) noexcept : resource_(resource) {}
+        template <class U>
+        counting_allocator(const counting_allocator<U>& other) noexcept : resource_(other.resource_) {}
+
+        T* allocate(std::size_t n) {
+            ++resource_->allocations;
+            return std::allocator<T>().allocate(n);
+        }
+
+        void deallocate(T* p, std::size_t n) noexcept {
+            ++resource_->deallocations;
+            std::allocator<T>().deallocate(p, n);
+        }
+
+        template <class U>
+        bool operator==(const counting_allocator<U>& other) const noexcept {
+            return resource_ == other.resource_;
+        }
+        template <class U>
+        bool operator!=(const counting_allocator<U>& other) const noexcept {
+            return resource_ != other.resource_;
+        }
+    };
+}
+
+TEST_CASE("ensure_started: work starts before the result is consumed")
+{
+    bool ran = false;
+    auto started = ensure_started(transform(just(), [&]() {
+        ran = true;
+        return std::string("result");
+    }));
+    REQUIRE(ran);
+    std::string result = sync_wait(std::move(started));
+    REQUIRE(result == "result");
+}
+
+TEST_CASE("ensure_started: consumer started before completion is notified")
+{
+    asio::io_context ctx;
+    auto started = ensure_started(transform(schedule_after(ctx.get_executor(), std::chrono::milliseconds(1)), []() {
+        return 5;
+    }));
+    int result = 0;
+    auto op = asio::execution::connect(std::move(started), asio_ext::value_channel([&](int v) { result = v; }));
+    asio::execution::start(op);
+    REQUIRE(result == 0);
+    ctx.run();
+    REQUIRE(result == 5);
+}
+
+TEST_CASE("ensure_started: errors reach the consumer")
+{
+    auto started = ensure_started(transform(just(), []() -> int {
+        throw std::runtime_error("failed");
+    }));
+    REQUIRE_THROWS_AS(sync_wait(std::move(started)), std::runtime_error);
+}
+
+TEST_CASE("ensure_started: dropped sender lets the work finish and frees the state")
+{
+    asio::io_context ctx;
+    counted_resource resource;
+    bool ran = false;
+    {
+        auto started = ensure_started(transform(schedule_after(ctx.get_executor(), std::chrono::milliseconds(1)), [&]() {
+            ran = true;
+        }), counting_allocator<std::byte>(&resource));
+    }
+    REQUIRE(resource.allocations == 1);
+    REQUIRE(resource.deallocations == 0);
+    ctx.run();
+    REQUIRE(ran);
+    REQUIRE(resource.deallocations == 1);
+}
+
+TEST_CASE("ensure_started: allocates one block")
+{
+    allocation_counter::scope allocations;
+    {
+        auto started = ensure_started(just(1));
+        sync_wait(std::move(started));
+    }
+    auto allocated = allocations.allocations();
+    auto deallocated = allocations.deallocations();
+    REQUIRE(allocated == 1);
+    REQUIRE(deallocated == 1);
+}
+
+TEST_CASE("start_detached: operation state is freed on completion")
+{
+    asio::io_context ctx;
+    counted_resource resource;
+    int runs = 0;
+    start_detached(transform(schedule_after(ctx.get_executor(), std::chrono::milliseconds(1)), [&]() {
+        ++runs;
+    }), counting_allocator<std::byte>(&resource));
+    start_detached(transform(just(), [&]() {
+        ++runs;
+    }), counting_allocator<std::byte>(&resource));
+    REQUIRE(runs == 1);
+    REQUIRE(resource.allocations == 2);
+    REQUIRE(resource.deallocations == 1);
+    ctx.run();
+    REQUIRE(runs == 2);
+    REQUIRE(resource.deallocations == 2);
+}
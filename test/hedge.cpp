@@ -0,0 +1,193 @@
+#include <doctest/doctest.h>
+#include <asio/io_context.hpp>
+#include <asio_ext/hedge.hpp>
+#include <asio_ext/make_receiver.hpp>
+
+#include <chrono>
+#include <exception>
+#include <future>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace asio::execution;
+
+namespace
+{
+    // The n:th call waits delays[n], schedule_after operations support cancel()
+    struct timed_factory
+    {
+        asio::io_context* ctx;
+        int* calls;
+        std::chrono::steady_clock::duration delays[2];
+
+        auto operator()() const {
+            return schedule_after(ctx->get_executor(), delays[(*calls)++]);
+        }
+    };
+
+    // An attempt that either completes from a thread of its own or waits to be cancelled,
+    // recording the thread cancel() is called on
+    struct remote_attempt
+    {
+        template <template <class...> class Tuple, template <class...> class Variant>
+        using value_types = Variant<Tuple<>>;
+        template <template <class...> class Variant>
+        using error_types = Variant<std::exception_ptr>;
+        static constexpr bool sends_done = true;
+
+        template <class Receiver>
+        struct operation
+        {
+            Receiver receiver_;
+            bool wins_;
+            std::vector<std::thread>* threads_;
+            std::thread::id* cancelled_on_;
+
+            void start() noexcept {
+                if (wins_) {
+                    threads_->emplace_back([this] {
+                        asio::execution::set_value(std::move(receiver_));
+                    });
+                }
+            }
+
+            void cancel() {
+                *cancelled_on_ = std::this_thread::get_id();
+                asio::execution::set_done(std::move(receiver_));
+            }
+        };
+
+        bool wins;
+        std::vector<std::thread>* threads;
+        std::thread::id* cancelled_on;
+
+        template <class Receiver>
+        operation<asio_ext::remove_cvref_t<Receiver>> connect(Receiver&& receiver) const {
+            return { std::forward<Receiver>(receiver), wins, threads, cancelled_on };
+        }
+    };
+} // namespace
+
+TEST_CASE("hedge: fast first attempt is not hedged")
+{
+    asio::io_context ctx;
+    int calls = 0;
+    bool completed = false;
+    auto op = asio::execution::connect(
+        hedge(ctx.get_executor(), timed_factory{&ctx, &calls, {std::chrono::milliseconds(1), std::chrono::hours(1)}},
+            std::chrono::hours(1)),
+        asio_ext::value_channel([&]() {
+            completed = true;
+        }));
+    asio::execution::start(op);
+    ctx.run();
+    REQUIRE(completed);
+    REQUIRE(calls == 1);
+}
+
+TEST_CASE("hedge: slow first attempt loses to the hedge and is cancelled")
+{
+    asio::io_context ctx;
+    int calls = 0;
+    bool completed = false;
+    auto op = asio::execution::connect(
+        hedge(ctx.get_executor(), timed_factory{&ctx, &calls, {std::chrono::hours(1), std::chrono::milliseconds(1)}},
+            std::chrono::milliseconds(2)),
+        asio_ext::value_channel([&]() {
+            completed = true;
+        }));
+    auto start_time = std::chrono::steady_clock::now();
+    asio::execution::start(op);
+    ctx.run();
+    REQUIRE(completed);
+    REQUIRE(calls == 2);
+    REQUIRE(std::chrono::steady_clock::now() - start_time < std::chrono::minutes(1));
+}
+
+TEST_CASE("hedge: an error from the first completion wins")
+{
+    asio::io_context ctx;
+    bool failed = false;
+    auto op = asio::execution::connect(
+        hedge(ctx.get_executor(), [&ctx]() {
+            throw std::runtime_error("no connection");
+            return schedule_after(ctx.get_executor(), std::chrono::hours(1));
+        }, std::chrono::hours(1)),
+        asio_ext::value_channel([]() {}) + asio_ext::error_channel([&](std::exception_ptr e) {
+            failed = e != nullptr;
+        }));
+    asio::execution::start(op);
+    ctx.run();
+    REQUIRE(failed);
+}
+
+TEST_CASE("hedge: latency_histogram reports the bucket of the percentile")
+{
+    asio_ext::latency_histogram histogram;
+    for (int i = 0; i < 95; ++i) {
+        histogram.record(std::chrono::microseconds(100));
+    }
+    for (int i = 0; i < 5; ++i) {
+        histogram.record(std::chrono::milliseconds(100));
+    }
+    REQUIRE(histogram.count() == 100);
+    REQUIRE(histogram.percentile(0.5) == std::chrono::microseconds(128));
+    REQUIRE(histogram.percentile(0.99) == std::chrono::microseconds(131072));
+}
+
+TEST_CASE("hedge: delay follows the histogram once it has enough samples")
+{
+    asio::io_context ctx;
+    asio_ext::latency_histogram histogram;
+    for (int i = 0; i < 32; ++i) {
+        histogram.record(std::chrono::microseconds(500));
+    }
+    int calls = 0;
+    bool completed = false;
+    auto op = asio::execution::connect(
+        hedge(ctx.get_executor(), timed_factory{&ctx, &calls, {std::chrono::hours(1), std::chrono::microseconds(1)}},
+            histogram, std::chrono::hours(1)),
+        asio_ext::value_channel([&]() {
+            completed = true;
+        }));
+    asio::execution::start(op);
+    ctx.run();
+    REQUIRE(completed);
+    REQUIRE(calls == 2);
+    REQUIRE(histogram.count() == 33);
+}
+
+TEST_CASE("hedge: losers are cancelled on the executor, not on the winner's thread")
+{
+    asio::io_context ctx;
+    std::optional<decltype(asio::require(ctx.get_executor(), asio::execution::outstanding_work.tracked))> work(
+        asio::require(ctx.get_executor(), asio::execution::outstanding_work.tracked));
+    std::thread io([&] {
+        ctx.run();
+    });
+    auto io_id = io.get_id();
+
+    std::vector<std::thread> threads;
+    std::thread::id cancelled_on;
+    int calls = 0;
+    std::promise<void> completed;
+    auto op = asio::execution::connect(hedge(ctx.get_executor(), [&] {
+        // The first attempt hangs, the hedge completes from a thread of its own
+        return remote_attempt{ calls++ == 1, &threads, &cancelled_on };
+    }, std::chrono::milliseconds(1)),
+        asio_ext::value_channel([&]() {
+            completed.set_value();
+        }));
+    asio::execution::start(op);
+    completed.get_future().wait();
+
+    work.reset();
+    io.join();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    REQUIRE(calls == 2);
+    REQUIRE(cancelled_on == io_id);
+}
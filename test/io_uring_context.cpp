@@ -0,0 +1,162 @@
+#include <doctest/doctest.h>
+#include <asio_ext/io_uring_context.hpp>
+
+#if defined(ASIO_EXT_HAS_IO_URING)
+
+#include <asio_ext/make_receiver.hpp>
+#include <asio_ext/slab.hpp>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace
+{
+    // Old kernels lack io_uring_setup and container seccomp profiles commonly deny it
+    bool io_uring_unavailable() {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        int fd = static_cast<int>(::syscall(__NR_io_uring_setup, 1, &params));
+        if (fd >= 0) {
+            ::close(fd);
+            return false;
+        }
+        return errno == ENOSYS || errno == EPERM;
+    }
+
+    const bool no_io_uring = io_uring_unavailable();
+
+    struct temp_file
+    {
+        char path[32] = "/tmp/asio_ext_XXXXXX";
+        int fd;
+        temp_file() : fd(::mkstemp(path)) {}
+        ~temp_file() {
+            ::close(fd);
+            ::unlink(path);
+        }
+    };
+}
+
+TEST_CASE("io_uring: schedule completes on the context" * doctest::skip(no_io_uring))
+{
+    asio_ext::io_uring::context ctx;
+    bool called = false;
+    auto op = asio::execution::connect(ctx.get_scheduler().schedule(), asio_ext::value_channel([&]() {
+        REQUIRE(ctx.running_in_this_thread());
+        called = true;
+    }));
+    asio::execution::start(op);
+    REQUIRE_FALSE(called);
+    REQUIRE(ctx.run() == 1);
+    REQUIRE(called);
+}
+
+TEST_CASE("io_uring: write_at, fsync and read_at on a temp file" * doctest::skip(no_io_uring))
+{
+    asio_ext::io_uring::context ctx;
+    temp_file file;
+    REQUIRE(file.fd >= 0);
+
+    const std::string payload = "hello io_uring";
+    std::size_t written = 0;
+    bool synced = false;
+    auto write_op = asio::execution::connect(ctx.async_write_at(file.fd, 4, asio::buffer(payload)),
+        asio_ext::value_channel([&](std::size_t n) { written = n; }));
+    asio::execution::start(write_op);
+    ctx.run();
+    REQUIRE(written == payload.size());
+
+    auto sync_op = asio::execution::connect(ctx.fsync(file.fd), asio_ext::value_channel([&]() { synced = true; }));
+    asio::execution::start(sync_op);
+    ctx.run();
+    REQUIRE(synced);
+
+    char data[32] = {};
+    std::size_t read = 0;
+    auto read_op = asio::execution::connect(ctx.async_read_at(file.fd, 4, asio::buffer(data)),
+        asio_ext::value_channel([&](std::size_t n) { read = n; }));
+    asio::execution::start(read_op);
+    ctx.run();
+    REQUIRE(std::string(data, read) == payload);
+}
+
+TEST_CASE("io_uring: registered buffers and files" * doctest::skip(no_io_uring))
+{
+    asio_ext::io_uring::context ctx;
+    temp_file file;
+    asio_ext::buffer_slab slab(64, 2);
+    auto region = slab.region();
+    ctx.register_buffers(&region, 1);
+    ctx.register_files(&file.fd, 1);
+
+    auto out = slab.allocate();
+    std::memcpy(out.data(), "fixed", 5);
+    out.resize(5);
+    auto in = slab.allocate();
+
+    std::size_t read = 0;
+    auto write_op = asio::execution::connect(
+        ctx.async_write_at(asio_ext::io_uring::registered_file{0}, 0, out),
+        asio_ext::value_channel([&](std::size_t n) { REQUIRE(n == 5); }));
+    asio::execution::start(write_op);
+    ctx.run();
+
+    auto read_op = asio::execution::connect(
+        ctx.async_read_at(asio_ext::io_uring::registered_file{0}, 0, in),
+        asio_ext::value_channel([&](std::size_t n) { read = n; }));
+    asio::execution::start(read_op);
+    ctx.run();
+    REQUIRE(std::string(static_cast<const char*>(in.data()), read) == "fixed");
+}
+
+TEST_CASE("io_uring: failed operations complete with set_error" * doctest::skip(no_io_uring))
+{
+    asio_ext::io_uring::context ctx;
+    char data[4];
+    bool failed = false;
+    auto op = asio::execution::connect(ctx.async_read_at(-1, 0, asio::buffer(data)),
+        asio_ext::value_channel([](std::size_t) {}) +
+        asio_ext::error_channel([&](std::exception_ptr) { failed = true; }));
+    asio::execution::start(op);
+    ctx.run();
+    REQUIRE(failed);
+}
+
+TEST_CASE("io_uring: schedule from another thread" * doctest::skip(no_io_uring))
+{
+    asio_ext::io_uring::context ctx;
+    int fds[2];
+    REQUIRE(::pipe(fds) == 0);
+
+    // Keeps the loop busy until the remotely scheduled work writes to the pipe
+    char byte = 0;
+    auto read_op = asio::execution::connect(
+        ctx.async_read_at(fds[0], static_cast<std::uint64_t>(-1), asio::buffer(&byte, 1)),
+        asio_ext::value_channel([](std::size_t) {}));
+    asio::execution::start(read_op);
+
+    std::thread runner([&] { ctx.run(); });
+    bool on_context = false;
+    auto schedule_op = asio::execution::connect(ctx.get_scheduler().schedule(), asio_ext::value_channel([&]() {
+        on_context = ctx.running_in_this_thread();
+        char one = 1;
+        REQUIRE(::write(fds[1], &one, 1) == 1);
+    }));
+    asio::execution::start(schedule_op);
+    runner.join();
+
+    REQUIRE(on_context);
+    REQUIRE(byte == 1);
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+#endif
@@ -2,6 +2,10 @@
 #include <asio/execution/start.hpp>
 #include <asio_ext/just.hpp>
 #include <asio_ext/make_receiver.hpp>
+#include <asio_ext/sender_traits.hpp>
+#include "test_receiver.hpp"
+
+#include <tuple>
 
 using namespace asio::execution;
 TEST_CASE("just: zero value connect")
@@ -39,4 +43,15 @@ TEST_CASE("just: multiple values connect")
     REQUIRE_FALSE(called);
     start(op);
     REQUIRE(called);
-}
\ No newline at end of file
+}
+
+TEST_CASE("just: operation state holds only the receiver and the values")
+{
+    struct expected_layout
+    {
+        counting_receiver receiver;
+        std::tuple<int, double> values;
+    };
+    static_assert(asio_ext::op_state_size_v<asio_ext::just::detail::sender<int, double>, counting_receiver> ==
+        sizeof(expected_layout));
+}
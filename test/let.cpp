@@ -3,6 +3,10 @@
 #include <asio_ext/let.hpp>
 #include <asio_ext/make_receiver.hpp>
 #include <asio_ext/transform.hpp>
+#include <asio_ext/sender_traits.hpp>
+#include <asio_ext/sync_wait.hpp>
+#include "allocation_counter.hpp"
+#include "test_receiver.hpp"
 
 #include <iostream>
 #include <string>
@@ -74,4 +78,33 @@ struct multi_receiver_transform
     auto operator()() {
         return just(std::tuple<>{});
     }
-};
\ No newline at end of file
+};
+
+namespace
+{
+    struct just_twice
+    {
+        auto operator()(int& x) const {
+            return just(x * 2);
+        }
+    };
+} // namespace
+
+TEST_CASE("let: allocates the extended values and the successor operation")
+{
+    allocation_counter::scope allocations;
+    int result = sync_wait(let(just(10), just_twice{}));
+    auto allocated = allocations.allocations();
+    auto deallocated = allocations.deallocations();
+    REQUIRE(result == 20);
+    REQUIRE(allocated == 2);
+    REQUIRE(deallocated == 2);
+}
+
+TEST_CASE("let: operation state is the predecessor connected to the let receiver")
+{
+    using just_sender = asio_ext::just::detail::sender<int>;
+    using let_receiver = asio_ext::let::detail::receiver<just_sender, counting_receiver, just_twice>;
+    static_assert(asio_ext::op_state_size_v<asio_ext::let::detail::sender<just_sender, just_twice>, counting_receiver> ==
+        asio_ext::op_state_size_v<just_sender, let_receiver>);
+}
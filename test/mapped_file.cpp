@@ -0,0 +1,78 @@
+#include <doctest/doctest.h>
+#include <asio_ext/mapped_file.hpp>
+
+#if defined(ASIO_EXT_HAS_MAPPED_FILE)
+
+#include <asio/thread_pool.hpp>
+#include <asio_ext/just.hpp>
+#include <asio_ext/sync_wait.hpp>
+#include <asio_ext/transform.hpp>
+#include <asio_ext/when_all.hpp>
+
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace asio::execution;
+
+namespace
+{
+    struct temp_file
+    {
+        char path[32] = "/tmp/asio_ext_XXXXXX";
+        explicit temp_file(const std::string& content) {
+            int fd = ::mkstemp(path);
+            REQUIRE(::write(fd, content.data(), content.size()) == static_cast<ssize_t>(content.size()));
+            ::fdatasync(fd);
+            // Drop the pages from the cache (best effort) to exercise the background path
+            ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            ::close(fd);
+        }
+        ~temp_file() {
+            ::unlink(path);
+        }
+    };
+
+    std::string to_string(asio::const_buffer buffer) {
+        return std::string(static_cast<const char*>(buffer.data()), buffer.size());
+    }
+}
+
+TEST_CASE("mapped_file: read_range completes with a span into the mapping")
+{
+    temp_file file("0123456789abcdef");
+    asio::thread_pool pool(1);
+    asio_ext::mapped_file mapping(file.path, pool.get_executor());
+    REQUIRE(mapping.size() == 16);
+
+    asio::const_buffer range = sync_wait(mapping.read_range(4, 6));
+    REQUIRE(to_string(range) == "456789");
+    REQUIRE(range.data() == static_cast<const char*>(mapping.data().data()) + 4);
+}
+
+TEST_CASE("mapped_file: parallel range reads with when_all")
+{
+    temp_file file("hello mapped world");
+    asio::thread_pool pool(2);
+    asio_ext::mapped_file mapping(file.path, pool.get_executor());
+
+    std::string first, second;
+    sync_wait(when_all(
+        transform(mapping.read_range(0, 5), [&](asio::const_buffer b) { first = to_string(b); }),
+        transform(mapping.read_range(13, 5), [&](asio::const_buffer b) { second = to_string(b); })));
+    REQUIRE(first == "hello");
+    REQUIRE(second == "world");
+}
+
+TEST_CASE("mapped_file: out of range reads complete with set_error")
+{
+    temp_file file("short");
+    asio::thread_pool pool(1);
+    asio_ext::mapped_file mapping(file.path, pool.get_executor());
+    REQUIRE_THROWS_AS(sync_wait(mapping.read_range(2, 10)), std::out_of_range);
+}
+
+#endif
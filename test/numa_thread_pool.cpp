@@ -0,0 +1,92 @@
+#include <doctest/doctest.h>
+#include <asio_ext/make_receiver.hpp>
+#include <asio_ext/numa_thread_pool.hpp>
+#include <asio_ext/sync_wait.hpp>
+#include <asio_ext/then_chain.hpp>
+#include <asio_ext/transform.hpp>
+
+#include <future>
+#include <stdexcept>
+#include <vector>
+
+using namespace asio::execution;
+
+TEST_CASE("numa_topology: parses a simulated topology")
+{
+    auto topology = asio_ext::numa_topology::parse("0-1,4;2-3");
+    REQUIRE(topology.node_count() == 2);
+    REQUIRE(topology.cpus(0) == std::vector<int>{ 0, 1, 4 });
+    REQUIRE(topology.cpus(1) == std::vector<int>{ 2, 3 });
+    REQUIRE(topology.distance(0, 0) < topology.distance(0, 1));
+
+    REQUIRE_THROWS_AS(asio_ext::numa_topology::parse("0-1;"), std::invalid_argument);
+    REQUIRE_THROWS_AS(asio_ext::numa_topology::parse("3-1"), std::invalid_argument);
+    REQUIRE_THROWS_AS(asio_ext::numa_topology::parse("0;x"), std::invalid_argument);
+}
+
+TEST_CASE("numa_topology: the system topology has cpus on every node")
+{
+    auto topology = asio_ext::numa_topology::system();
+    REQUIRE(topology.node_count() >= 1);
+    for (std::size_t node = 0; node < topology.node_count(); ++node) {
+        REQUIRE(!topology.cpus(node).empty());
+    }
+}
+
+TEST_CASE("numa_thread_pool: schedule_on_node completes on a worker of that node")
+{
+    asio_ext::numa_thread_pool pool(asio_ext::numa_topology::parse("0;1;2"));
+    auto scheduler = pool.get_scheduler();
+    for (std::size_t node = 0; node < 3; ++node) {
+        std::size_t ran_on = sync_wait(transform(scheduler.schedule_on_node(node), [] {
+            return asio_ext::numa_thread_pool::current_node();
+        }));
+        REQUIRE(ran_on == node);
+    }
+    REQUIRE(asio_ext::numa_thread_pool::current_node() == asio_ext::numa_thread_pool::no_node);
+    REQUIRE_THROWS_AS(scheduler.schedule_on_node(3), std::out_of_range);
+}
+
+TEST_CASE("numa_thread_pool: schedule from a worker stays on its node")
+{
+    asio_ext::numa_thread_pool pool(asio_ext::numa_topology::parse("0;1;2"));
+    auto scheduler = pool.get_scheduler();
+    std::size_t ran_on = sync_wait(transform(then_chain(scheduler.schedule_on_node(2), [&] {
+        return scheduler.schedule();
+    }), [] {
+        return asio_ext::numa_thread_pool::current_node();
+    }));
+    REQUIRE(ran_on == 2);
+}
+
+TEST_CASE("numa_thread_pool: a saturated node's work is stolen by another node")
+{
+    asio_ext::numa_thread_pool pool(asio_ext::numa_topology::parse("0;1"));
+    auto scheduler = pool.get_scheduler();
+    std::promise<void> blocked;
+    std::promise<void> release;
+    auto blocker = asio::execution::connect(scheduler.schedule_on_node(0), asio_ext::value_channel([&] {
+        blocked.set_value();
+        release.get_future().wait();
+    }));
+    asio::execution::start(blocker);
+    blocked.get_future().wait();
+
+    std::size_t ran_on = sync_wait(transform(scheduler.schedule_on_node(0), [] {
+        return asio_ext::numa_thread_pool::current_node();
+    }));
+    release.set_value();
+    REQUIRE(ran_on == 1);
+}
+
+TEST_CASE("numa_thread_pool: operations started after stop complete with set_done")
+{
+    asio_ext::numa_thread_pool pool(asio_ext::numa_topology::parse("0"));
+    pool.stop();
+    bool done = false;
+    auto op = asio::execution::connect(pool.get_scheduler().schedule(), asio_ext::done_channel([&] {
+        done = true;
+    }));
+    asio::execution::start(op);
+    REQUIRE(done);
+}
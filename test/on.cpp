@@ -0,0 +1,22 @@
+#include <doctest/doctest.h>
+#include <asio/thread_pool.hpp>
+#include <asio_ext/just.hpp>
+#include <asio_ext/on.hpp>
+#include <asio_ext/sync_wait.hpp>
+#include <asio_ext/transform.hpp>
+
+#include <thread>
+
+using namespace asio::execution;
+
+TEST_CASE("on: the sender is started on the scheduler")
+{
+    asio::thread_pool pool(1);
+    auto ran_on = sync_wait(on(pool.get_executor(), transform(just(3), [](int) {
+        return std::this_thread::get_id();
+    })));
+    REQUIRE(ran_on != std::this_thread::get_id());
+
+    int value = sync_wait(on(pool.get_executor(), just(3)));
+    REQUIRE(value == 3);
+}
@@ -0,0 +1,94 @@
+#include <doctest/doctest.h>
+#include <asio_ext/ensure_started.hpp>
+#include <asio_ext/just.hpp>
+#include <asio_ext/pool_allocator.hpp>
+#include <asio_ext/sync_wait.hpp>
+#include "allocation_counter.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+using namespace asio::execution;
+
+namespace
+{
+    template <std::size_t Size>
+    struct payload
+    {
+        std::byte bytes[Size];
+    };
+}
+
+TEST_CASE("pool_allocator: freed blocks are reused by the same thread")
+{
+    asio_ext::pool_allocator<payload<100>> alloc;
+    auto* first = alloc.allocate(1);
+    alloc.deallocate(first, 1);
+    allocation_counter::scope allocations;
+    auto* second = alloc.allocate(1);
+    REQUIRE(second == first);
+    REQUIRE(reinterpret_cast<std::uintptr_t>(second) % 64 == 0);
+    alloc.deallocate(second, 1);
+    REQUIRE(allocations.allocations() == 0);
+}
+
+TEST_CASE("pool_allocator: blocks freed on another thread return to their owner")
+{
+    // A slab holds 21 blocks of this size, allocating them all empties the local list
+    using block = payload<3000>;
+    asio_ext::pool_allocator<block> alloc;
+    std::vector<block*> blocks;
+    for (int i = 0; i < 21; ++i) {
+        blocks.push_back(alloc.allocate(1));
+    }
+    std::thread([&] {
+        for (auto* b : blocks) {
+            alloc.deallocate(b, 1);
+        }
+    }).join();
+    std::vector<block*> reused;
+    for (int i = 0; i < 21; ++i) {
+        reused.push_back(alloc.allocate(1));
+    }
+    std::sort(blocks.begin(), blocks.end());
+    std::sort(reused.begin(), reused.end());
+    REQUIRE(reused == blocks);
+    for (auto* b : reused) {
+        alloc.deallocate(b, 1);
+    }
+}
+
+TEST_CASE("pool_allocator: blocks outlive the thread that allocated them")
+{
+    asio_ext::pool_allocator<payload<200>> alloc;
+    payload<200>* outstanding = nullptr;
+    std::thread([&] {
+        outstanding = alloc.allocate(1);
+        outstanding->bytes[0] = std::byte{ 1 };
+    }).join();
+    REQUIRE(outstanding->bytes[0] == std::byte{ 1 });
+    alloc.deallocate(outstanding, 1);
+}
+
+TEST_CASE("pool_allocator: arrays and large objects use std::allocator")
+{
+    asio_ext::pool_allocator<payload<8192>> large;
+    allocation_counter::scope allocations;
+    large.deallocate(large.allocate(1), 1);
+    asio_ext::pool_allocator<int> small;
+    small.deallocate(small.allocate(16), 16);
+    REQUIRE(allocations.allocations() == 2);
+}
+
+TEST_CASE("pool_allocator: allocator aware adaptors recycle their state")
+{
+    sync_wait(ensure_started(just(1), asio_ext::pool_allocator<std::byte>()));
+    allocation_counter::scope allocations;
+    for (int i = 0; i < 10; ++i) {
+        REQUIRE(sync_wait(ensure_started(just(i), asio_ext::pool_allocator<std::byte>())) == i);
+    }
+    REQUIRE(allocations.allocations() == 0);
+}
@@ -0,0 +1,50 @@
+#include <doctest/doctest.h>
+#include <asio/io_context.hpp>
+#include <asio_ext/just.hpp>
+#include <asio_ext/make_receiver.hpp>
+#include <asio_ext/pooled.hpp>
+#include <asio_ext/schedule_after.hpp>
+#include <asio_ext/sender_traits.hpp>
+#include <asio_ext/sync_wait.hpp>
+#include <asio_ext/transform.hpp>
+#include "allocation_counter.hpp"
+#include "test_receiver.hpp"
+
+#include <chrono>
+#include <string>
+
+using namespace asio::execution;
+
+TEST_CASE("pooled: completes like the wrapped sender")
+{
+    std::string result = sync_wait(pooled(transform(just(std::string("hello")), [](std::string s) {
+        return s + " world";
+    })));
+    REQUIRE(result == "hello world");
+}
+
+TEST_CASE("pooled: operation state is one pointer and recycled")
+{
+    auto make = []() {
+        return pooled(transform(just(1), [](int v) { return v + 1; }));
+    };
+    REQUIRE(asio_ext::op_state_size_v<decltype(make()), counting_receiver> == sizeof(void*));
+    sync_wait(make());
+    allocation_counter::scope allocations;
+    for (int i = 0; i < 10; ++i) {
+        REQUIRE(sync_wait(make()) == 2);
+    }
+    REQUIRE(allocations.allocations() == 0);
+}
+
+TEST_CASE("pooled: cancel is forwarded")
+{
+    asio::io_context ctx;
+    bool done = false;
+    auto op = asio::execution::connect(pooled(schedule_after(ctx.get_executor(), std::chrono::hours(1))),
+        asio_ext::value_channel([] {}) + asio_ext::done_channel([&] { done = true; }));
+    asio::execution::start(op);
+    op.cancel();
+    ctx.run();
+    REQUIRE(done);
+}
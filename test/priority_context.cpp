@@ -0,0 +1,95 @@
+#include <doctest/doctest.h>
+#include <asio_ext/make_receiver.hpp>
+#include <asio_ext/just.hpp>
+#include <asio_ext/on.hpp>
+#include <asio_ext/priority_context.hpp>
+#include <asio_ext/sync_wait.hpp>
+#include <asio_ext/transform.hpp>
+#include <asio_ext/via.hpp>
+
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace asio::execution;
+
+namespace
+{
+    template <class Scheduler>
+    auto append(Scheduler scheduler, std::string& order, std::string item) {
+        return asio::execution::connect(scheduler.schedule(), asio_ext::value_channel([&order, item] {
+            order += item;
+        }));
+    }
+}
+
+TEST_CASE("priority_context: lanes are served by weighted round-robin")
+{
+    asio_ext::priority_context ctx({ 2, 1 });
+    auto urgent = ctx.get_scheduler(0);
+    auto bulk = ctx.get_scheduler(1);
+    std::string order;
+    using op_type = decltype(append(urgent, order, ""));
+    std::vector<std::optional<op_type>> ops(8);
+    for (int i = 0; i < 4; ++i) {
+        asio::execution::start(ops[i].emplace(append(bulk, order, "a")));
+    }
+    for (int i = 4; i < 8; ++i) {
+        asio::execution::start(ops[i].emplace(append(urgent, order, "b")));
+    }
+    REQUIRE(ctx.poll() == 8);
+    REQUIRE(order == "bbabbaaa");
+}
+
+TEST_CASE("priority_context: schedule(priority) and with_priority pick the lane")
+{
+    asio_ext::priority_context ctx({ 1, 1, 1 });
+    auto scheduler = ctx.get_scheduler(2);
+    REQUIRE(scheduler.priority() == 2);
+    REQUIRE(scheduler.with_priority(1).priority() == 1);
+    REQUIRE(scheduler.with_priority(1) != scheduler);
+    REQUIRE_THROWS_AS(scheduler.schedule(3), std::out_of_range);
+    REQUIRE_THROWS_AS(ctx.get_scheduler(3), std::out_of_range);
+
+    std::string order;
+    auto low = append(scheduler, order, "2");
+    auto high = asio::execution::connect(scheduler.schedule(0), asio_ext::value_channel([&] {
+        order += "0";
+    }));
+    asio::execution::start(low);
+    asio::execution::start(high);
+    ctx.poll();
+    REQUIRE(order == "02");
+}
+
+TEST_CASE("priority_context: transform stages are pinned to a lane with on and via")
+{
+    asio_ext::priority_context ctx({ 4, 1 });
+    std::thread runner([&] {
+        ctx.run();
+    });
+    auto control = ctx.get_scheduler(0);
+    auto on_context = [&] {
+        return std::this_thread::get_id() == runner.get_id();
+    };
+    bool ran_via = sync_wait(transform(via(just(), control), on_context));
+    bool ran_on = sync_wait(on(control.with_priority(1), transform(just(), on_context)));
+    ctx.stop();
+    runner.join();
+    REQUIRE(ran_via);
+    REQUIRE(ran_on);
+}
+
+TEST_CASE("priority_context: queued operations complete with set_done on destruction")
+{
+    bool done = false;
+    std::optional<asio_ext::priority_context> ctx(std::in_place);
+    auto op = asio::execution::connect(ctx->get_scheduler(1).schedule(), asio_ext::done_channel([&] {
+        done = true;
+    }));
+    asio::execution::start(op);
+    ctx.reset();
+    REQUIRE(done);
+}
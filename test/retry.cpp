@@ -0,0 +1,149 @@
+#include <doctest/doctest.h>
+#include <asio/io_context.hpp>
+#include <asio_ext/just.hpp>
+#include <asio_ext/make_receiver.hpp>
+#include <asio_ext/retry.hpp>
+#include <asio_ext/transform.hpp>
+#include "allocation_counter.hpp"
+
+#include <chrono>
+#include <exception>
+
+using namespace asio::execution;
+
+namespace
+{
+    struct transient_error
+    {};
+
+    // Fails until it has been called succeed_on times
+    struct flaky_factory
+    {
+        int* calls;
+        int succeed_on;
+
+        auto operator()() const {
+            return transform(just(), [calls = calls, succeed_on = succeed_on]() {
+                if (++*calls < succeed_on) {
+                    throw transient_error{};
+                }
+                return *calls;
+            });
+        }
+    };
+
+    asio_ext::retry_policy fast_policy(std::size_t max_attempts) {
+        asio_ext::retry_policy policy;
+        policy.max_attempts = max_attempts;
+        policy.initial_delay = std::chrono::microseconds(100);
+        policy.max_delay = std::chrono::milliseconds(1);
+        return policy;
+    }
+} // namespace
+
+TEST_CASE("retry: retries until the attempt succeeds")
+{
+    asio::io_context ctx;
+    int calls = 0;
+    int result = 0;
+    auto op = asio::execution::connect(retry(ctx.get_executor(), flaky_factory{&calls, 3}, fast_policy(5)),
+        asio_ext::value_channel([&](int value) {
+            result = value;
+        }));
+    asio::execution::start(op);
+    ctx.run();
+    REQUIRE(calls == 3);
+    REQUIRE(result == 3);
+}
+
+TEST_CASE("retry: forwards the last error once attempts are exhausted")
+{
+    asio::io_context ctx;
+    int calls = 0;
+    bool failed = false;
+    auto op = asio::execution::connect(retry(ctx.get_executor(), flaky_factory{&calls, 100}, fast_policy(4)),
+        asio_ext::value_channel([](int) {}) + asio_ext::error_channel([&](std::exception_ptr e) {
+            failed = e != nullptr;
+        }));
+    asio::execution::start(op);
+    ctx.run();
+    REQUIRE(calls == 4);
+    REQUIRE(failed);
+}
+
+TEST_CASE("retry: backs off exponentially")
+{
+    asio::io_context ctx;
+    int calls = 0;
+    auto policy = fast_policy(4);
+    policy.initial_delay = std::chrono::milliseconds(2);
+    policy.max_delay = std::chrono::milliseconds(100);
+    policy.jitter = 0;
+    auto op = asio::execution::connect(retry(ctx.get_executor(), flaky_factory{&calls, 4}, policy),
+        asio_ext::value_channel([](int) {}));
+    auto start_time = std::chrono::steady_clock::now();
+    asio::execution::start(op);
+    ctx.run();
+    REQUIRE(calls == 4);
+    // 2 + 4 + 8 ms
+    REQUIRE(std::chrono::steady_clock::now() - start_time >= std::chrono::milliseconds(14));
+}
+
+TEST_CASE("retry: gives up when the next backoff exceeds max_elapsed")
+{
+    asio::io_context ctx;
+    int calls = 0;
+    bool failed = false;
+    auto policy = fast_policy(10);
+    policy.initial_delay = std::chrono::hours(1);
+    policy.max_delay = std::chrono::hours(1);
+    policy.jitter = 0;
+    policy.max_elapsed = std::chrono::minutes(1);
+    auto op = asio::execution::connect(retry(ctx.get_executor(), flaky_factory{&calls, 100}, policy),
+        asio_ext::value_channel([](int) {}) + asio_ext::error_channel([&](std::exception_ptr) {
+            failed = true;
+        }));
+    asio::execution::start(op);
+    ctx.run();
+    REQUIRE(calls == 1);
+    REQUIRE(failed);
+}
+
+TEST_CASE("retry: cancel during backoff completes with set_done")
+{
+    asio::io_context ctx;
+    int calls = 0;
+    bool done = false;
+    auto policy = fast_policy(10);
+    policy.initial_delay = std::chrono::hours(1);
+    auto op = asio::execution::connect(retry(ctx.get_executor(), flaky_factory{&calls, 100}, policy),
+        asio_ext::value_channel([](int) {}) + asio_ext::done_channel([&]() {
+            done = true;
+        }));
+    asio::execution::start(op);
+    op.cancel();
+    ctx.run();
+    REQUIRE(calls == 1);
+    REQUIRE(done);
+}
+
+TEST_CASE("retry: attempts do not allocate")
+{
+    asio::io_context ctx;
+    auto run_with_attempts = [&](int attempts) {
+        int calls = 0;
+        auto op = asio::execution::connect(
+            retry(ctx.get_executor(), flaky_factory{&calls, attempts}, fast_policy(attempts)),
+            asio_ext::value_channel([](int) {}));
+        allocation_counter::scope allocations;
+        asio::execution::start(op);
+        ctx.restart();
+        ctx.run();
+        return allocations.allocations();
+    };
+    // Warm up the timer service and asio's handler memory recycling
+    run_with_attempts(2);
+    auto two_attempts = run_with_attempts(2);
+    auto eight_attempts = run_with_attempts(8);
+    REQUIRE(two_attempts == eight_attempts);
+}
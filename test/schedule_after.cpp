@@ -0,0 +1,38 @@
+#include <doctest/doctest.h>
+#include <asio/io_context.hpp>
+#include <asio_ext/make_receiver.hpp>
+#include <asio_ext/schedule_after.hpp>
+
+#include <chrono>
+
+using namespace asio::execution;
+
+TEST_CASE("schedule_after: completes on the executor after the delay")
+{
+    asio::io_context ctx;
+    bool called = false;
+    auto start_time = std::chrono::steady_clock::now();
+    auto op = asio::execution::connect(schedule_after(ctx.get_executor(), std::chrono::milliseconds(5)),
+        asio_ext::value_channel([&]() {
+            called = true;
+        }));
+    asio::execution::start(op);
+    REQUIRE_FALSE(called);
+    ctx.run();
+    REQUIRE(called);
+    REQUIRE(std::chrono::steady_clock::now() - start_time >= std::chrono::milliseconds(5));
+}
+
+TEST_CASE("schedule_after: cancel completes with set_done")
+{
+    asio::io_context ctx;
+    bool done = false;
+    auto op = asio::execution::connect(schedule_after(ctx.get_executor(), std::chrono::hours(1)),
+        asio_ext::done_channel([&]() {
+            done = true;
+        }));
+    asio::execution::start(op);
+    op.cancel();
+    ctx.run();
+    REQUIRE(done);
+}
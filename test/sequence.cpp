@@ -3,6 +3,12 @@
 #include <asio_ext/sequence.hpp>
 #include <asio_ext/sync_wait.hpp>
 #include <asio_ext/transform.hpp>
+#include "test_receiver.hpp"
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <utility>
 
 using namespace asio::execution;
 
@@ -28,4 +34,59 @@ TEST_CASE("More sequence senders test")
         lazy([&] { result += "2"; })
     ));
     REQUIRE(result == "12");
-}
\ No newline at end of file
+}
+
+namespace
+{
+    struct step
+    {
+        int* counter;
+        void operator()() const {
+            ++*counter;
+        }
+    };
+
+    template <class Sender, std::size_t... Is>
+    auto repeat(const Sender& sender, std::index_sequence<Is...>) {
+        return sequence(((void)Is, sender)...);
+    }
+}
+
+TEST_CASE("sequence: steps run in order and the last one's values are forwarded")
+{
+    std::string result;
+    int value = sync_wait(sequence(
+        lazy([&] { result += "1"; }),
+        lazy([&] { result += "2"; }),
+        lazy([&] { result += "3"; return 42; })
+    ));
+    REQUIRE(result == "123");
+    REQUIRE(value == 42);
+}
+
+TEST_CASE("sequence: an error skips the remaining steps")
+{
+    std::string result;
+    REQUIRE_THROWS_AS(sync_wait(sequence(
+        lazy([&] { result += "1"; }),
+        lazy([&]() { throw std::runtime_error("failed"); }),
+        lazy([&] { result += "3"; })
+    )), std::runtime_error);
+    REQUIRE(result == "1");
+}
+
+TEST_CASE("sequence: operation state overhead does not grow with the step count")
+{
+    int counter = 0;
+    auto one = lazy(step{ &counter });
+    auto three = repeat(one, std::make_index_sequence<3>{});
+    auto thirty = repeat(one, std::make_index_sequence<30>{});
+    sync_wait(std::move(thirty));
+    REQUIRE(counter == 30);
+
+    constexpr auto overhead3 =
+        asio_ext::op_state_size_v<decltype(three), counting_receiver> - sizeof(decltype(three));
+    constexpr auto overhead30 =
+        asio_ext::op_state_size_v<decltype(thirty), counting_receiver> - sizeof(decltype(thirty));
+    REQUIRE(overhead3 == overhead30);
+}
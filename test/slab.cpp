@@ -0,0 +1,46 @@
+#include <doctest/doctest.h>
+#include <asio_ext/slab.hpp>
+
+#include <cstring>
+#include <new>
+#include <vector>
+
+TEST_CASE("slab: copies share the chunk and return it once released")
+{
+    asio_ext::buffer_slab slab(64, 2);
+    {
+        auto first = slab.allocate();
+        REQUIRE(first.size() == 64);
+        REQUIRE(slab.available() == 1);
+
+        auto copy = first;
+        REQUIRE(copy.data() == first.data());
+        REQUIRE(first.use_count() == 2);
+
+        std::vector<asio_ext::slab_buffer> pipeline;
+        pipeline.push_back(std::move(copy));
+        REQUIRE(first.use_count() == 2);
+        REQUIRE(slab.available() == 1);
+    }
+    REQUIRE(slab.available() == 2);
+}
+
+TEST_CASE("slab: exhausted slab throws bad_alloc")
+{
+    asio_ext::buffer_slab slab(16, 1);
+    auto buffer = slab.allocate();
+    REQUIRE_THROWS_AS(slab.allocate(), std::bad_alloc);
+}
+
+TEST_CASE("slab: handles form buffer sequences")
+{
+    asio_ext::buffer_slab slab(8, 2);
+    auto a = slab.allocate();
+    auto b = slab.allocate();
+    std::memcpy(a.data(), "abc", 3);
+    a.resize(3);
+    b.resize(5);
+    std::vector<asio_ext::slab_buffer> gather{a, b};
+    REQUIRE(asio::buffer_size(a) == 3);
+    REQUIRE(asio::buffer_size(gather) == 8);
+}
@@ -0,0 +1,104 @@
+#include <doctest/doctest.h>
+#include <asio/executor_work_guard.hpp>
+#include <asio/io_context.hpp>
+#include <asio_ext/just.hpp>
+#include <asio_ext/make_receiver.hpp>
+#include <asio_ext/schedule_after.hpp>
+#include <asio_ext/split.hpp>
+#include <asio_ext/sync_wait.hpp>
+#include <asio_ext/transform.hpp>
+#include "allocation_counter.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace asio::execution;
+
+TEST_CASE("split: upstream runs once for every consumer")
+{
+    int runs = 0;
+    auto shared = split(transform(just(), [&]() {
+        ++runs;
+        return std::string("result");
+    }));
+    std::string first = sync_wait(shared);
+    std::string second = sync_wait(shared);
+    REQUIRE(runs == 1);
+    REQUIRE(first == "result");
+    REQUIRE(second == "result");
+}
+
+TEST_CASE("split: consumers attached before completion are completed in order")
+{
+    asio::io_context ctx;
+    int runs = 0;
+    auto shared = split(transform(schedule_after(ctx.get_executor(), std::chrono::milliseconds(1)), [&]() {
+        return ++runs;
+    }));
+    std::vector<int> order;
+    auto op1 = asio::execution::connect(shared, asio_ext::value_channel([&](int v) { order.push_back(v * 10 + 1); }));
+    auto op2 = asio::execution::connect(shared, asio_ext::value_channel([&](int v) { order.push_back(v * 10 + 2); }));
+    auto op3 = asio::execution::connect(shared, asio_ext::value_channel([&](int v) { order.push_back(v * 10 + 3); }));
+    asio::execution::start(op1);
+    asio::execution::start(op2);
+    asio::execution::start(op3);
+    REQUIRE(order.empty());
+    ctx.run();
+    REQUIRE(runs == 1);
+    REQUIRE(order == std::vector<int>{11, 12, 13});
+}
+
+TEST_CASE("split: errors are shared")
+{
+    auto shared = split(transform(just(), []() -> int {
+        throw std::runtime_error("failed");
+    }));
+    REQUIRE_THROWS_AS(sync_wait(shared), std::runtime_error);
+    REQUIRE_THROWS_AS(sync_wait(shared), std::runtime_error);
+}
+
+TEST_CASE("split: allocates one shared block")
+{
+    allocation_counter::scope allocations;
+    {
+        auto shared = split(just(1));
+        sync_wait(shared);
+        sync_wait(shared);
+    }
+    auto allocated = allocations.allocations();
+    auto deallocated = allocations.deallocations();
+    REQUIRE(allocated == 1);
+    REQUIRE(deallocated == 1);
+}
+
+TEST_CASE("split: consumers attaching concurrently with completion all complete")
+{
+    for (int round = 0; round < 50; ++round) {
+        asio::io_context ctx;
+        auto shared = split(transform(schedule_after(ctx.get_executor(), std::chrono::microseconds(50)), []() {
+            return 7;
+        }));
+        std::atomic_int completed{ 0 };
+        auto work = asio::make_work_guard(ctx);
+        std::thread runner([&] {
+            ctx.run();
+        });
+        std::vector<std::thread> consumers;
+        for (int i = 0; i < 4; ++i) {
+            consumers.emplace_back([&] {
+                completed += sync_wait(shared);
+            });
+        }
+        for (auto& consumer : consumers) {
+            consumer.join();
+        }
+        work.reset();
+        runner.join();
+        REQUIRE(completed.load() == 28);
+    }
+}
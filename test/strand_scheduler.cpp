@@ -0,0 +1,110 @@
+#include <doctest/doctest.h>
+#include <asio/io_context.hpp>
+#include <asio/thread_pool.hpp>
+#include <asio_ext/make_receiver.hpp>
+#include <asio_ext/strand_scheduler.hpp>
+#include <asio_ext/sync_wait.hpp>
+#include <asio_ext/transform.hpp>
+
+#include <atomic>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace asio::execution;
+
+TEST_CASE("strand_scheduler: completes inline when the strand is idle")
+{
+    asio::io_context ctx;
+    asio_ext::strand strand(ctx.get_executor());
+    auto scheduler = strand.get_scheduler();
+    std::thread::id ran_on;
+    sync_wait(transform(scheduler.schedule(), [&] {
+        ran_on = std::this_thread::get_id();
+    }));
+    REQUIRE(ran_on == std::this_thread::get_id());
+    REQUIRE(ctx.run() == 0);
+
+    int value = sync_wait(transform(scheduler.schedule(), [] { return 42; }));
+    REQUIRE(value == 42);
+}
+
+TEST_CASE("strand_scheduler: operations started while busy run in order in batches")
+{
+    asio::io_context ctx;
+    asio_ext::strand strand(ctx.get_executor(), 2);
+    auto scheduler = strand.get_scheduler();
+    std::string order;
+    auto make_op = [&](char c) {
+        return asio::execution::connect(scheduler.schedule(), asio_ext::value_channel([&order, c] {
+            order += c;
+        }));
+    };
+    using op_type = decltype(make_op('a'));
+    std::vector<std::optional<op_type>> queued(5);
+
+    auto first = asio::execution::connect(scheduler.schedule(), asio_ext::value_channel([&] {
+        order += '0';
+        for (std::size_t i = 0; i < queued.size(); ++i) {
+            asio::execution::start(queued[i].emplace(make_op(static_cast<char>('1' + i))));
+        }
+    }));
+    asio::execution::start(first);
+    REQUIRE(order == "0");
+    // Five queued operations drained two at a time
+    REQUIRE(ctx.run() == 3);
+    REQUIRE(order == "012345");
+}
+
+TEST_CASE("strand_scheduler: operations from many threads never overlap")
+{
+    asio::thread_pool pool(4);
+    asio_ext::strand strand(pool.get_executor());
+    auto scheduler = strand.get_scheduler();
+    std::atomic_int inside{ 0 };
+    std::atomic_bool overlapped{ false };
+    int counter = 0;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 2000; ++i) {
+                sync_wait(transform(scheduler.schedule(), [&] {
+                    if (inside.fetch_add(1) != 0) {
+                        overlapped = true;
+                    }
+                    ++counter;
+                    inside.fetch_sub(1);
+                }));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    pool.join();
+    REQUIRE(!overlapped);
+    REQUIRE(counter == 8000);
+}
+
+TEST_CASE("strand_scheduler: queued operations complete with set_done if the scheduler drops the drain")
+{
+    int done = 0;
+    std::optional<asio::io_context> ctx(std::in_place);
+    asio_ext::strand strand(ctx->get_executor());
+    auto scheduler = strand.get_scheduler();
+    auto make_op = [&] {
+        return asio::execution::connect(scheduler.schedule(), asio_ext::done_channel([&] {
+            ++done;
+        }));
+    };
+    std::optional<decltype(make_op())> second;
+    auto first = asio::execution::connect(scheduler.schedule(), asio_ext::value_channel([&] {
+        asio::execution::start(second.emplace(make_op()));
+    }));
+    asio::execution::start(first);
+    REQUIRE(done == 0);
+    ctx.reset();
+    REQUIRE(done == 1);
+}
@@ -1,8 +1,16 @@
 #include <doctest/doctest.h>
 #include <asio_ext/sync_wait.hpp>
 #include <asio_ext/just.hpp>
+#include <asio_ext/when_any.hpp>
+#include "allocation_counter.hpp"
+
+#include <optional>
+#include <string>
+#include <tuple>
+#include <variant>
 
 using namespace asio::execution;
+
 TEST_CASE("sync_wait: compile-test just()")
 {
     sync_wait(just());
@@ -12,4 +20,55 @@ TEST_CASE("sync_wait: just(5) == 5")
 {
     int test = sync_wait(just(5));
     REQUIRE(test == 5);
-}
\ No newline at end of file
+}
+
+TEST_CASE("sync_wait: does not allocate")
+{
+    allocation_counter::scope allocations;
+    int test = sync_wait(just(5));
+    auto count = allocations.allocations();
+    REQUIRE(test == 5);
+    REQUIRE(count == 0);
+}
+
+TEST_CASE("sync_wait: several values complete with a tuple")
+{
+    auto result = sync_wait(just(1, std::string("two")));
+    REQUIRE(result.has_value());
+    REQUIRE(std::get<0>(*result) == 1);
+    REQUIRE(std::get<1>(*result) == "two");
+}
+
+TEST_CASE("sync_wait: result buffer is reused across calls")
+{
+    std::optional<std::tuple<int, std::string>> buffer;
+    std::string long_text(100, 'x');
+    sync_wait(just(1, long_text), buffer);
+    REQUIRE(std::get<1>(*buffer) == long_text);
+    auto& same = sync_wait(just(2, std::string("short")), buffer);
+    REQUIRE(&same == &buffer);
+    REQUIRE(std::get<0>(*buffer) == 2);
+    REQUIRE(std::get<1>(*buffer) == "short");
+}
+
+TEST_CASE("sync_wait: several values do not allocate")
+{
+    std::optional<std::tuple<int, double>> buffer;
+    allocation_counter::scope allocations;
+    auto result = sync_wait(just(1, 2.5));
+    sync_wait(just(3, 4.5), buffer);
+    REQUIRE(allocations.allocations() == 0);
+    REQUIRE(std::get<1>(*result) == 2.5);
+    REQUIRE(std::get<0>(*buffer) == 3);
+}
+
+TEST_CASE("sync_wait_with_variant: completes with the signature that was sent")
+{
+    auto result = sync_wait_with_variant(when_any(just(1), just(std::string("text"))));
+    REQUIRE(result.has_value());
+    REQUIRE(std::get<0>(std::get<std::tuple<int>>(*result)) == 1);
+
+    std::optional<std::variant<std::tuple<int>>> buffer;
+    sync_wait_with_variant(just(5), buffer);
+    REQUIRE(std::get<0>(std::get<0>(*buffer)) == 5);
+}
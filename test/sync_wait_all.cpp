@@ -0,0 +1,115 @@
+#include <doctest/doctest.h>
+#include <asio/executor_work_guard.hpp>
+#include <asio/io_context.hpp>
+#include <asio_ext/just.hpp>
+#include <asio_ext/schedule_after.hpp>
+#include <asio_ext/sync_wait_all.hpp>
+#include <asio_ext/then_chain.hpp>
+#include <asio_ext/transform.hpp>
+#include "allocation_counter.hpp"
+#include "throwing_connect.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace asio::execution;
+
+TEST_CASE("sync_wait_all: results are returned in range order")
+{
+    std::vector<decltype(just(0))> senders;
+    for (int i = 0; i < 100; ++i) {
+        senders.push_back(just(int(i)));
+    }
+    auto results = sync_wait_all(senders, 8);
+    REQUIRE(results.size() == 100);
+    for (int i = 0; i < 100; ++i) {
+        REQUIRE(results[i].has_value());
+        REQUIRE(*results[i] == i);
+    }
+}
+
+TEST_CASE("sync_wait_all: at most max_concurrency operations are in flight")
+{
+    asio::io_context ctx;
+    auto work = asio::make_work_guard(ctx);
+    std::thread runner([&] {
+        ctx.run();
+    });
+    std::atomic_int in_flight{ 0 };
+    int most = 0;
+    auto make = [&](int i) {
+        return transform(then_chain(just(), [&]() {
+            most = std::max(most, ++in_flight);
+            return schedule_after(ctx.get_executor(), std::chrono::microseconds(100));
+        }), [&, i]() {
+            --in_flight;
+            return i * 2;
+        });
+    };
+    std::vector<decltype(make(0))> senders;
+    for (int i = 0; i < 40; ++i) {
+        senders.push_back(make(i));
+    }
+    auto results = sync_wait_all(senders, 4);
+    work.reset();
+    runner.join();
+    REQUIRE(most <= 4);
+    REQUIRE(most >= 1);
+    for (int i = 0; i < 40; ++i) {
+        REQUIRE(*results[i] == i * 2);
+    }
+}
+
+TEST_CASE("sync_wait_all: the first error is rethrown and stops launching")
+{
+    int started = 0;
+    auto make = [&](int i) {
+        return transform(just(i), [&](int v) {
+            ++started;
+            if (v == 3) {
+                throw std::runtime_error("failed");
+            }
+            return v;
+        });
+    };
+    std::vector<decltype(make(0))> senders;
+    for (int i = 0; i < 10; ++i) {
+        senders.push_back(make(i));
+    }
+    REQUIRE_THROWS_AS(sync_wait_all(senders, 2), std::runtime_error);
+    REQUIRE(started < 10);
+}
+
+TEST_CASE("sync_wait_all: allocates the results and the slot array only")
+{
+    std::vector<decltype(just(0))> senders(50, just(1));
+    allocation_counter::scope allocations;
+    auto results = sync_wait_all(senders, 16);
+    REQUIRE(allocations.allocations() == 2);
+    REQUIRE(std::all_of(results.begin(), results.end(), [](const auto& r) { return *r == 1; }));
+}
+
+TEST_CASE("sync_wait_all: senders of an lvalue range are copied, not moved from")
+{
+    std::vector<decltype(just(std::string()))> senders(4, just(std::string("value")));
+    auto first = sync_wait_all(senders, 2);
+    auto second = sync_wait_all(senders, 2);
+    REQUIRE(std::all_of(first.begin(), first.end(), [](const auto& r) { return *r == "value"; }));
+    REQUIRE(std::all_of(second.begin(), second.end(), [](const auto& r) { return *r == "value"; }));
+
+    auto moved = sync_wait_all(std::move(senders), 2);
+    REQUIRE(std::all_of(moved.begin(), moved.end(), [](const auto& r) { return *r == "value"; }));
+}
+
+TEST_CASE("sync_wait_all: a failing connect stops the initial launch")
+{
+    int connects = 0;
+    std::vector<throwing_connect> senders(5, throwing_connect{ &connects });
+    REQUIRE_THROWS_AS(sync_wait_all(senders, 4), std::runtime_error);
+    REQUIRE(connects == 1);
+}
@@ -0,0 +1,87 @@
+#include <doctest/doctest.h>
+#include <asio/io_context.hpp>
+#include <asio_ext/just.hpp>
+#include <asio_ext/make_receiver.hpp>
+#include <asio_ext/schedule_after.hpp>
+#include <asio_ext/sync_wait.hpp>
+#include <asio_ext/then_chain.hpp>
+#include <asio_ext/transform.hpp>
+#include "allocation_counter.hpp"
+
+#include <chrono>
+#include <stdexcept>
+#include <string>
+
+using namespace asio::execution;
+
+namespace
+{
+    struct session
+    {
+        int id;
+        int token;
+    };
+
+    struct handshake
+    {
+        auto operator()(int& id) const {
+            return just(session{ id, 0 });
+        }
+    };
+
+    struct authenticate
+    {
+        auto operator()(session& s) const {
+            return just(session{ s.id, s.id * 10 });
+        }
+    };
+
+    struct request
+    {
+        auto operator()(session& s) const {
+            return just(s.id + s.token);
+        }
+    };
+}
+
+TEST_CASE("then_chain: values are handed from stage to stage")
+{
+    std::string text = sync_wait(then_chain(just(1, 2),
+        [](int& a, int& b) { return just(a + b); },
+        [](int& sum) { return just(std::to_string(sum)); },
+        [](std::string& s) { return just(s + "!"); }));
+    REQUIRE(text == "3!");
+}
+
+TEST_CASE("then_chain: stored values outlive the stage they were passed to")
+{
+    asio::io_context ctx;
+    std::size_t length = 0;
+    auto op = asio::execution::connect(then_chain(just(std::string("payload")),
+        [&](std::string& s) {
+            // Reads the stored value after an asynchronous wait
+            return transform(schedule_after(ctx.get_executor(), std::chrono::milliseconds(1)), [&s]() {
+                return s.size();
+            });
+        }), asio_ext::value_channel([&](std::size_t n) { length = n; }));
+    asio::execution::start(op);
+    ctx.run();
+    REQUIRE(length == 7);
+}
+
+TEST_CASE("then_chain: an error skips the remaining stages")
+{
+    bool reached = false;
+    REQUIRE_THROWS_AS(sync_wait(then_chain(just(1),
+        [](int&) { return transform(just(), []() -> int { throw std::runtime_error("failed"); }); },
+        [&](int& v) { reached = true; return just(v); })), std::runtime_error);
+    REQUIRE(!reached);
+}
+
+TEST_CASE("then_chain: multi step protocol does not allocate")
+{
+    allocation_counter::scope allocations;
+    int result = sync_wait(then_chain(just(4), handshake{}, authenticate{}, request{}));
+    REQUIRE(result == 44);
+    REQUIRE(allocations.allocations() == 0);
+}
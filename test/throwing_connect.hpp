@@ -0,0 +1,32 @@
+#pragma once
+
+#include <exception>
+#include <stdexcept>
+
+#include <asio/execution/connect.hpp>
+#include <asio_ext/just.hpp>
+#include <asio_ext/type_traits.hpp>
+
+// Sender of an int whose connect throws std::runtime_error, counting the attempts
+// when given a counter.
+struct throwing_connect
+{
+    template <template <class...> class Tuple, template <class...> class Variant>
+    using value_types = Variant<Tuple<int>>;
+
+    template <template <class...> class Variant>
+    using error_types = Variant<std::exception_ptr>;
+
+    static constexpr bool sends_done = false;
+
+    int* connects_ = nullptr;
+
+    template <class Receiver>
+    asio::execution::connect_result_t<decltype(asio::execution::just(0)), asio_ext::remove_cvref_t<Receiver>> connect(
+        Receiver&&) {
+        if (connects_) {
+            ++*connects_;
+        }
+        throw std::runtime_error("connect failed");
+    }
+};
@@ -0,0 +1,77 @@
+#include <doctest/doctest.h>
+#include <asio_ext/just.hpp>
+#include <asio_ext/sync_wait.hpp>
+#include <asio_ext/traced.hpp>
+#include <asio_ext/transform.hpp>
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+using namespace asio::execution;
+
+#if defined(ASIO_EXT_ENABLE_TRACING)
+
+using asio_ext::tracing::event_type;
+using asio_ext::tracing::ring_buffer_tracer;
+
+namespace
+{
+    std::vector<event_type> events_for(const std::string& name) {
+        std::vector<event_type> events;
+        ring_buffer_tracer::for_each_event([&](std::uint32_t, const asio_ext::tracing::event& e) {
+            if (name == e.name) {
+                events.push_back(e.type);
+            }
+        });
+        return events;
+    }
+} // namespace
+
+TEST_CASE("traced: records connect, start and set_value") {
+    ring_buffer_tracer::clear();
+    auto sender = traced(transform(traced(just(20), "just"), [](int x) { return x + 1; }), "transform");
+    auto result = sync_wait(std::move(sender));
+    REQUIRE(result == 21);
+
+    auto expected = std::vector<event_type>{event_type::connect, event_type::start, event_type::set_value};
+    REQUIRE(events_for("just") == expected);
+    REQUIRE(events_for("transform") == expected);
+}
+
+TEST_CASE("traced: records set_error") {
+    ring_buffer_tracer::clear();
+    auto sender = traced(transform(just(), []() -> int { throw std::runtime_error("boom"); }), "failing");
+    REQUIRE_THROWS_AS(sync_wait(std::move(sender)), std::runtime_error);
+    auto expected = std::vector<event_type>{event_type::connect, event_type::start, event_type::set_error};
+    REQUIRE(events_for("failing") == expected);
+}
+
+TEST_CASE("traced: events from other threads are exported as chrome trace") {
+    ring_buffer_tracer::clear();
+    std::thread worker([] { sync_wait(traced(just(), "worker \"stage\"")); });
+    worker.join();
+    sync_wait(traced(just(), "main"));
+
+    std::ostringstream os;
+    asio_ext::tracing::write_chrome_trace(os);
+    auto json = os.str();
+    REQUIRE(json.find("{\"traceEvents\":[") == 0);
+    REQUIRE(json.find("\"name\":\"worker \\\"stage\\\"\"") != std::string::npos);
+    REQUIRE(json.find("\"name\":\"main\"") != std::string::npos);
+    REQUIRE(json.find("\"ph\":\"b\"") != std::string::npos);
+    REQUIRE(json.find("\"signal\":\"set_value\"") != std::string::npos);
+}
+
+#else
+
+TEST_CASE("traced: returns the sender untouched when tracing is disabled") {
+    auto sender = traced(just(20), "just");
+    static_assert(std::is_same_v<decltype(sender), decltype(just(20))>);
+    REQUIRE(sync_wait(std::move(sender)) == 20);
+}
+
+#endif // defined(ASIO_EXT_ENABLE_TRACING)
@@ -2,6 +2,8 @@
 #include <asio_ext/just.hpp>
 #include <asio_ext/sync_wait.hpp>
 #include <asio_ext/transform.hpp>
+#include <asio_ext/sender_traits.hpp>
+#include "allocation_counter.hpp"
 #include "test_receiver.hpp"
 #include <iostream>
 
@@ -14,4 +16,31 @@ TEST_CASE("transform: basic transform") {
     );
     sync_wait(sender);
     REQUIRE(count == 1);
-}
\ No newline at end of file
+}
+
+namespace
+{
+    struct add_one
+    {
+        int operator()(int x) const {
+            return x + 1;
+        }
+    };
+} // namespace
+
+TEST_CASE("transform: adds only its receiver to the operation state")
+{
+    using transform_receiver = asio_ext::transform::detail::receiver<add_one, counting_receiver>;
+    using just_sender = asio_ext::just::detail::sender<int>;
+    static_assert(asio_ext::op_state_size_v<asio_ext::transform::detail::sender<just_sender, add_one>, counting_receiver> ==
+        asio_ext::op_state_size_v<just_sender, transform_receiver>);
+}
+
+TEST_CASE("transform: does not allocate")
+{
+    allocation_counter::scope allocations;
+    int result = sync_wait(transform(just(1), add_one{}));
+    auto count = allocations.allocations();
+    REQUIRE(result == 2);
+    REQUIRE(count == 0);
+}
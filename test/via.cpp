@@ -0,0 +1,33 @@
+#include <doctest/doctest.h>
+#include <asio/thread_pool.hpp>
+#include <asio_ext/just.hpp>
+#include <asio_ext/sync_wait.hpp>
+#include <asio_ext/transform.hpp>
+#include <asio_ext/via.hpp>
+
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+
+using namespace asio::execution;
+
+TEST_CASE("via: completes with the values on the scheduler")
+{
+    asio::thread_pool pool(1);
+    auto result = sync_wait(transform(via(just(4, std::string("four")), pool.get_executor()),
+        [](int number, std::string text) {
+            return std::make_tuple(number, text, std::this_thread::get_id());
+        }));
+    REQUIRE(std::get<0>(result) == 4);
+    REQUIRE(std::get<1>(result) == "four");
+    REQUIRE(std::get<2>(result) != std::this_thread::get_id());
+}
+
+TEST_CASE("via: errors are forwarded")
+{
+    asio::thread_pool pool(1);
+    REQUIRE_THROWS_AS(sync_wait(via(transform(just(), []() -> int {
+        throw std::runtime_error("failed");
+    }), pool.get_executor())), std::runtime_error);
+}
@@ -3,6 +3,11 @@
 #include <asio_ext/sync_wait.hpp>
 #include <asio_ext/transform.hpp>
 #include <asio_ext/when_all.hpp>
+#include <asio_ext/sender_traits.hpp>
+#include "allocation_counter.hpp"
+#include "test_receiver.hpp"
+
+#include <memory>
 
 using namespace asio::execution;
 
@@ -29,4 +34,26 @@ TEST_CASE("mutiple eveents when_all test")
     ));
     REQUIRE(done1 == true);
     REQUIRE(done2 == true);
-}
\ No newline at end of file
+}
+
+TEST_CASE("when_all: allocates one shared state")
+{
+    allocation_counter::scope allocations;
+    sync_wait(when_all(just(), just()));
+    auto allocated = allocations.allocations();
+    auto deallocated = allocations.deallocations();
+    REQUIRE(allocated == 1);
+    REQUIRE(deallocated == 1);
+}
+
+TEST_CASE("when_all: operation state holds the senders and the shared state pointer")
+{
+    using just_sender = asio_ext::just::detail::sender<>;
+    struct expected_layout
+    {
+        asio_ext::sender_storage_t<just_sender, just_sender> senders;
+        std::shared_ptr<int> state;
+    };
+    static_assert(asio_ext::op_state_size_v<asio_ext::when_all::detail::when_all_op<just_sender, just_sender>, counting_receiver> ==
+        sizeof(expected_layout));
+}